@@ -0,0 +1,489 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// Mock IGCL driver: an in-memory set of adapters with the 3D features the
+// plugins touch, so they can run without an Intel GPU. Latency, adapter count
+// and failures are configurable, see ControlLibMock.h.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "igcl_api.h"
+#include "ControlLibMock.h"
+
+namespace {
+
+    struct MockFeature {
+        ctl_3d_feature_t type;
+        ctl_property_value_type_t valueType;
+        ctl_property_info_t info;
+        int32_t customValueSize;
+        bool perAppSupport;
+    };
+
+    struct MockDevice {
+        bool present = true; // removed adapters keep their handle, which then reports the device lost
+        uint64_t luid = 0;   // device id, kept across a driver update
+        ctl_property_t values[CTL_3D_FEATURE_MAX] = {};
+        ctl_endurance_gaming_t enduranceGaming = {CTL_3D_ENDURANCE_GAMING_CONTROL_TURN_OFF, CTL_3D_ENDURANCE_GAMING_MODE_BALANCED};
+    };
+
+    struct MockDriver {
+        std::mutex mutex;
+        int openHandles = 0;
+        std::vector<std::unique_ptr<MockDevice>> devices;
+        uint64_t nextLuid = 0x1000;
+
+        bool configured = false;
+        ctl_mock_config_t config = {};
+        std::mt19937 random;
+        std::atomic<uint64_t> calls[CTL_MOCK_ENTRY_MAX] = {};
+    };
+
+    const char* const kEntryNames[CTL_MOCK_ENTRY_MAX] = {
+        "ctlInit",
+        "ctlClose",
+        "ctlEnumerateDevices",
+        "ctlGetSupported3DCapabilities",
+        "ctlGetSet3DFeature",
+        "ctlGetDeviceProperties",
+    };
+
+    const uint64_t kFlipModes = CTL_GAMING_FLIP_MODE_FLAG_APPLICATION_DEFAULT | CTL_GAMING_FLIP_MODE_FLAG_VSYNC_OFF |
+                                CTL_GAMING_FLIP_MODE_FLAG_VSYNC_ON | CTL_GAMING_FLIP_MODE_FLAG_SMOOTH_SYNC |
+                                CTL_GAMING_FLIP_MODE_FLAG_CAPPED_FPS;
+    const uint64_t kAnisotropicModes = (1ull << CTL_3D_ANISOTROPIC_TYPES_APP_CHOICE) | (1ull << CTL_3D_ANISOTROPIC_TYPES_2X) |
+                                       (1ull << CTL_3D_ANISOTROPIC_TYPES_4X) | (1ull << CTL_3D_ANISOTROPIC_TYPES_8X) |
+                                       (1ull << CTL_3D_ANISOTROPIC_TYPES_16X);
+
+    const MockFeature* FindFeature(ctl_3d_feature_t type) {
+        static const MockFeature features[] = {
+            {CTL_3D_FEATURE_GAMING_FLIP_MODES, CTL_PROPERTY_VALUE_TYPE_ENUM, {.EnumType = {kFlipModes, CTL_GAMING_FLIP_MODE_FLAG_APPLICATION_DEFAULT}}, 0, true},
+            {CTL_3D_FEATURE_ANISOTROPIC, CTL_PROPERTY_VALUE_TYPE_ENUM, {.EnumType = {kAnisotropicModes, CTL_3D_ANISOTROPIC_TYPES_APP_CHOICE}}, 0, true},
+            {CTL_3D_FEATURE_FRAME_LIMIT, CTL_PROPERTY_VALUE_TYPE_INT32, {.IntType = {false, 0, 300, 0}}, 0, true},
+            {CTL_3D_FEATURE_ENDURANCE_GAMING, CTL_PROPERTY_VALUE_TYPE_CUSTOM, {}, sizeof(ctl_endurance_gaming_t), true},
+            {CTL_3D_FEATURE_ADAPTIVE_TESSELLATION, CTL_PROPERTY_VALUE_TYPE_BOOL, {.BoolType = {false}}, 0, false},
+            {CTL_3D_FEATURE_SHARPENING_FILTER, CTL_PROPERTY_VALUE_TYPE_BOOL, {.BoolType = {false}}, 0, false},
+        };
+        for (const auto& feature : features) {
+            if (feature.type == type) return &feature;
+        }
+        return nullptr;
+    }
+
+    const ctl_3d_feature_t kSupportedFeatures[] = {
+        CTL_3D_FEATURE_GAMING_FLIP_MODES,
+        CTL_3D_FEATURE_ANISOTROPIC,
+        CTL_3D_FEATURE_FRAME_LIMIT,
+        CTL_3D_FEATURE_ENDURANCE_GAMING,
+        CTL_3D_FEATURE_ADAPTIVE_TESSELLATION,
+        CTL_3D_FEATURE_SHARPENING_FILTER,
+    };
+    const uint32_t kSupportedFeatureCount = sizeof(kSupportedFeatures) / sizeof(kSupportedFeatures[0]);
+
+    void ResetToDefaults(MockDevice& device) {
+        for (ctl_3d_feature_t type : kSupportedFeatures) {
+            const MockFeature* feature = FindFeature(type);
+            ctl_property_t& value = device.values[type];
+            switch (feature->valueType) {
+                case CTL_PROPERTY_VALUE_TYPE_ENUM: value.EnumType.EnableType = feature->info.EnumType.DefaultType; break;
+                case CTL_PROPERTY_VALUE_TYPE_INT32: value.IntType = {feature->info.IntType.DefaultEnable, feature->info.IntType.DefaultValue}; break;
+                case CTL_PROPERTY_VALUE_TYPE_BOOL: value.BoolType.Enable = feature->info.BoolType.DefaultState; break;
+                default: break;
+            }
+        }
+    }
+
+    MockDriver& Driver() {
+        static MockDriver driver;
+        return driver;
+    }
+
+    // the api handle only has to be non null and recognizable
+    struct _ctl_api_handle_t* const kApiHandle = reinterpret_cast<struct _ctl_api_handle_t*>(&Driver);
+
+    // Resolves an adapter handle, result is CTL_RESULT_ERROR_DEVICE_LOST for a removed adapter
+    MockDevice* ToDevice(ctl_device_adapter_handle_t handle, ctl_result_t& result) {
+        auto& driver = Driver();
+        for (const auto& device : driver.devices) {
+            if (reinterpret_cast<ctl_device_adapter_handle_t>(device.get()) == handle) {
+                result = device->present ? CTL_RESULT_SUCCESS : CTL_RESULT_ERROR_DEVICE_LOST;
+                return device->present ? device.get() : nullptr;
+            }
+        }
+        result = CTL_RESULT_ERROR_INVALID_NULL_HANDLE;
+        return nullptr;
+    }
+
+    int FindEntry(const std::string& name) {
+        for (int i = 0; i < CTL_MOCK_ENTRY_MAX; i++) {
+            if (name == kEntryNames[i]) return i;
+        }
+        return -1;
+    }
+
+    // Parses "value" (applied to every entry point) or "entry:value,entry:value"
+    template <typename T, typename Parse>
+    void ParsePerEntry(const char* text, T (&values)[CTL_MOCK_ENTRY_MAX], Parse parse) {
+        std::string spec(text);
+        if (spec.find(':') == std::string::npos) {
+            T value = parse(spec);
+            for (auto& v : values) v = value;
+            return;
+        }
+        size_t start = 0;
+        while (start < spec.size()) {
+            size_t end = spec.find(',', start);
+            if (end == std::string::npos) end = spec.size();
+            std::string item = spec.substr(start, end - start);
+            size_t colon = item.find(':');
+            if (colon != std::string::npos) {
+                int entry = FindEntry(item.substr(0, colon));
+                if (entry >= 0) values[entry] = parse(item.substr(colon + 1));
+            }
+            start = end + 1;
+        }
+    }
+
+    ctl_result_t ParseResult(const std::string& text) {
+        if (text == "device_lost") return CTL_RESULT_ERROR_DEVICE_LOST;
+        if (text == "not_initialized") return CTL_RESULT_ERROR_NOT_INITIALIZED;
+        if (text == "unknown" || text.empty()) return CTL_RESULT_ERROR_UNKNOWN;
+        return static_cast<ctl_result_t>(std::strtoul(text.c_str(), nullptr, 0));
+    }
+
+    void ApplyDeviceCountLocked(MockDriver& driver) {
+        uint32_t present = 0;
+        for (auto& device : driver.devices) {
+            if (!device->present) continue;
+            if (present < driver.config.DeviceCount) {
+                present++;
+            } else {
+                device->present = false;
+            }
+        }
+        while (present < driver.config.DeviceCount) {
+            driver.devices.push_back(std::make_unique<MockDevice>());
+            driver.devices.back()->luid = driver.nextLuid++;
+            ResetToDefaults(*driver.devices.back());
+            present++;
+        }
+    }
+
+    // A driver update resets the adapters: the old handles are lost, new ones keep the
+    // device id and the settings
+    void UpdateDriverLocked(MockDriver& driver) {
+        size_t count = driver.devices.size();
+        for (size_t i = 0; i < count; i++) {
+            MockDevice& device = *driver.devices[i];
+            if (!device.present) continue;
+            device.present = false;
+            driver.devices.push_back(std::make_unique<MockDevice>(device));
+            driver.devices.back()->present = true;
+        }
+    }
+
+    // "31.0.101.5186" as 4 x 16 bits, or a plain number
+    uint64_t ParseDriverVersion(const std::string& text) {
+        if (text.find('.') == std::string::npos) return std::strtoull(text.c_str(), nullptr, 0);
+        uint64_t version = 0;
+        size_t start = 0;
+        for (int part = 0; part < 4; part++) {
+            uint64_t value = start < text.size() ? std::strtoull(text.c_str() + start, nullptr, 10) : 0;
+            version = (version << 16) | (value & 0xFFFF);
+            size_t dot = text.find('.', start);
+            start = dot == std::string::npos ? text.size() : dot + 1;
+        }
+        return version;
+    }
+
+    void ConfigureLocked(MockDriver& driver) {
+        if (driver.configured) return;
+        driver.configured = true;
+
+        ctl_mock_config_t& config = driver.config;
+        config.DeviceCount = 1;
+        config.FailureResult = CTL_RESULT_ERROR_UNKNOWN;
+        config.Seed = 1;
+        config.DriverVersion = ParseDriverVersion("31.0.101.5186");
+
+        if (const char* value = std::getenv("IGCL_MOCK_DEVICES")) {
+            config.DeviceCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        }
+        if (const char* value = std::getenv("IGCL_MOCK_LATENCY_US")) {
+            ParsePerEntry(value, config.LatencyUs, [](const std::string& v) { return static_cast<uint32_t>(std::strtoul(v.c_str(), nullptr, 10)); });
+        }
+        if (const char* value = std::getenv("IGCL_MOCK_FAIL")) {
+            ParsePerEntry(value, config.FailureRate, [](const std::string& v) { return std::strtod(v.c_str(), nullptr); });
+        }
+        if (const char* value = std::getenv("IGCL_MOCK_FAIL_RESULT")) {
+            config.FailureResult = ParseResult(value);
+        }
+        if (const char* value = std::getenv("IGCL_MOCK_SEED")) {
+            config.Seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        }
+        if (const char* value = std::getenv("IGCL_MOCK_DRIVER_VERSION")) {
+            config.DriverVersion = ParseDriverVersion(value);
+        }
+
+        driver.random.seed(config.Seed);
+        ApplyDeviceCountLocked(driver);
+    }
+
+    // Common prologue of every entry point: counts the call, simulates the driver
+    // latency (outside the lock, like concurrent IOCTLs) and injects failures
+    ctl_result_t Enter(ctl_mock_entry_t entry) {
+        auto& driver = Driver();
+        driver.calls[entry]++;
+
+        uint32_t latencyUs;
+        bool fail;
+        ctl_result_t failure;
+        {
+            std::lock_guard<std::mutex> lock(driver.mutex);
+            ConfigureLocked(driver);
+            latencyUs = driver.config.LatencyUs[entry];
+            double rate = driver.config.FailureRate[entry];
+            fail = rate > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(driver.random) < rate;
+            failure = driver.config.FailureResult;
+        }
+
+        if (latencyUs > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(latencyUs));
+        }
+        return fail ? failure : CTL_RESULT_SUCCESS;
+    }
+
+    bool IsValidEnum(const MockFeature& feature, uint32_t value) {
+        if (feature.type == CTL_3D_FEATURE_GAMING_FLIP_MODES) {
+            // flip modes are flags, exactly one of the supported ones
+            return value != 0 && (value & (value - 1)) == 0 && (value & feature.info.EnumType.SupportedTypes) == value;
+        }
+        return value < 64 && ((1ull << value) & feature.info.EnumType.SupportedTypes) != 0;
+    }
+
+}
+
+extern "C" {
+
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlInit(ctl_init_args_t* pInitDesc, ctl_api_handle_t* phAPIHandle) {
+    if (!pInitDesc || !phAPIHandle) return CTL_RESULT_ERROR_INVALID_NULL_POINTER;
+    if (pInitDesc->Size != sizeof(ctl_init_args_t)) return CTL_RESULT_ERROR_INVALID_SIZE;
+    ctl_result_t result = Enter(CTL_MOCK_ENTRY_INIT);
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    auto& driver = Driver();
+    std::lock_guard<std::mutex> lock(driver.mutex);
+    driver.openHandles++;
+    pInitDesc->SupportedVersion = CTL_IMPL_VERSION;
+    *phAPIHandle = kApiHandle;
+    return CTL_RESULT_SUCCESS;
+}
+
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlClose(ctl_api_handle_t hAPIHandle) {
+    if (hAPIHandle != kApiHandle) return CTL_RESULT_ERROR_INVALID_NULL_HANDLE;
+    ctl_result_t result = Enter(CTL_MOCK_ENTRY_CLOSE);
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    auto& driver = Driver();
+    std::lock_guard<std::mutex> lock(driver.mutex);
+    if (driver.openHandles == 0) return CTL_RESULT_ERROR_NOT_INITIALIZED;
+    return --driver.openHandles > 0 ? CTL_RESULT_SUCCESS_STILL_OPEN_BY_ANOTHER_CALLER : CTL_RESULT_SUCCESS;
+}
+
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlEnumerateDevices(ctl_api_handle_t hAPIHandle, uint32_t* pCount, ctl_device_adapter_handle_t* phDevices) {
+    if (hAPIHandle != kApiHandle) return CTL_RESULT_ERROR_INVALID_NULL_HANDLE;
+    if (!pCount) return CTL_RESULT_ERROR_INVALID_NULL_POINTER;
+    ctl_result_t result = Enter(CTL_MOCK_ENTRY_ENUMERATE_DEVICES);
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    auto& driver = Driver();
+    std::lock_guard<std::mutex> lock(driver.mutex);
+    if (driver.openHandles == 0) return CTL_RESULT_ERROR_NOT_INITIALIZED;
+
+    uint32_t available = 0;
+    for (const auto& device : driver.devices) {
+        if (device->present) available++;
+    }
+    if (!phDevices) {
+        *pCount = available;
+        return CTL_RESULT_SUCCESS;
+    }
+    uint32_t count = 0;
+    for (const auto& device : driver.devices) {
+        if (count == *pCount) break;
+        if (device->present) phDevices[count++] = reinterpret_cast<ctl_device_adapter_handle_t>(device.get());
+    }
+    *pCount = count;
+    return CTL_RESULT_SUCCESS;
+}
+
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlGetDeviceProperties(ctl_device_adapter_handle_t hDAhandle, ctl_device_adapter_properties_t* pProperties) {
+    if (!pProperties) return CTL_RESULT_ERROR_INVALID_NULL_POINTER;
+    if (pProperties->Size != sizeof(ctl_device_adapter_properties_t)) return CTL_RESULT_ERROR_INVALID_SIZE;
+    ctl_result_t result = Enter(CTL_MOCK_ENTRY_GET_DEVICE_PROPERTIES);
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    auto& driver = Driver();
+    std::lock_guard<std::mutex> lock(driver.mutex);
+    MockDevice* device = ToDevice(hDAhandle, result);
+    if (!device) return result;
+
+    // the device id is optional, and only copied into a buffer big enough for it
+    if (pProperties->pDeviceID) {
+        if (pProperties->device_id_size < sizeof(device->luid)) return CTL_RESULT_ERROR_INVALID_SIZE;
+        std::memcpy(pProperties->pDeviceID, &device->luid, sizeof(device->luid));
+    }
+    pProperties->device_id_size = sizeof(device->luid);
+    pProperties->device_type = CTL_DEVICE_TYPE_GRAPHICS;
+    pProperties->driver_version = driver.config.DriverVersion;
+    pProperties->pci_vendor_id = 0x8086;
+    pProperties->pci_device_id = 0x56A0;
+    pProperties->rev_id = 0x08;
+    std::strncpy(pProperties->name, "Intel(R) Arc(TM) A770 Graphics (mock)", CTL_MAX_DEVICE_NAME_LEN - 1);
+    pProperties->name[CTL_MAX_DEVICE_NAME_LEN - 1] = '\0';
+    return CTL_RESULT_SUCCESS;
+}
+
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlGetSupported3DCapabilities(ctl_device_adapter_handle_t hDAhandle, ctl_3d_feature_caps_t* pFeatureCaps3D) {
+    if (!pFeatureCaps3D) return CTL_RESULT_ERROR_INVALID_NULL_POINTER;
+    ctl_result_t result = Enter(CTL_MOCK_ENTRY_GET_SUPPORTED_3D_CAPABILITIES);
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    auto& driver = Driver();
+    std::lock_guard<std::mutex> lock(driver.mutex);
+    if (!ToDevice(hDAhandle, result)) return result;
+
+    // first call sizes the array, second call fills it
+    if (!pFeatureCaps3D->pFeatureDetails) {
+        pFeatureCaps3D->NumSupportedFeatures = kSupportedFeatureCount;
+        return CTL_RESULT_SUCCESS;
+    }
+    uint32_t count = pFeatureCaps3D->NumSupportedFeatures < kSupportedFeatureCount ? pFeatureCaps3D->NumSupportedFeatures : kSupportedFeatureCount;
+    for (uint32_t i = 0; i < count; i++) {
+        const MockFeature* feature = FindFeature(kSupportedFeatures[i]);
+        ctl_3d_feature_details_t& details = pFeatureCaps3D->pFeatureDetails[i];
+        details.Size = sizeof(ctl_3d_feature_details_t);
+        details.FeatureType = feature->type;
+        details.ValueType = feature->valueType;
+        details.Value = feature->info;
+        details.CustomValueSize = feature->customValueSize;
+        details.PerAppSupport = feature->perAppSupport;
+        details.ConflictingFeatures = 0;
+        details.FeatureMiscSupport = 0;
+    }
+    pFeatureCaps3D->NumSupportedFeatures = count;
+    return CTL_RESULT_SUCCESS;
+}
+
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlGetSet3DFeature(ctl_device_adapter_handle_t hDAhandle, ctl_3d_feature_getset_t* pFeature) {
+    if (!pFeature) return CTL_RESULT_ERROR_INVALID_NULL_POINTER;
+    ctl_result_t result = Enter(CTL_MOCK_ENTRY_GET_SET_3D_FEATURE);
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    auto& driver = Driver();
+    std::lock_guard<std::mutex> lock(driver.mutex);
+    MockDevice* device = ToDevice(hDAhandle, result);
+    if (!device) return result;
+
+    const MockFeature* feature = FindFeature(pFeature->FeatureType);
+    if (!feature) return CTL_RESULT_ERROR_UNSUPPORTED_FEATURE;
+    if (pFeature->ValueType != feature->valueType) return CTL_RESULT_ERROR_INVALID_ARGUMENT;
+
+    if (feature->valueType == CTL_PROPERTY_VALUE_TYPE_CUSTOM) {
+        if (!pFeature->pCustomValue) return CTL_RESULT_ERROR_INVALID_NULL_POINTER;
+        if (pFeature->CustomValueSize != feature->customValueSize) return CTL_RESULT_ERROR_INVALID_SIZE;
+        if (pFeature->bSet) {
+            std::memcpy(&device->enduranceGaming, pFeature->pCustomValue, sizeof(ctl_endurance_gaming_t));
+        } else {
+            std::memcpy(pFeature->pCustomValue, &device->enduranceGaming, sizeof(ctl_endurance_gaming_t));
+        }
+        return CTL_RESULT_SUCCESS;
+    }
+
+    ctl_property_t& value = device->values[feature->type];
+    if (!pFeature->bSet) {
+        pFeature->Value = value;
+        return CTL_RESULT_SUCCESS;
+    }
+
+    switch (feature->valueType) {
+        case CTL_PROPERTY_VALUE_TYPE_ENUM:
+            if (!IsValidEnum(*feature, pFeature->Value.EnumType.EnableType)) return CTL_RESULT_ERROR_INVALID_ARGUMENT;
+            break;
+        case CTL_PROPERTY_VALUE_TYPE_INT32:
+            if (pFeature->Value.IntType.Value < feature->info.IntType.RangeMin ||
+                pFeature->Value.IntType.Value > feature->info.IntType.RangeMax) return CTL_RESULT_ERROR_INVALID_ARGUMENT;
+            break;
+        default:
+            break;
+    }
+    value = pFeature->Value;
+    return CTL_RESULT_SUCCESS;
+}
+
+CTL_APIEXPORT void CTL_APICALL ctlMockGetConfig(ctl_mock_config_t* pConfig) {
+    if (!pConfig) return;
+    auto& driver = Driver();
+    std::lock_guard<std::mutex> lock(driver.mutex);
+    ConfigureLocked(driver);
+    *pConfig = driver.config;
+}
+
+CTL_APIEXPORT void CTL_APICALL ctlMockSetConfig(const ctl_mock_config_t* pConfig) {
+    if (!pConfig) return;
+    auto& driver = Driver();
+    std::lock_guard<std::mutex> lock(driver.mutex);
+    ConfigureLocked(driver);
+    if (pConfig->Seed != driver.config.Seed) {
+        driver.random.seed(pConfig->Seed);
+    }
+    bool driverUpdate = pConfig->DriverVersion != driver.config.DriverVersion;
+    driver.config = *pConfig;
+    if (driverUpdate) {
+        UpdateDriverLocked(driver);
+    }
+    ApplyDeviceCountLocked(driver);
+}
+
+CTL_APIEXPORT uint64_t CTL_APICALL ctlMockGetCallCount(ctl_mock_entry_t entry) {
+    if (entry < 0 || entry >= CTL_MOCK_ENTRY_MAX) return 0;
+    return Driver().calls[entry].load();
+}
+
+CTL_APIEXPORT void CTL_APICALL ctlMockResetCallCounts() {
+    for (auto& calls : Driver().calls) {
+        calls = 0;
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// Control knobs of the mock IGCL driver (mock/control_lib), not part of the IGCL API.
+//
+// The configuration is read from the environment at the first ctlInit:
+//
+//   IGCL_MOCK_DEVICES=2                         number of adapters (default 1)
+//   IGCL_MOCK_LATENCY_US=300                    latency added to every entry point, or
+//   IGCL_MOCK_LATENCY_US=ctlInit:20000,ctlGetSet3DFeature:500
+//                                               latency per entry point
+//   IGCL_MOCK_FAIL=ctlGetSet3DFeature:0.1       failure rate per entry point (0..1)
+//   IGCL_MOCK_FAIL_RESULT=device_lost           result of an injected failure: unknown (default),
+//                                               device_lost, or a numeric ctl_result_t
+//   IGCL_MOCK_SEED=42                           seed of the failure injection (default 1)
+//   IGCL_MOCK_DRIVER_VERSION=31.0.101.5186      driver version reported by ctlGetDeviceProperties
+//
+// and can be changed at run time with ctlMockSetConfig(), e.g. to simulate an adapter
+// being removed: handles of removed adapters answer CTL_RESULT_ERROR_DEVICE_LOST.
+// Changing DriverVersion simulates a driver update: every adapter is reset, its old
+// handle reports the device lost and a new one is enumerated with the same device id.
+
+#ifndef MOCK_CONTROL_LIB_MOCK_H
+#define MOCK_CONTROL_LIB_MOCK_H
+
+#include "igcl_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum _ctl_mock_entry_t {
+    CTL_MOCK_ENTRY_INIT = 0,
+    CTL_MOCK_ENTRY_CLOSE = 1,
+    CTL_MOCK_ENTRY_ENUMERATE_DEVICES = 2,
+    CTL_MOCK_ENTRY_GET_SUPPORTED_3D_CAPABILITIES = 3,
+    CTL_MOCK_ENTRY_GET_SET_3D_FEATURE = 4,
+    CTL_MOCK_ENTRY_GET_DEVICE_PROPERTIES = 5,
+    CTL_MOCK_ENTRY_MAX
+} ctl_mock_entry_t;
+
+typedef struct _ctl_mock_config_t {
+    uint32_t DeviceCount;
+    uint32_t LatencyUs[CTL_MOCK_ENTRY_MAX];
+    double FailureRate[CTL_MOCK_ENTRY_MAX];
+    ctl_result_t FailureResult;
+    uint32_t Seed;
+    uint64_t DriverVersion; // 4 x 16 bits, e.g. 31.0.101.5186
+} ctl_mock_config_t;
+
+CTL_APIEXPORT void CTL_APICALL ctlMockGetConfig(ctl_mock_config_t* pConfig);
+CTL_APIEXPORT void CTL_APICALL ctlMockSetConfig(const ctl_mock_config_t* pConfig);
+
+// Number of calls received by an entry point, injected failures included
+CTL_APIEXPORT uint64_t CTL_APICALL ctlMockGetCallCount(ctl_mock_entry_t entry);
+CTL_APIEXPORT void CTL_APICALL ctlMockResetCallCounts();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MOCK_CONTROL_LIB_MOCK_H
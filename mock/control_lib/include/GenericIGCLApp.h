@@ -0,0 +1,68 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// Stand-in for the IGCL samples GenericIGCLApp.h: the few helpers the plugins
+// take from it, without the Windows headers.
+
+#ifndef MOCK_GENERIC_IGCL_APP_H
+#define MOCK_GENERIC_IGCL_APP_H
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "igcl_api.h"
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef ZeroMemory
+#define ZeroMemory(Destination, Length) memset((Destination), 0, (Length))
+#endif
+
+inline std::string Get3DFeatureName(ctl_3d_feature_t FeatureType)
+{
+    switch (FeatureType) {
+        case CTL_3D_FEATURE_GAMING_FLIP_MODES: return "Gaming Flip Modes";
+        case CTL_3D_FEATURE_ANISOTROPIC: return "Anisotropic";
+        case CTL_3D_FEATURE_FRAME_LIMIT: return "Frame Limit";
+        case CTL_3D_FEATURE_ENDURANCE_GAMING: return "Endurance Gaming";
+        case CTL_3D_FEATURE_GAMING_COMPUTE_FEATURES: return "Gaming Compute Features";
+        case CTL_3D_FEATURE_ADAPTIVE_TESSELLATION: return "Adaptive Tessellation";
+        case CTL_3D_FEATURE_SHARPENING_FILTER: return "Sharpening Filter";
+        case CTL_3D_FEATURE_MSAA: return "MSAA";
+        case CTL_3D_FEATURE_GAMING_PROFILE: return "Gaming Profile";
+        case CTL_3D_FEATURE_TEXTURE_FILTERING_QUALITY: return "Texture Filtering Quality";
+        default: return "Unknown";
+    }
+}
+
+#endif //MOCK_GENERIC_IGCL_APP_H
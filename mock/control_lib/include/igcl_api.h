@@ -0,0 +1,279 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// Stand-in for the IGCL 0.95 igcl_api.h, used where the Intel Control API SDK
+// is not available (Linux, macOS). Only the subset of types and entry points
+// the plugins use is declared here; names and layouts follow the SDK header.
+
+#ifndef MOCK_IGCL_API_H
+#define MOCK_IGCL_API_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(_WIN32)
+#define CTL_APICALL __cdecl
+#define CTL_APIEXPORT __declspec(dllexport)
+#else
+#define CTL_APICALL
+#define CTL_APIEXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CTL_MAKE_VERSION(_major, _minor) ((_major << 16) | (_minor & 0x0000ffff))
+#define CTL_IMPL_MAJOR_VERSION 1
+#define CTL_IMPL_MINOR_VERSION 1
+#define CTL_IMPL_VERSION CTL_MAKE_VERSION(CTL_IMPL_MAJOR_VERSION, CTL_IMPL_MINOR_VERSION)
+
+#define CTL_BIT(_i) (1 << _i)
+
+typedef uint32_t ctl_version_info_t;
+typedef uint32_t ctl_init_flags_t;
+
+typedef struct _ctl_api_handle_t *ctl_api_handle_t;
+typedef struct _ctl_device_adapter_handle_t *ctl_device_adapter_handle_t;
+
+typedef enum _ctl_result_t {
+    CTL_RESULT_SUCCESS = 0x00000000,
+    CTL_RESULT_SUCCESS_STILL_OPEN_BY_ANOTHER_CALLER = 0x00000001,
+    CTL_RESULT_ERROR_SUCCESS_END = 0x0000FFFF,
+    CTL_RESULT_ERROR_GENERIC_START = 0x40000000,
+    CTL_RESULT_ERROR_NOT_INITIALIZED = 0x40000001,
+    CTL_RESULT_ERROR_ALREADY_INITIALIZED = 0x40000002,
+    CTL_RESULT_ERROR_DEVICE_LOST = 0x40000003,
+    CTL_RESULT_ERROR_OUT_OF_HOST_MEMORY = 0x40000004,
+    CTL_RESULT_ERROR_INVALID_ARGUMENT = 0x4000000C,
+    CTL_RESULT_ERROR_INVALID_NULL_HANDLE = 0x40000011,
+    CTL_RESULT_ERROR_INVALID_NULL_POINTER = 0x40000012,
+    CTL_RESULT_ERROR_INVALID_SIZE = 0x40000014,
+    CTL_RESULT_ERROR_UNSUPPORTED_FEATURE = 0x40000016,
+    CTL_RESULT_ERROR_UNKNOWN = 0x4000FFFF,
+    CTL_RESULT_MAX
+} ctl_result_t;
+
+typedef struct _ctl_application_id_t {
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t Data4[8];
+} ctl_application_id_t;
+
+typedef struct _ctl_init_args_t {
+    uint32_t Size;
+    uint8_t Version;
+    ctl_version_info_t AppVersion;
+    ctl_init_flags_t flags;
+    ctl_version_info_t SupportedVersion;
+    ctl_application_id_t ApplicationUID;
+} ctl_init_args_t;
+
+#define CTL_MAX_DEVICE_NAME_LEN 100
+#define CTL_MAX_RESERVED_SIZE 112
+
+typedef uint32_t ctl_supported_functions_flags_t;
+typedef uint32_t ctl_adapter_properties_flags_t;
+
+typedef enum _ctl_device_type_t {
+    CTL_DEVICE_TYPE_GRAPHICS = 1,
+    CTL_DEVICE_TYPE_SYSTEM = 2,
+    CTL_DEVICE_TYPE_MAX
+} ctl_device_type_t;
+
+typedef struct _ctl_firmware_version_t {
+    uint64_t major_version;
+    uint64_t minor_version;
+    uint64_t build_number;
+} ctl_firmware_version_t;
+
+typedef struct _ctl_adapter_bdf_t {
+    uint8_t bus;
+    uint8_t device;
+    uint8_t function;
+} ctl_adapter_bdf_t;
+
+typedef struct _ctl_device_adapter_properties_t {
+    uint32_t Size;
+    uint8_t Version;
+    void* pDeviceID;        // caller allocated, the LUID of the adapter on Windows
+    uint32_t device_id_size;
+    ctl_device_type_t device_type;
+    ctl_supported_functions_flags_t supported_subfunction_flags;
+    uint64_t driver_version;
+    ctl_firmware_version_t firmware_version;
+    uint32_t pci_vendor_id;
+    uint32_t pci_device_id;
+    uint32_t rev_id;
+    uint32_t num_eus_per_sub_slice;
+    uint32_t num_sub_slices_per_slice;
+    uint32_t num_slices;
+    char name[CTL_MAX_DEVICE_NAME_LEN];
+    ctl_adapter_properties_flags_t graphics_adapter_properties;
+    uint32_t Frequency;
+    uint16_t pci_subsys_id;
+    uint16_t pci_subsys_vendor_id;
+    ctl_adapter_bdf_t adapter_bdf;
+    char reserved[CTL_MAX_RESERVED_SIZE];
+} ctl_device_adapter_properties_t;
+
+typedef enum _ctl_3d_feature_t {
+    CTL_3D_FEATURE_GAMING_FLIP_MODES = 0,
+    CTL_3D_FEATURE_ANISOTROPIC = 1,
+    CTL_3D_FEATURE_FRAME_LIMIT = 2,
+    CTL_3D_FEATURE_ENDURANCE_GAMING = 3,
+    CTL_3D_FEATURE_GAMING_COMPUTE_FEATURES = 4,
+    CTL_3D_FEATURE_ADAPTIVE_TESSELLATION = 5,
+    CTL_3D_FEATURE_SHARPENING_FILTER = 6,
+    CTL_3D_FEATURE_MSAA = 7,
+    CTL_3D_FEATURE_GAMING_PROFILE = 8,
+    CTL_3D_FEATURE_TEXTURE_FILTERING_QUALITY = 9,
+    CTL_3D_FEATURE_MAX
+} ctl_3d_feature_t;
+
+typedef enum _ctl_property_value_type_t {
+    CTL_PROPERTY_VALUE_TYPE_BOOL = 0,
+    CTL_PROPERTY_VALUE_TYPE_FLOAT = 1,
+    CTL_PROPERTY_VALUE_TYPE_INT32 = 2,
+    CTL_PROPERTY_VALUE_TYPE_UINT32 = 3,
+    CTL_PROPERTY_VALUE_TYPE_ENUM = 4,
+    CTL_PROPERTY_VALUE_TYPE_CUSTOM = 5,
+    CTL_PROPERTY_VALUE_TYPE_MAX
+} ctl_property_value_type_t;
+
+typedef enum _ctl_gaming_flip_mode_flag_t {
+    CTL_GAMING_FLIP_MODE_FLAG_APPLICATION_DEFAULT = CTL_BIT(0),
+    CTL_GAMING_FLIP_MODE_FLAG_VSYNC_OFF = CTL_BIT(1),
+    CTL_GAMING_FLIP_MODE_FLAG_VSYNC_ON = CTL_BIT(2),
+    CTL_GAMING_FLIP_MODE_FLAG_SMOOTH_SYNC = CTL_BIT(3),
+    CTL_GAMING_FLIP_MODE_FLAG_SPEED_FRAME = CTL_BIT(4),
+    CTL_GAMING_FLIP_MODE_FLAG_CAPPED_FPS = CTL_BIT(5),
+    CTL_GAMING_FLIP_MODE_FLAG_MAX = 0x80000000
+} ctl_gaming_flip_mode_flag_t;
+
+typedef enum _ctl_3d_anisotropic_types_t {
+    CTL_3D_ANISOTROPIC_TYPES_APP_CHOICE = 0,
+    CTL_3D_ANISOTROPIC_TYPES_2X = 2,
+    CTL_3D_ANISOTROPIC_TYPES_4X = 4,
+    CTL_3D_ANISOTROPIC_TYPES_8X = 8,
+    CTL_3D_ANISOTROPIC_TYPES_16X = 16,
+    CTL_3D_ANISOTROPIC_TYPES_MAX
+} ctl_3d_anisotropic_types_t;
+
+typedef enum _ctl_3d_endurance_gaming_control_t {
+    CTL_3D_ENDURANCE_GAMING_CONTROL_TURN_OFF = 0,
+    CTL_3D_ENDURANCE_GAMING_CONTROL_TURN_ON = 1,
+    CTL_3D_ENDURANCE_GAMING_CONTROL_AUTO = 2,
+    CTL_3D_ENDURANCE_GAMING_CONTROL_MAX
+} ctl_3d_endurance_gaming_control_t;
+
+typedef enum _ctl_3d_endurance_gaming_mode_t {
+    CTL_3D_ENDURANCE_GAMING_MODE_BETTER_PERFORMANCE = 0,
+    CTL_3D_ENDURANCE_GAMING_MODE_BALANCED = 1,
+    CTL_3D_ENDURANCE_GAMING_MODE_MAXIMUM_BATTERY = 2,
+    CTL_3D_ENDURANCE_GAMING_MODE_MAX
+} ctl_3d_endurance_gaming_mode_t;
+
+typedef struct _ctl_endurance_gaming_t {
+    ctl_3d_endurance_gaming_control_t EGControl;
+    ctl_3d_endurance_gaming_mode_t EGMode;
+} ctl_endurance_gaming_t;
+
+typedef struct _ctl_property_info_boolean_t { bool DefaultState; } ctl_property_info_boolean_t;
+typedef struct _ctl_property_info_float_t { bool DefaultEnable; float RangeMin; float RangeMax; float DefaultValue; } ctl_property_info_float_t;
+typedef struct _ctl_property_info_int_t { bool DefaultEnable; int32_t RangeMin; int32_t RangeMax; int32_t DefaultValue; } ctl_property_info_int_t;
+typedef struct _ctl_property_info_uint_t { bool DefaultEnable; uint32_t RangeMin; uint32_t RangeMax; uint32_t DefaultValue; } ctl_property_info_uint_t;
+typedef struct _ctl_property_info_enum_t { uint64_t SupportedTypes; uint32_t DefaultType; } ctl_property_info_enum_t;
+
+typedef union _ctl_property_info_t {
+    ctl_property_info_boolean_t BoolType;
+    ctl_property_info_float_t FloatType;
+    ctl_property_info_int_t IntType;
+    ctl_property_info_enum_t EnumType;
+    ctl_property_info_uint_t UIntType;
+} ctl_property_info_t;
+
+typedef struct _ctl_property_boolean_t { bool Enable; } ctl_property_boolean_t;
+typedef struct _ctl_property_float_t { bool Enable; float Value; } ctl_property_float_t;
+typedef struct _ctl_property_int_t { bool Enable; int32_t Value; } ctl_property_int_t;
+typedef struct _ctl_property_uint_t { bool Enable; uint32_t Value; } ctl_property_uint_t;
+typedef struct _ctl_property_enum_t { uint32_t EnableType; } ctl_property_enum_t;
+
+typedef union _ctl_property_t {
+    ctl_property_boolean_t BoolType;
+    ctl_property_float_t FloatType;
+    ctl_property_int_t IntType;
+    ctl_property_enum_t EnumType;
+    ctl_property_uint_t UIntType;
+} ctl_property_t;
+
+typedef struct _ctl_3d_feature_details_t {
+    uint32_t Size;
+    uint8_t Version;
+    ctl_3d_feature_t FeatureType;
+    ctl_property_value_type_t ValueType;
+    ctl_property_info_t Value;
+    int32_t CustomValueSize;
+    bool PerAppSupport;
+    int64_t ConflictingFeatures;
+    int16_t FeatureMiscSupport;
+    int16_t Reserved;
+    int16_t Reserved1;
+    int16_t Reserved2;
+} ctl_3d_feature_details_t;
+
+typedef struct _ctl_3d_feature_caps_t {
+    uint32_t Size;
+    uint8_t Version;
+    uint32_t NumSupportedFeatures;
+    ctl_3d_feature_details_t* pFeatureDetails;
+} ctl_3d_feature_caps_t;
+
+typedef struct _ctl_3d_feature_getset_t {
+    uint32_t Size;
+    uint8_t Version;
+    ctl_3d_feature_t FeatureType;
+    char* ApplicationName;
+    int8_t ApplicationNameLength;
+    bool bSet;
+    ctl_property_value_type_t ValueType;
+    ctl_property_t Value;
+    int32_t CustomValueSize;
+    void* pCustomValue;
+} ctl_3d_feature_getset_t;
+
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlInit(ctl_init_args_t* pInitDesc, ctl_api_handle_t* phAPIHandle);
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlClose(ctl_api_handle_t hAPIHandle);
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlEnumerateDevices(ctl_api_handle_t hAPIHandle, uint32_t* pCount, ctl_device_adapter_handle_t* phDevices);
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlGetDeviceProperties(ctl_device_adapter_handle_t hDAhandle, ctl_device_adapter_properties_t* pProperties);
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlGetSupported3DCapabilities(ctl_device_adapter_handle_t hDAhandle, ctl_3d_feature_caps_t* pFeatureCaps3D);
+CTL_APIEXPORT ctl_result_t CTL_APICALL ctlGetSet3DFeature(ctl_device_adapter_handle_t hDAhandle, ctl_3d_feature_getset_t* pFeature);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MOCK_IGCL_API_H
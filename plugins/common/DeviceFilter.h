@@ -0,0 +1,78 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef DEVICE_FILTER_H
+#define DEVICE_FILTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+/// Adapter selection of the set_* tools. The optional "devices" argument lists the
+/// indices of the adapters to touch, every adapter is selected when it is absent.
+/// The optional "parallel" argument (default true) lets the calls run concurrently.
+
+// JSON schema properties of the two arguments, spliced into the tools inputSchema
+#define DEVICE_FILTER_SCHEMA_PROPERTIES \
+    "\"devices\": { \"type\": \"array\", \"items\": { \"type\": \"integer\", \"minimum\": 0 }, \"uniqueItems\": true, " \
+    "\"description\": \"Indices of the adapters to apply to, all adapters when omitted\" }, " \
+    "\"parallel\": { \"type\": \"boolean\", \"description\": \"Apply to the adapters concurrently (default true)\" }"
+
+// Fill indices with the selected adapters, false with a message on an invalid selection
+// (the tool rejects the call with WriteInvalidParams)
+inline bool SelectDevices(const nlohmann::json& arguments, size_t deviceCount,
+                          std::vector<uint32_t>& indices, std::string& error) {
+    indices.clear();
+    auto devices = arguments.find("devices");
+    if (devices == arguments.end() || devices->is_null()) {
+        for (uint32_t i = 0; i < deviceCount; i++) indices.push_back(i);
+        return true;
+    }
+    if (!devices->is_array() || devices->empty()) {
+        error = "devices must be a non-empty array of adapter indices.";
+        return false;
+    }
+
+    std::vector<bool> selected(deviceCount, false);
+    for (const auto& device : *devices) {
+        if (!device.is_number_integer() || device.get<int64_t>() < 0 || device.get<uint64_t>() >= deviceCount) {
+            error = "Unknown device index " + device.dump() + ", " + std::to_string(deviceCount) + " adapter(s) found.";
+            return false;
+        }
+        uint32_t index = device.get<uint32_t>();
+        if (selected[index]) continue;
+        selected[index] = true;
+        indices.push_back(index);
+    }
+    return true;
+}
+
+inline bool ParallelApply(const nlohmann::json& arguments) {
+    auto parallel = arguments.find("parallel");
+    return parallel == arguments.end() || !parallel->is_boolean() || parallel->get<bool>();
+}
+
+#endif //DEVICE_FILTER_H
@@ -0,0 +1,333 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "IgclSession.h"
+
+#include <condition_variable>
+#include <cstring>
+#include "ThreadPool.h"
+
+static bool SameAdapters(const IgclSession::Devices& a, const IgclSession::Devices& b) {
+    if (a.handles != b.handles || a.adapters.size() != b.adapters.size()) return false;
+    for (size_t i = 0; i < a.adapters.size(); i++) {
+        const IgclSession::Adapter& x = a.adapters[i];
+        const IgclSession::Adapter& y = b.adapters[i];
+        if (x.identified != y.identified || x.deviceId != y.deviceId || x.driverVersion != y.driverVersion) return false;
+    }
+    return true;
+}
+
+static IgclSession::FeatureValue ToFeatureValue(const ctl_3d_feature_getset_t& property) {
+    IgclSession::FeatureValue value;
+    value.valueType = property.ValueType;
+    if (property.ValueType == CTL_PROPERTY_VALUE_TYPE_CUSTOM) {
+        const uint8_t* data = static_cast<const uint8_t*>(property.pCustomValue);
+        value.custom.assign(data, data + property.CustomValueSize);
+    } else {
+        value.value = property.Value;
+    }
+    return value;
+}
+
+// Compares the members the value type uses only, the rest of the union is undefined
+static bool SameValue(const IgclSession::FeatureValue& value, const ctl_3d_feature_getset_t& property) {
+    if (value.valueType != property.ValueType) return false;
+    const ctl_property_t& a = value.value;
+    const ctl_property_t& b = property.Value;
+    switch (property.ValueType) {
+        case CTL_PROPERTY_VALUE_TYPE_BOOL:
+            return a.BoolType.Enable == b.BoolType.Enable;
+        case CTL_PROPERTY_VALUE_TYPE_FLOAT:
+            return a.FloatType.Enable == b.FloatType.Enable && a.FloatType.Value == b.FloatType.Value;
+        case CTL_PROPERTY_VALUE_TYPE_INT32:
+            return a.IntType.Enable == b.IntType.Enable && a.IntType.Value == b.IntType.Value;
+        case CTL_PROPERTY_VALUE_TYPE_UINT32:
+            return a.UIntType.Enable == b.UIntType.Enable && a.UIntType.Value == b.UIntType.Value;
+        case CTL_PROPERTY_VALUE_TYPE_ENUM:
+            return a.EnumType.EnableType == b.EnumType.EnableType;
+        case CTL_PROPERTY_VALUE_TYPE_CUSTOM:
+            return property.pCustomValue && value.custom.size() == static_cast<size_t>(property.CustomValueSize) &&
+                   memcmp(value.custom.data(), property.pCustomValue, value.custom.size()) == 0;
+        default:
+            return false;
+    }
+}
+
+IgclSession& IgclSession::Instance() {
+    static IgclSession session;
+    return session;
+}
+
+IgclSession::IgclSession() = default;
+IgclSession::~IgclSession() = default;
+
+ctl_result_t IgclSession::Acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    users_++;
+    return OpenLocked();
+}
+
+void IgclSession::Release() {
+    std::unique_ptr<ThreadPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (users_ == 0) return;
+        if (--users_ == 0) {
+            CloseLocked();
+            pool = std::move(pool_);
+        }
+    }
+    // join the workers here rather than at library unload, outside the lock they never take
+    pool.reset();
+}
+
+ctl_result_t IgclSession::Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return OpenLocked();
+}
+
+ctl_result_t IgclSession::GetDevices(std::shared_ptr<const Devices>& devices) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ctl_result_t result = OpenLocked();
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    if (!devices_) {
+        result = EnumerateLocked();
+        if (result != CTL_RESULT_SUCCESS) return result;
+    } else if (std::chrono::steady_clock::now() - enumerated_ > std::chrono::milliseconds(IGCL_DEVICE_REFRESH_MS)) {
+        // a failed refresh keeps the adapters known so far, the next interval tries again
+        EnumerateLocked();
+        enumerated_ = std::chrono::steady_clock::now();
+    }
+    devices = devices_;
+    return CTL_RESULT_SUCCESS;
+}
+
+void IgclSession::Invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    devices_.reset();
+}
+
+ctl_result_t IgclSession::Check(ctl_result_t result) {
+    switch (result) {
+        case CTL_RESULT_ERROR_DEVICE_LOST:
+        case CTL_RESULT_ERROR_INVALID_NULL_HANDLE:
+            // the adapter was removed or reset by a driver update, its handle is stale
+            Invalidate();
+            break;
+        case CTL_RESULT_ERROR_NOT_INITIALIZED: {
+            // the driver was restarted under the api handle, ctlInit again on the next call
+            std::lock_guard<std::mutex> lock(mutex_);
+            CloseLocked();
+            break;
+        }
+        default:
+            break;
+    }
+    return result;
+}
+
+ctl_result_t IgclSession::GetCapabilities(const Devices& devices, uint32_t index, std::shared_ptr<const Capabilities>& capabilities) {
+    const Adapter& adapter = devices.adapters[index];
+    AdapterKey key(adapter.deviceId, adapter.driverVersion);
+    if (adapter.identified) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = capabilities_.find(key);
+        if (it != capabilities_.end()) {
+            capabilities = it->second;
+            return CTL_RESULT_SUCCESS;
+        }
+    }
+
+    // first call sizes the array, second call fills it
+    ctl_3d_feature_caps_t FeatureCaps3D = {};
+    FeatureCaps3D.Size = sizeof(ctl_3d_feature_caps_t);
+    ctl_result_t result = Check(ctlGetSupported3DCapabilities(devices.handles[index], &FeatureCaps3D));
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    auto features = std::make_shared<Capabilities>(FeatureCaps3D.NumSupportedFeatures);
+    if (!features->empty()) {
+        FeatureCaps3D.pFeatureDetails = features->data();
+        result = Check(ctlGetSupported3DCapabilities(devices.handles[index], &FeatureCaps3D));
+        if (result != CTL_RESULT_SUCCESS) return result;
+        features->resize(FeatureCaps3D.NumSupportedFeatures);
+    }
+
+    if (adapter.identified) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // not for a stale enumeration, its entry would only be dropped by the next one
+        if (devices_ && devices_->generation == devices.generation) {
+            capabilities_[key] = features;
+        }
+    }
+    capabilities = std::move(features);
+    return CTL_RESULT_SUCCESS;
+}
+
+ctl_result_t IgclSession::GetSet3DFeature(const Devices& devices, uint32_t index, ctl_3d_feature_getset_t& property, bool* skipped) {
+    if (skipped) *skipped = false;
+    const Adapter& adapter = devices.adapters[index];
+    if (!adapter.identified || property.ApplicationName) {
+        return Check(ctlGetSet3DFeature(devices.handles[index], &property));
+    }
+
+    FeatureKey key(adapter.deviceId, adapter.driverVersion, property.FeatureType);
+    uint64_t call;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FeatureEntry& entry = features_[key];
+        if (property.bSet && entry.valid && entry.inFlight == 0 && SameValue(entry.value, property)) {
+            if (skipped) *skipped = true;
+            return CTL_RESULT_SUCCESS;
+        }
+        entry.valid = false;
+        entry.inFlight++;
+        call = ++entry.calls;
+    }
+
+    ctl_result_t result = Check(ctlGetSet3DFeature(devices.handles[index], &property));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = features_.find(key); // gone when the adapters were enumerated again meanwhile
+    if (it != features_.end()) {
+        FeatureEntry& entry = it->second;
+        entry.inFlight--;
+        if (result == CTL_RESULT_SUCCESS && entry.inFlight == 0 && entry.calls == call) {
+            entry.value = ToFeatureValue(property);
+            entry.valid = true;
+        }
+    }
+    return result;
+}
+
+std::vector<ctl_result_t> IgclSession::Apply(const Devices& devices, const std::vector<uint32_t>& indices,
+                                             const DeviceCall& call, bool parallel) {
+    std::vector<ctl_result_t> results(indices.size(), CTL_RESULT_ERROR_UNKNOWN);
+    ThreadPool* pool = parallel && indices.size() > 1 ? Pool() : nullptr;
+
+    if (!pool) {
+        for (size_t i = 0; i < indices.size(); i++) {
+            results[i] = Check(call(indices[i], devices.handles[indices[i]]));
+        }
+        return results;
+    }
+
+    std::mutex doneMutex;
+    std::condition_variable done;
+    size_t remaining = indices.size();
+    auto run = [&](size_t i) {
+        results[i] = call(indices[i], devices.handles[indices[i]]);
+        std::lock_guard<std::mutex> lock(doneMutex);
+        if (--remaining == 0) done.notify_one();
+    };
+    for (size_t i = 0; i < indices.size(); i++) {
+        if (!pool->Submit([&run, i]() { run(i); })) run(i);
+    }
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait(lock, [&remaining] { return remaining == 0; });
+    }
+
+    for (ctl_result_t result : results) Check(result);
+    return results;
+}
+
+ThreadPool* IgclSession::Pool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pool_) {
+        // sized for blocking IOCTLs, not for the CPUs: the workers mostly wait on the driver
+        pool_ = std::make_unique<ThreadPool>(IGCL_MAX_PARALLEL_DEVICES, IGCL_MAX_PARALLEL_DEVICES * 4);
+    }
+    return pool_.get();
+}
+
+ctl_result_t IgclSession::OpenLocked() {
+    if (apiHandle_) return CTL_RESULT_SUCCESS;
+
+    ctl_init_args_t CtlInitArgs;
+    memset(&CtlInitArgs, 0, sizeof(ctl_init_args_t));
+    CtlInitArgs.AppVersion = CTL_MAKE_VERSION(CTL_IMPL_MAJOR_VERSION, CTL_IMPL_MINOR_VERSION);
+    CtlInitArgs.flags = 0;
+    CtlInitArgs.Size = sizeof(CtlInitArgs);
+    CtlInitArgs.Version = 0;
+
+    ctl_api_handle_t hAPIHandle = nullptr;
+    ctl_result_t result = ctlInit(&CtlInitArgs, &hAPIHandle);
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    apiHandle_ = hAPIHandle;
+    devices_.reset();
+    return CTL_RESULT_SUCCESS;
+}
+
+void IgclSession::CloseLocked() {
+    devices_.reset();
+    if (apiHandle_) {
+        ctlClose(apiHandle_);
+        apiHandle_ = nullptr;
+    }
+}
+
+ctl_result_t IgclSession::EnumerateLocked() {
+    uint32_t AdapterCount = 0;
+    ctl_result_t result = ctlEnumerateDevices(apiHandle_, &AdapterCount, nullptr);
+    if (result != CTL_RESULT_SUCCESS) return result;
+
+    auto devices = std::make_shared<Devices>();
+    devices->handles.resize(AdapterCount);
+    if (AdapterCount > 0) {
+        result = ctlEnumerateDevices(apiHandle_, &AdapterCount, devices->handles.data());
+        if (result != CTL_RESULT_SUCCESS) return result;
+        devices->handles.resize(AdapterCount);
+    }
+
+    // identify the adapters for the capability cache, and forget the ones that are gone
+    std::map<AdapterKey, std::shared_ptr<const Capabilities>> capabilities;
+    std::map<FeatureKey, FeatureEntry> features;
+    devices->adapters.resize(AdapterCount);
+    for (uint32_t i = 0; i < AdapterCount; i++) {
+        Adapter& adapter = devices->adapters[i];
+        ctl_device_adapter_properties_t Properties = {};
+        Properties.Size = sizeof(ctl_device_adapter_properties_t);
+        Properties.pDeviceID = &adapter.deviceId;
+        Properties.device_id_size = sizeof(adapter.deviceId);
+        if (ctlGetDeviceProperties(devices->handles[i], &Properties) != CTL_RESULT_SUCCESS) continue;
+        adapter.driverVersion = Properties.driver_version;
+        adapter.identified = true;
+
+        auto it = capabilities_.find(AdapterKey(adapter.deviceId, adapter.driverVersion));
+        if (it != capabilities_.end()) capabilities.insert(*it);
+        auto first = features_.lower_bound(FeatureKey(adapter.deviceId, adapter.driverVersion, static_cast<ctl_3d_feature_t>(0)));
+        auto last = features_.lower_bound(FeatureKey(adapter.deviceId, adapter.driverVersion, CTL_3D_FEATURE_MAX));
+        features.insert(first, last);
+    }
+    capabilities_ = std::move(capabilities);
+    features_ = std::move(features);
+    enumerated_ = std::chrono::steady_clock::now();
+
+    if (devices_ && SameAdapters(*devices_, *devices)) return CTL_RESULT_SUCCESS;
+    devices->generation = ++generation_;
+    devices_ = std::move(devices);
+    return CTL_RESULT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef IGCL_SESSION_H
+#define IGCL_SESSION_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <igcl_api.h>
+
+// Max driver calls in flight at once for Apply(), whatever the number of adapters
+#define IGCL_MAX_PARALLEL_DEVICES 8
+
+// Age after which GetDevices() enumerates the adapters again to notice an added adapter,
+// IGCL has no notification for it; the same adapters keep the same Devices and caches
+#define IGCL_DEVICE_REFRESH_MS 5000
+
+// One session for every plugin of the server: on Windows IgclSession lives in its own DLL
+#if defined(_WIN32)
+#if defined(IGCL_SESSION_EXPORTS)
+#define IGCL_SESSION_API __declspec(dllexport)
+#else
+#define IGCL_SESSION_API __declspec(dllimport)
+#endif
+#else
+#define IGCL_SESSION_API
+#endif
+
+class ThreadPool;
+
+/// One IGCL api handle and adapter enumeration shared by the IGCL plugins.
+///
+/// Plugins call Acquire() from InitializeImpl and Release() from ShutdownImpl:
+/// ctlInit runs for the first user and ctlClose after the last one, instead of
+/// once per request. The adapter handles are enumerated once and served from
+/// memory; they are enumerated again when a driver call reports through Check()
+/// that an adapter was removed or reset by a driver update, and otherwise every
+/// IGCL_DEVICE_REFRESH_MS to notice an added adapter. A refresh that finds the
+/// same adapters keeps the same Devices, generation included.
+///
+/// The supported 3D features of an adapter are cached as well, keyed by its device
+/// id and driver version: they survive a new enumeration of the same adapter but
+/// not a driver update, and entries of adapters gone from the enumeration are dropped.
+/// So is the last value read from or written to every global 3D feature, which lets
+/// GetSet3DFeature() skip writing a value the adapter already has. A setting changed
+/// outside of the session is only seen by the next read of that feature.
+class IGCL_SESSION_API IgclSession {
+public:
+    struct Adapter {
+        uint64_t deviceId = 0;      // LUID reported by ctlGetDeviceProperties
+        uint64_t driverVersion = 0;
+        bool identified = false;    // ctlGetDeviceProperties succeeded, the adapter can be cached
+    };
+
+    struct Devices {
+        std::vector<ctl_device_adapter_handle_t> handles;
+        std::vector<Adapter> adapters; // same order as handles
+        uint64_t generation; // changes every time the adapters are enumerated again
+    };
+
+    using Capabilities = std::vector<ctl_3d_feature_details_t>;
+
+    // Value of a 3D feature as ctlGetSet3DFeature exchanges it
+    struct FeatureValue {
+        ctl_property_value_type_t valueType = CTL_PROPERTY_VALUE_TYPE_MAX;
+        ctl_property_t value = {};
+        std::vector<uint8_t> custom; // CTL_PROPERTY_VALUE_TYPE_CUSTOM
+    };
+
+    // A driver call on one adapter, index is its position in Devices::handles
+    using DeviceCall = std::function<ctl_result_t(uint32_t index, ctl_device_adapter_handle_t handle)>;
+
+    static IgclSession& Instance();
+
+    IgclSession(const IgclSession&) = delete;
+    IgclSession& operator=(const IgclSession&) = delete;
+
+    // Register a plugin as user of the session and open it
+    ctl_result_t Acquire();
+
+    // Unregister a plugin, the session is closed after the last one
+    void Release();
+
+    // Open the session if it is not, e.g. ctlInit failed at Acquire() time
+    ctl_result_t Open();
+
+    // Get the cached adapter handles, enumerating them if needed
+    ctl_result_t GetDevices(std::shared_ptr<const Devices>& devices);
+
+    // Drop the cached adapters, the next GetDevices() enumerates them again. Called by Check()
+    void Invalidate();
+
+    // Pass-through for driver call results: invalidates the adapters when a device was lost or
+    // its handle went stale, and closes the session when the driver was restarted under it
+    ctl_result_t Check(ctl_result_t result);
+
+    // Get the supported 3D features of devices.handles[index], from the cache when the
+    // adapter and its driver version were already queried
+    ctl_result_t GetCapabilities(const Devices& devices, uint32_t index, std::shared_ptr<const Capabilities>& capabilities);
+
+    // ctlGetSet3DFeature on devices.handles[index] through the value snapshot: a read
+    // refreshes it, a write of the value the snapshot holds returns success without
+    // calling the driver and sets skipped. Per application settings are not cached.
+    ctl_result_t GetSet3DFeature(const Devices& devices, uint32_t index, ctl_3d_feature_getset_t& property, bool* skipped = nullptr);
+
+    // Run call on the selected adapters and return the results in the order of indices.
+    // With parallel set the calls are issued concurrently on the session pool, each one is a
+    // blocking IOCTL on a real driver; a single adapter is always called inline.
+    std::vector<ctl_result_t> Apply(const Devices& devices, const std::vector<uint32_t>& indices,
+                                    const DeviceCall& call, bool parallel = true);
+
+private:
+    IgclSession();
+    ~IgclSession();
+
+    ThreadPool* Pool();
+
+    ctl_result_t OpenLocked();
+    void CloseLocked();
+    ctl_result_t EnumerateLocked();
+
+private:
+    using AdapterKey = std::pair<uint64_t, uint64_t>; // device id, driver version
+    using FeatureKey = std::tuple<uint64_t, uint64_t, ctl_3d_feature_t>;
+
+    // Snapshot of one feature. Calls overlapping on the same feature leave it invalid,
+    // the order they reached the driver in is unknown
+    struct FeatureEntry {
+        FeatureValue value;
+        bool valid = false;
+        uint64_t calls = 0;  // calls started, identifies the latest one
+        int inFlight = 0;
+    };
+
+    std::mutex mutex_;
+    int users_ = 0;
+    ctl_api_handle_t apiHandle_ = nullptr;
+    std::shared_ptr<const Devices> devices_;
+    std::chrono::steady_clock::time_point enumerated_;
+    uint64_t generation_ = 0;
+    std::map<AdapterKey, std::shared_ptr<const Capabilities>> capabilities_;
+    std::map<FeatureKey, FeatureEntry> features_;
+    std::unique_ptr<ThreadPool> pool_; // created on the first parallel Apply, stopped with the session
+};
+
+#endif //IGCL_SESSION_H
@@ -0,0 +1,139 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef PLUGIN_RESPONSE_H
+#define PLUGIN_RESPONSE_H
+
+#include <cstring>
+#include <string>
+
+#include "PluginAPI.h"
+#include "json.hpp"
+
+/// Helpers for plugins implementing the ABI v2 HandleRequestV2.
+///
+/// Results are serialized once and copied into the host PluginBuffer with a
+/// single Write, the plugin never grows its own output buffer. HandleRequestV1()
+/// runs a v2 handler behind the v1 HandleRequest entry point for older hosts.
+
+// Serialize value with the public json::dump and hand it to the host in one write
+inline PluginResult WriteJson(PluginBuffer* out, const nlohmann::json& value) {
+    try {
+        std::string text = value.dump();
+        return out->Write(out, text.data(), text.size()) == 0 ? PLUGIN_RESULT_OK : PLUGIN_RESULT_ERROR;
+    } catch (...) {
+        return PLUGIN_RESULT_ERROR;
+    }
+}
+
+// Tool result made of a single text content
+inline nlohmann::json TextResult(const std::string& text, bool isError) {
+    nlohmann::json response;
+    response["content"] = nlohmann::json::array();
+    response["content"].push_back({{"type", "text"}, {"text", text}});
+    response["isError"] = isError;
+    return response;
+}
+
+inline PluginResult WriteTextResult(PluginBuffer* out, const std::string& text, bool isError) {
+    return WriteJson(out, TextResult(text, isError));
+}
+
+// Tool result carrying structuredContent, which matches the tool outputSchema. The text
+// content is a one line summary for clients that predate structured results, the JSON is
+// not sent twice.
+inline nlohmann::json StructuredResult(nlohmann::json structured, const std::string& summary, bool isError) {
+    nlohmann::json response;
+    response["content"] = nlohmann::json::array();
+    response["content"].push_back({{"type", "text"}, {"text", summary}});
+    response["structuredContent"] = std::move(structured);
+    response["isError"] = isError;
+    return response;
+}
+
+inline PluginResult WriteStructuredResult(PluginBuffer* out, nlohmann::json structured, const std::string& summary, bool isError) {
+    return WriteJson(out, StructuredResult(std::move(structured), summary, isError));
+}
+
+// "on 2 of 3 adapters" for a devices array whose entries have a "success" flag
+inline std::string AdaptersSummary(const nlohmann::json& devices) {
+    size_t succeeded = 0;
+    for (const auto& device : devices) {
+        if (device.value("success", false)) succeeded++;
+    }
+    return "on " + std::to_string(succeeded) + " of " + std::to_string(devices.size()) + " adapters";
+}
+
+// Rejects the arguments of the call: the host answers with a JSON-RPC invalid params error
+// (-32602) carrying the message instead of a tool result. Every tool reports malformed
+// params, bad values and a bad devices filter this way; driver failures stay isError results
+inline PluginResult WriteInvalidParams(PluginBuffer* out, const std::string& message) {
+    return out->Write(out, message.data(), message.size()) == 0 ? PLUGIN_RESULT_INVALID_PARAMS : PLUGIN_RESULT_ERROR;
+}
+
+// Request params as a json object, throws nlohmann::json::parse_error on malformed input
+inline nlohmann::json ParseParams(const PluginRequest* request) {
+    if (!request->params || request->paramsLength == 0) return nlohmann::json::object();
+    return nlohmann::json::parse(request->params, request->params + request->paramsLength);
+}
+
+// ABI v4 cancellation token of the call, nullptr for hosts that predate it
+inline bool IsCancelled(const PluginCancelToken* cancel) {
+    return cancel && cancel->IsCancelled(cancel) != 0;
+}
+
+// v1 HandleRequest on top of a v2 handler: the result is returned as a new[] string owned by the host
+inline char* HandleRequestV1(PluginResult (*handler)(const PluginRequest*, PluginBuffer*), const char* req) {
+    std::string result;
+    try {
+        std::string params;
+        std::string name;
+        nlohmann::json request = nlohmann::json::parse(req);
+        auto it = request.find("params");
+        if (it != request.end()) {
+            params = it->dump();
+            if (it->contains("name") && (*it)["name"].is_string()) name = (*it)["name"];
+            else if (it->contains("uri") && (*it)["uri"].is_string()) name = (*it)["uri"];
+        }
+
+        PluginRequest pluginRequest{params.data(), params.size(), name.data(), name.size()};
+        PluginBuffer out{&result, [](PluginBuffer* buffer, const char* data, size_t length) {
+            static_cast<std::string*>(buffer->context)->append(data, length);
+            return 0;
+        }};
+        PluginResult status = handler(&pluginRequest, &out);
+        // v1 has no way to answer with an error, the message becomes an error result
+        if (status == PLUGIN_RESULT_INVALID_PARAMS) result = TextResult(result, true).dump();
+        else if (status != PLUGIN_RESULT_OK) return nullptr;
+    } catch (...) {
+        result = TextResult("Invalid JSON request.", true).dump();
+    }
+
+    char* buffer = new char[result.length() + 1];
+    memcpy(buffer, result.c_str(), result.length() + 1);
+    return buffer;
+}
+
+#endif //PLUGIN_RESPONSE_H
@@ -28,6 +28,8 @@
 
 #include <igcl_api.h>
 #include <GenericIGCLApp.h>
+#include "IgclSession.h"
+#include "PluginResponse.h"
 
 using json = nlohmann::json;
 
@@ -39,121 +41,101 @@ static PluginTool methods[] = {
     }
 };
 
+// structuredContent of get_3d_capabilities: the supported features of every device
+static const char* outputSchemas[] = {
+    R"({
+        "type": "object",
+        "properties": {
+            "devices": {
+                "type": "array",
+                "items": {
+                    "type": "object",
+                    "properties": {
+                        "index": { "type": "integer" },
+                        "features": {
+                            "type": "array",
+                            "items": {
+                                "type": "object",
+                                "properties": {
+                                    "type": { "type": "integer", "description": "ctl_3d_feature_t" },
+                                    "name": { "type": "string" },
+                                    "valueType": { "type": "integer", "description": "ctl_property_value_type_t" },
+                                    "customValueSize": { "type": "integer" },
+                                    "perAppSupport": { "type": "boolean" },
+                                    "conflictingFeatures": { "type": "integer" },
+                                    "miscSupport": { "type": "integer" }
+                                },
+                                "required": ["type", "name", "valueType", "customValueSize", "perAppSupport", "conflictingFeatures", "miscSupport"]
+                            }
+                        }
+                    },
+                    "required": ["index", "features"]
+                }
+            }
+        },
+        "required": ["devices"]
+    })"
+};
+
 const char* GetNameImpl() { return "get-3d-capabilities"; }
 const char* GetVersionImpl() { return "1.0.0"; }
 PluginType GetTypeImpl() { return PLUGIN_TYPE_TOOLS; }
 
 int InitializeImpl() {
+    // open the shared IGCL session once, a failure is retried on the first request
+    IgclSession::Instance().Acquire();
     return 1;
 }
 
 // 參考 EnduranceGaming.cpp 的 hDevice 取得方式與 reference/3D_Feature_Sample_App.cpp 的 CtlGet3DFeatureCaps 實作
-char* HandleRequestImpl(const char* req) {
-    // 1. 初始化 IGCL API
-    ctl_result_t Result = CTL_RESULT_SUCCESS;
-    ctl_device_adapter_handle_t* hDevices = nullptr;
-    uint32_t AdapterCount = 0;
-    ctl_init_args_t CtlInitArgs;
-    ctl_api_handle_t hAPIHandle;
-
-    ZeroMemory(&CtlInitArgs, sizeof(ctl_init_args_t));
-    CtlInitArgs.AppVersion = CTL_MAKE_VERSION(CTL_IMPL_MAJOR_VERSION, CTL_IMPL_MINOR_VERSION);
-    CtlInitArgs.flags = 0;
-    CtlInitArgs.Size = sizeof(CtlInitArgs);
-    CtlInitArgs.Version = 0;
-
-    Result = ctlInit(&CtlInitArgs, &hAPIHandle);
+PluginResult HandleRequestV2Impl(const PluginRequest* req, PluginBuffer* out) {
+    // 1. 取得共用的 IGCL session
+    IgclSession& session = IgclSession::Instance();
+    ctl_result_t Result = session.Open();
     if (Result != CTL_RESULT_SUCCESS) {
-        json responseContent;
-        responseContent["type"] = "text";
-        responseContent["text"] = "ctlInit failed";
-        json response;
-        response["content"] = json::array();
-        response["content"].push_back(responseContent);
-        response["isError"] = true;
-        std::string result = response.dump();
-        char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-        strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-        strcpy(buffer, result.c_str());
-#endif
-        return buffer;
+        return WriteTextResult(out, "ctlInit failed", true);
     }
 
-    // 2. Enumerate devices
-    Result = ctlEnumerateDevices(hAPIHandle, &AdapterCount, hDevices);
-    hDevices = (ctl_device_adapter_handle_t*)malloc(sizeof(ctl_device_adapter_handle_t) * AdapterCount);
-    Result = ctlEnumerateDevices(hAPIHandle, &AdapterCount, hDevices);
-    if (Result != CTL_RESULT_SUCCESS || AdapterCount == 0) {
-        json responseContent;
-        responseContent["type"] = "text";
-        responseContent["text"] = "No device found";
-        json response;
-        response["content"] = json::array();
-        response["content"].push_back(responseContent);
-        response["isError"] = true;
-        std::string result = response.dump();
-        char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-        strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-        strcpy(buffer, result.c_str());
-#endif
-        return buffer;
+    // 2. Enumerate devices (cached by the session)
+    std::shared_ptr<const IgclSession::Devices> devices;
+    Result = session.GetDevices(devices);
+    if (Result != CTL_RESULT_SUCCESS || devices->handles.empty()) {
+        return WriteTextResult(out, "No device found", true);
     }
+    uint32_t AdapterCount = static_cast<uint32_t>(devices->handles.size());
 
-    // 3. 查詢每個 device 的 3D capabilities
-    std::ostringstream oss;
+    // 3. 查詢每個 device 的 3D capabilities, 同一個 adapter 與 driver 版本只向 driver 查詢一次
+    json result = {{"devices", json::array()}};
     for (uint32_t i = 0; i < AdapterCount; ++i) {
-        ctl_3d_feature_caps_t FeatureCaps3D = { 0 };
-        FeatureCaps3D.Size = sizeof(ctl_3d_feature_caps_t);
-        Result = ctlGetSupported3DCapabilities(hDevices[i], &FeatureCaps3D);
+        std::shared_ptr<const IgclSession::Capabilities> capabilities;
+        Result = session.GetCapabilities(*devices, i, capabilities);
         if (Result != CTL_RESULT_SUCCESS) continue;
-        FeatureCaps3D.pFeatureDetails = (ctl_3d_feature_details_t*)malloc(sizeof(ctl_3d_feature_details_t) * FeatureCaps3D.NumSupportedFeatures);
-        if (!FeatureCaps3D.pFeatureDetails) continue;
-        memset(FeatureCaps3D.pFeatureDetails, 0x0, sizeof(ctl_3d_feature_details_t) * FeatureCaps3D.NumSupportedFeatures);
-        Result = ctlGetSupported3DCapabilities(hDevices[i], &FeatureCaps3D);
-        if (Result == CTL_RESULT_SUCCESS) {
-            oss << "Device Index: " << i << "\n";
-            for (uint32_t j = 0; j < FeatureCaps3D.NumSupportedFeatures; ++j) {
-                const auto& detail = FeatureCaps3D.pFeatureDetails[j];
-                oss << "  Feature: " << Get3DFeatureName(detail.FeatureType) << " (Type: " << detail.FeatureType << ")\n";
-                oss << "    Value Type: " << detail.ValueType << "\n";
-                oss << "    Custom Value Size: " << detail.CustomValueSize << "\n";
-                oss << "    Per App Support: " << (detail.PerAppSupport ? "Yes" : "No") << "\n";
-                oss << "    Conflicting Features: " << detail.ConflictingFeatures << "\n";
-                oss << "    Misc Support: " << detail.FeatureMiscSupport << "\n";
-            }
-            oss << "\n";
+        json features = json::array();
+        for (const auto& detail : *capabilities) {
+            features.push_back({
+                {"type", detail.FeatureType},
+                {"name", Get3DFeatureName(detail.FeatureType)},
+                {"valueType", detail.ValueType},
+                {"customValueSize", detail.CustomValueSize},
+                {"perAppSupport", static_cast<bool>(detail.PerAppSupport)},
+                {"conflictingFeatures", detail.ConflictingFeatures},
+                {"miscSupport", detail.FeatureMiscSupport}
+            });
         }
-        free(FeatureCaps3D.pFeatureDetails);
+        result["devices"].push_back({{"index", i}, {"features", std::move(features)}});
     }
-    free(hDevices);
-
-    std::string text = oss.str();
-    if (text.empty()) text = "No 3D feature capabilities found.";
-
-    json responseContent;
-    responseContent["type"] = "text";
-    responseContent["text"] = text;
-
-    json response;
-    response["content"] = json::array();
-    response["content"].push_back(responseContent);
-    response["isError"] = false;
-
-    std::string result = response.dump();
-    char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-    strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-    strcpy(buffer, result.c_str());
-#endif
-    return buffer;
+
+    std::string summary = "3D features supported by " + std::to_string(result["devices"].size()) + " of " + std::to_string(AdapterCount) + " adapters.";
+    return WriteStructuredResult(out, std::move(result), summary, false);
 }
 
-void ShutdownImpl() {}
+char* HandleRequestImpl(const char* req) {
+    return HandleRequestV1(HandleRequestV2Impl, req);
+}
+
+void ShutdownImpl() {
+    IgclSession::Instance().Release();
+}
 
 int GetToolCountImpl() {
     return sizeof(methods) / sizeof(methods[0]);
@@ -186,3 +168,19 @@ extern "C" PLUGIN_API PluginAPI* CreatePlugin() {
 extern "C" PLUGIN_API void DestroyPlugin(PluginAPI*) {
     // Nothing to clean up for this example
 }
+
+const char* GetToolOutputSchemaImpl(int index) {
+    if (index < 0 || index >= GetToolCountImpl()) return nullptr;
+    return outputSchemas[index];
+}
+
+static const PluginExtensions extensions = {
+    PLUGIN_ABI_VERSION,
+    sizeof(PluginExtensions),
+    HandleRequestV2Impl,
+    GetToolOutputSchemaImpl
+};
+
+extern "C" PLUGIN_API const PluginExtensions* GetPluginExtensions() {
+    return &extensions;
+}
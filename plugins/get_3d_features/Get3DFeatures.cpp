@@ -0,0 +1,279 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cstdio>
+#include "PluginAPI.h"
+#include "json.hpp"
+
+#include <igcl_api.h>
+#include <GenericIGCLApp.h>
+#include "IgclSession.h"
+#include "PluginResponse.h"
+#include "DeviceFilter.h"
+
+using json = nlohmann::json;
+
+// 讀取所有 adapter 目前的 3D 設定: every supported feature of every adapter in one call,
+// with the driver values the set_* tools write
+
+static PluginTool methods[] = {
+    {
+        "get_3d_features",
+        "取得所有裝置目前的3D設定 (Get the current value of every supported 3D feature on every adapter, or on the selected ones)",
+        R"({
+            "$schema": "http://json-schema.org/draft-07/schema#",
+            "type": "object",
+            "properties": {
+                "devices": { "type": "array", "items": { "type": "integer", "minimum": 0 }, "uniqueItems": true, "description": "Indices of the adapters to read, all adapters when omitted" },
+                "parallel": { "type": "boolean", "description": "Read the adapters concurrently, true by default" }
+            },
+            "additionalProperties": false
+        })"
+    }
+};
+
+// structuredContent of get_3d_features: the current settings of every device
+static const char* outputSchemas[] = {
+    R"({
+        "type": "object",
+        "properties": {
+            "devices": {
+                "type": "array",
+                "items": {
+                    "type": "object",
+                    "properties": {
+                        "index": { "type": "integer" },
+                        "result": { "type": "integer", "description": "ctl_result_t of the capabilities query" },
+                        "features": {
+                            "type": "array",
+                            "items": {
+                                "type": "object",
+                                "properties": {
+                                    "type": { "type": "integer", "description": "ctl_3d_feature_t" },
+                                    "name": { "type": "string" },
+                                    "valueType": { "type": "integer", "description": "ctl_property_value_type_t" },
+                                    "result": { "type": "integer", "description": "ctl_result_t of the read" },
+                                    "value": { "description": "bool: boolean; enum: the driver value (flags for the flip modes); int32, uint32, float: { enable, value }; endurance gaming: { control, mode }; other custom values: hex bytes" }
+                                },
+                                "required": ["type", "name", "valueType", "result"]
+                            }
+                        }
+                    },
+                    "required": ["index", "result", "features"]
+                }
+            }
+        },
+        "required": ["devices"]
+    })"
+};
+
+const char* GetNameImpl() { return "get-3d-features"; }
+const char* GetVersionImpl() { return "1.0.0"; }
+PluginType GetTypeImpl() { return PLUGIN_TYPE_TOOLS; }
+
+int InitializeImpl() {
+    // open the shared IGCL session once, a failure is retried on the first request
+    IgclSession::Instance().Acquire();
+    return 1;
+}
+
+// The value read for a feature, in the form described by the output schema
+static json ToJson(const ctl_3d_feature_getset_t& property, const std::vector<uint8_t>& custom) {
+    const ctl_property_t& value = property.Value;
+    switch (property.ValueType) {
+        case CTL_PROPERTY_VALUE_TYPE_BOOL:
+            return static_cast<bool>(value.BoolType.Enable);
+        case CTL_PROPERTY_VALUE_TYPE_FLOAT:
+            return {{"enable", static_cast<bool>(value.FloatType.Enable)}, {"value", value.FloatType.Value}};
+        case CTL_PROPERTY_VALUE_TYPE_INT32:
+            return {{"enable", static_cast<bool>(value.IntType.Enable)}, {"value", value.IntType.Value}};
+        case CTL_PROPERTY_VALUE_TYPE_UINT32:
+            return {{"enable", static_cast<bool>(value.UIntType.Enable)}, {"value", value.UIntType.Value}};
+        case CTL_PROPERTY_VALUE_TYPE_ENUM:
+            return value.EnumType.EnableType;
+        case CTL_PROPERTY_VALUE_TYPE_CUSTOM:
+            if (property.FeatureType == CTL_3D_FEATURE_ENDURANCE_GAMING && custom.size() == sizeof(ctl_endurance_gaming_t)) {
+                const auto* EG = reinterpret_cast<const ctl_endurance_gaming_t*>(custom.data());
+                return {{"control", EG->EGControl}, {"mode", EG->EGMode}};
+            } else {
+                std::string hex;
+                char byte[3];
+                for (uint8_t c : custom) {
+                    snprintf(byte, sizeof(byte), "%02x", c);
+                    hex += byte;
+                }
+                return hex;
+            }
+        default:
+            return nullptr;
+    }
+}
+
+// Snapshot of one adapter
+struct DeviceFeatures {
+    ctl_result_t result = CTL_RESULT_SUCCESS;
+    json features = json::array();
+};
+
+PluginResult HandleRequestV4Impl(const PluginRequest* req, PluginBuffer* out, const PluginCancelToken* cancel) {
+    json arguments = json::object();
+    try {
+        json params = ParseParams(req);
+        if (params.contains("arguments") && params["arguments"].is_object()) {
+            arguments = std::move(params["arguments"]);
+        }
+    } catch (...) {
+        return WriteInvalidParams(out, "Invalid JSON request.");
+    }
+
+    // 1. 取得共用的 IGCL session
+    IgclSession& session = IgclSession::Instance();
+    ctl_result_t Result = session.Open();
+    if (Result != CTL_RESULT_SUCCESS) {
+        return WriteTextResult(out, "ctlInit failed", true);
+    }
+
+    // 2. Enumerate devices (cached by the session)
+    std::shared_ptr<const IgclSession::Devices> devices;
+    Result = session.GetDevices(devices);
+    if (Result != CTL_RESULT_SUCCESS || devices->handles.empty()) {
+        return WriteTextResult(out, "No device found", true);
+    }
+    std::vector<uint32_t> indices;
+    std::string error;
+    if (!SelectDevices(arguments, devices->handles.size(), indices, error)) {
+        return WriteInvalidParams(out, error);
+    }
+
+    // 3. 讀取每個 adapter 支援的 feature (cached capabilities), adapters are read concurrently
+    std::vector<DeviceFeatures> snapshots(devices->handles.size());
+    session.Apply(*devices, indices, [&](uint32_t index, ctl_device_adapter_handle_t) {
+        DeviceFeatures& snapshot = snapshots[index];
+        std::shared_ptr<const IgclSession::Capabilities> capabilities;
+        snapshot.result = session.GetCapabilities(*devices, index, capabilities);
+        if (snapshot.result != CTL_RESULT_SUCCESS) return snapshot.result;
+
+        for (const auto& detail : *capabilities) {
+            // 取消後不再讀取其餘的 feature, 每次讀取都是一個 IOCTL
+            if (IsCancelled(cancel)) return snapshot.result = CTL_RESULT_ERROR_UNKNOWN;
+            std::vector<uint8_t> custom;
+            ctl_3d_feature_getset_t Get3DProperty = { 0 };
+            Get3DProperty.Size = sizeof(Get3DProperty);
+            Get3DProperty.FeatureType = detail.FeatureType;
+            Get3DProperty.bSet = FALSE;
+            Get3DProperty.ValueType = detail.ValueType;
+            Get3DProperty.Version = 0;
+            if (detail.ValueType == CTL_PROPERTY_VALUE_TYPE_CUSTOM) {
+                custom.resize(detail.CustomValueSize > 0 ? detail.CustomValueSize : 0);
+                Get3DProperty.CustomValueSize = static_cast<int32_t>(custom.size());
+                Get3DProperty.pCustomValue = custom.data();
+            }
+            ctl_result_t result = session.GetSet3DFeature(*devices, index, Get3DProperty);
+
+            json feature = {
+                {"type", detail.FeatureType},
+                {"name", Get3DFeatureName(detail.FeatureType)},
+                {"valueType", detail.ValueType},
+                {"result", result}
+            };
+            if (result == CTL_RESULT_SUCCESS) feature["value"] = ToJson(Get3DProperty, custom);
+            snapshot.features.push_back(std::move(feature));
+        }
+        return CTL_RESULT_SUCCESS;
+    }, ParallelApply(arguments));
+    if (IsCancelled(cancel)) return WriteTextResult(out, "Cancelled.", true);
+
+    json result = {{"devices", json::array()}};
+    bool failed = false;
+    for (uint32_t index : indices) {
+        failed = failed || snapshots[index].result != CTL_RESULT_SUCCESS;
+        result["devices"].push_back({{"index", index}, {"result", snapshots[index].result}, {"features", std::move(snapshots[index].features)}});
+    }
+    size_t read = 0;
+    for (uint32_t index : indices) read += snapshots[index].result == CTL_RESULT_SUCCESS;
+    std::string summary = "3D feature values read on " + std::to_string(read) + " of " + std::to_string(indices.size()) + " adapters.";
+    return WriteStructuredResult(out, std::move(result), summary, failed);
+}
+
+PluginResult HandleRequestV2Impl(const PluginRequest* req, PluginBuffer* out) {
+    return HandleRequestV4Impl(req, out, nullptr);
+}
+
+char* HandleRequestImpl(const char* req) {
+    return HandleRequestV1(HandleRequestV2Impl, req);
+}
+
+void ShutdownImpl() {
+    IgclSession::Instance().Release();
+}
+
+int GetToolCountImpl() {
+    return sizeof(methods) / sizeof(methods[0]);
+}
+
+const PluginTool* GetToolImpl(int index) {
+    if (index < 0 || index >= GetToolCountImpl()) return nullptr;
+    return &methods[index];
+}
+
+static PluginAPI plugin = {
+    GetNameImpl,
+    GetVersionImpl,
+    GetTypeImpl,
+    InitializeImpl,
+    HandleRequestImpl,
+    ShutdownImpl,
+    GetToolCountImpl,
+    GetToolImpl,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr
+};
+
+extern "C" PLUGIN_API PluginAPI* CreatePlugin() {
+    return &plugin;
+}
+
+extern "C" PLUGIN_API void DestroyPlugin(PluginAPI*) {
+    // Nothing to clean up for this example
+}
+
+const char* GetToolOutputSchemaImpl(int index) {
+    if (index < 0 || index >= GetToolCountImpl()) return nullptr;
+    return outputSchemas[index];
+}
+
+static const PluginExtensions extensions = {
+    PLUGIN_ABI_VERSION,
+    sizeof(PluginExtensions),
+    HandleRequestV2Impl,
+    GetToolOutputSchemaImpl,
+    HandleRequestV4Impl
+};
+
+extern "C" PLUGIN_API const PluginExtensions* GetPluginExtensions() {
+    return &extensions;
+}
@@ -0,0 +1,458 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Your Name
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <atomic>
+#include "PluginAPI.h"
+#include "json.hpp"
+
+#include <igcl_api.h>
+#include <GenericIGCLApp.h>
+#include "IgclSession.h"
+#include "PluginResponse.h"
+#include "DeviceFilter.h"
+
+using json = nlohmann::json;
+
+// 一次呼叫套用多個 3D 設定 (e.g. a gaming profile): every change is read back before it is
+// written, and when any of them fails the ones already applied are restored in reverse order.
+
+struct FeatureSpec {
+    const char* name;
+    ctl_3d_feature_t type;
+    ctl_property_value_type_t valueType;
+};
+
+static const FeatureSpec kFeatures[] = {
+    {"frame_sync", CTL_3D_FEATURE_GAMING_FLIP_MODES, CTL_PROPERTY_VALUE_TYPE_ENUM},
+    {"anisotropic", CTL_3D_FEATURE_ANISOTROPIC, CTL_PROPERTY_VALUE_TYPE_ENUM},
+    {"frame_limit", CTL_3D_FEATURE_FRAME_LIMIT, CTL_PROPERTY_VALUE_TYPE_INT32},
+    {"endurance_gaming", CTL_3D_FEATURE_ENDURANCE_GAMING, CTL_PROPERTY_VALUE_TYPE_CUSTOM},
+    {"adaptive_tessellation", CTL_3D_FEATURE_ADAPTIVE_TESSELLATION, CTL_PROPERTY_VALUE_TYPE_BOOL},
+    {"sharpening_filter", CTL_3D_FEATURE_SHARPENING_FILTER, CTL_PROPERTY_VALUE_TYPE_BOOL}
+};
+
+// same mode indices as set_frame_sync and set_anisotropic
+static const uint32_t kFrameSyncFlags[] = {
+    CTL_GAMING_FLIP_MODE_FLAG_APPLICATION_DEFAULT,
+    CTL_GAMING_FLIP_MODE_FLAG_VSYNC_ON,
+    CTL_GAMING_FLIP_MODE_FLAG_SMOOTH_SYNC,
+    CTL_GAMING_FLIP_MODE_FLAG_CAPPED_FPS
+};
+
+static const uint32_t kAnisotropicTypes[] = {
+    CTL_3D_ANISOTROPIC_TYPES_APP_CHOICE,
+    CTL_3D_ANISOTROPIC_TYPES_2X,
+    CTL_3D_ANISOTROPIC_TYPES_4X,
+    CTL_3D_ANISOTROPIC_TYPES_8X,
+    CTL_3D_ANISOTROPIC_TYPES_16X
+};
+
+static PluginTool methods[] = {
+    {
+        "set_3d_features",
+        "Apply several 3D settings in one call, e.g. a gaming profile. All the changes are applied or none: "
+        "on a failure the settings already changed are restored, the ones the driver refused to restore are listed in restoreFailed.",
+        R"({
+            "$schema": "http://json-schema.org/draft-07/schema#",
+            "type": "object",
+            "properties": {
+                "features": {
+                    "type": "array",
+                    "minItems": 1,
+                    "items": {
+                        "type": "object",
+                        "properties": {
+                            "feature": { "type": "string", "enum": ["frame_sync", "anisotropic", "frame_limit", "endurance_gaming", "adaptive_tessellation", "sharpening_filter"] },
+                            "value": { "description": "frame_sync: 0=APPLICATION_CHOICE, 1=VSYNC_ON, 2=SMOOTH_SYNC, 3=SMART_VSYNC; anisotropic: 0=APP_CHOICE, 1=2X, 2=4X, 3=8X, 4=16X; frame_limit: fps, 0 turns it off; endurance_gaming: { \"control\": 0=OFF, 1=ON, 2=AUTO, \"mode\": 0=BETTER_PERFORMANCE, 1=BALANCED, 2=MAXIMUM_BATTERY }; adaptive_tessellation, sharpening_filter: boolean" },
+                            "devices": { "type": "array", "items": { "type": "integer", "minimum": 0 }, "uniqueItems": true, "description": "Indices of the adapters to apply to, all adapters when omitted" }
+                        },
+                        "required": ["feature", "value"],
+                        "additionalProperties": false
+                    }
+                },
+                "parallel": { "type": "boolean", "description": "Apply to the adapters concurrently, true by default" }
+            },
+            "required": ["features"],
+            "additionalProperties": false
+        })"
+    }
+};
+
+// structuredContent of set_3d_features: the outcome of every feature on every adapter
+static const char* outputSchemas[] = {
+    R"({
+        "type": "object",
+        "properties": {
+            "applied": { "type": "boolean", "description": "Every change was applied" },
+            "rolledBack": { "type": "boolean", "description": "A change failed and every change already applied was restored" },
+            "restoreFailed": {
+                "type": "array",
+                "description": "Changes left applied because their rollback failed, empty unless a change failed",
+                "items": {
+                    "type": "object",
+                    "properties": {
+                        "feature": { "type": "string" },
+                        "index": { "type": "integer" },
+                        "result": { "type": "integer", "description": "ctl_result_t of the rollback" }
+                    },
+                    "required": ["feature", "index", "result"]
+                }
+            },
+            "features": {
+                "type": "array",
+                "items": {
+                    "type": "object",
+                    "properties": {
+                        "feature": { "type": "string" },
+                        "value": {},
+                        "devices": {
+                            "type": "array",
+                            "items": {
+                                "type": "object",
+                                "properties": {
+                                    "index": { "type": "integer" },
+                                    "status": { "type": "string", "enum": ["applied", "failed", "skipped", "rolled_back", "rollback_failed"] },
+                                    "result": { "type": "integer", "description": "ctl_result_t of the set, or of the rollback when it failed" },
+                                    "changed": { "type": "boolean", "description": "Applied: false when the adapter already had the value and was not written" }
+                                },
+                                "required": ["index", "status"]
+                            }
+                        }
+                    },
+                    "required": ["feature", "value", "devices"]
+                }
+            }
+        },
+        "required": ["applied", "rolledBack", "restoreFailed", "features"]
+    })"
+};
+
+// One value of a feature, as the driver takes it
+struct Setting {
+    ctl_property_t value = {};
+    ctl_endurance_gaming_t custom = {};
+};
+
+// A feature to set on one adapter, with the value it had before
+struct Change {
+    const FeatureSpec* spec;
+    Setting target;
+    Setting previous;
+    ctl_result_t result = CTL_RESULT_SUCCESS;
+    ctl_result_t rollback = CTL_RESULT_SUCCESS;
+    bool attempted = false;
+    bool applied = false;
+    bool changed = false;   // false when the adapter already had the target value
+    bool rolledBack = false;
+};
+
+const char* GetNameImpl() { return "set-3d-features"; }
+const char* GetVersionImpl() { return "1.0.0"; }
+PluginType GetTypeImpl() { return PLUGIN_TYPE_TOOLS; }
+
+int InitializeImpl() {
+    // open the shared IGCL session once, a failure is retried on the first request
+    IgclSession::Instance().Acquire();
+    return 1;
+}
+
+static const FeatureSpec* FindFeature(const std::string& name) {
+    for (const auto& spec : kFeatures) {
+        if (name == spec.name) return &spec;
+    }
+    return nullptr;
+}
+
+// The driver value of a feature from the tool argument, false with a message when it is invalid
+static bool ToSetting(const FeatureSpec& spec, const json& value, Setting& setting, std::string& error) {
+    switch (spec.type) {
+        case CTL_3D_FEATURE_GAMING_FLIP_MODES:
+        case CTL_3D_FEATURE_ANISOTROPIC: {
+            bool frameSync = spec.type == CTL_3D_FEATURE_GAMING_FLIP_MODES;
+            int64_t count = frameSync ? std::size(kFrameSyncFlags) : std::size(kAnisotropicTypes);
+            if (!value.is_number_integer() || value.get<int64_t>() < 0 || value.get<int64_t>() >= count) {
+                error = std::string(spec.name) + " value must be 0~" + std::to_string(count - 1) + ".";
+                return false;
+            }
+            setting.value.EnumType.EnableType = frameSync ? kFrameSyncFlags[value.get<int>()] : kAnisotropicTypes[value.get<int>()];
+            return true;
+        }
+        case CTL_3D_FEATURE_FRAME_LIMIT:
+            if (!value.is_number_integer() || value.get<int64_t>() < 0 || value.get<int64_t>() > INT32_MAX) {
+                error = "frame_limit value must be a positive number of fps, or 0.";
+                return false;
+            }
+            setting.value.IntType.Enable = value.get<int64_t>() > 0;
+            setting.value.IntType.Value = value.get<int32_t>();
+            return true;
+        case CTL_3D_FEATURE_ENDURANCE_GAMING:
+            if (!value.is_object() || !value.contains("control") || !value.contains("mode") ||
+                !value["control"].is_number_integer() || !value["mode"].is_number_integer()) {
+                error = "endurance_gaming value must be { \"control\": integer, \"mode\": integer }.";
+                return false;
+            }
+            if (value["control"].get<int64_t>() < 0 || value["control"].get<int64_t>() >= CTL_3D_ENDURANCE_GAMING_CONTROL_MAX ||
+                value["mode"].get<int64_t>() < 0 || value["mode"].get<int64_t>() >= CTL_3D_ENDURANCE_GAMING_MODE_MAX) {
+                error = "endurance_gaming control must be 0~" + std::to_string(CTL_3D_ENDURANCE_GAMING_CONTROL_MAX - 1) +
+                        " and mode 0~" + std::to_string(CTL_3D_ENDURANCE_GAMING_MODE_MAX - 1) + ".";
+                return false;
+            }
+            setting.custom.EGControl = static_cast<ctl_3d_endurance_gaming_control_t>(value["control"].get<int>());
+            setting.custom.EGMode = static_cast<ctl_3d_endurance_gaming_mode_t>(value["mode"].get<int>());
+            return true;
+        default:
+            if (!value.is_boolean()) {
+                error = std::string(spec.name) + " value must be a boolean.";
+                return false;
+            }
+            setting.value.BoolType.Enable = value.get<bool>();
+            return true;
+    }
+}
+
+// Read (set false) or write (set true) one feature of an adapter, a write of the value it
+// already has is skipped by the session
+static ctl_result_t GetSet(const IgclSession::Devices& devices, uint32_t index, const FeatureSpec& spec, Setting& setting, bool set,
+                           bool* skipped = nullptr) {
+    ctl_3d_feature_getset_t property = { 0 };
+    property.Size = sizeof(property);
+    property.FeatureType = spec.type;
+    property.bSet = set;
+    property.ValueType = spec.valueType;
+    property.Version = 0;
+    if (spec.valueType == CTL_PROPERTY_VALUE_TYPE_CUSTOM) {
+        property.CustomValueSize = sizeof(setting.custom);
+        property.pCustomValue = &setting.custom;
+    } else {
+        property.Value = setting.value;
+    }
+
+    ctl_result_t result = IgclSession::Instance().GetSet3DFeature(devices, index, property, skipped);
+    if (!set && result == CTL_RESULT_SUCCESS && spec.valueType != CTL_PROPERTY_VALUE_TYPE_CUSTOM) {
+        setting.value = property.Value;
+    }
+    return result;
+}
+
+PluginResult HandleRequestV4Impl(const PluginRequest* req, PluginBuffer* out, const PluginCancelToken* cancel) {
+    json arguments;
+    try {
+        json params = ParseParams(req);
+        arguments = std::move(params["arguments"]);
+    } catch (...) {
+        return WriteInvalidParams(out, "Invalid JSON request.");
+    }
+    if (!arguments.is_object() || !arguments.contains("features") || !arguments["features"].is_array() || arguments["features"].empty()) {
+        return WriteInvalidParams(out, "features must be a non-empty array.");
+    }
+    const json& features = arguments["features"];
+
+    // 1. 取得共用的 IGCL session 與 cached devices, 所有的設定共用同一次 enumerate
+    IgclSession& session = IgclSession::Instance();
+    ctl_result_t Result = session.Open();
+    if (Result != CTL_RESULT_SUCCESS) {
+        return WriteTextResult(out, "ctlInit failed", true);
+    }
+    std::shared_ptr<const IgclSession::Devices> devices;
+    Result = session.GetDevices(devices);
+    if (Result != CTL_RESULT_SUCCESS || devices->handles.empty()) {
+        return WriteTextResult(out, "No device found", true);
+    }
+
+    // 2. 檢查所有的參數, nothing is touched unless the whole list is valid
+    std::vector<std::vector<Change>> changes(features.size()); // per feature, in the order of its devices
+    std::vector<std::vector<uint32_t>> targets(features.size());
+    std::vector<std::vector<Change*>> perDevice(devices->handles.size()); // per adapter, in the order of the features
+    for (size_t i = 0; i < features.size(); ++i) {
+        const json& feature = features[i];
+        std::string error;
+        if (!feature.is_object() || !feature.contains("feature") || !feature["feature"].is_string() || !feature.contains("value")) {
+            return WriteInvalidParams(out, "Every feature needs a \"feature\" name and a \"value\".");
+        }
+        const FeatureSpec* spec = FindFeature(feature["feature"].get<std::string>());
+        if (!spec) {
+            return WriteInvalidParams(out, "Unknown feature " + feature["feature"].dump() + ".");
+        }
+        Setting target;
+        if (!ToSetting(*spec, feature["value"], target, error) ||
+            !SelectDevices(feature, devices->handles.size(), targets[i], error)) {
+            return WriteInvalidParams(out, error);
+        }
+        changes[i].resize(targets[i].size(), Change{spec, target});
+    }
+    for (size_t i = 0; i < features.size(); ++i) {
+        for (size_t j = 0; j < targets[i].size(); ++j) {
+            perDevice[targets[i][j]].push_back(&changes[i][j]);
+        }
+    }
+    std::vector<uint32_t> indices;
+    for (uint32_t index = 0; index < perDevice.size(); ++index) {
+        if (!perDevice[index].empty()) indices.push_back(index);
+    }
+    bool parallel = ParallelApply(arguments);
+
+    // 3. 每個 adapter 依序套用它的設定, adapters run concurrently; a failure anywhere stops the others.
+    //    A cancel counts as a failure: what was applied is rolled back, the rollback itself is never cancelled
+    std::atomic<bool> failed{false};
+    session.Apply(*devices, indices, [&](uint32_t index, ctl_device_adapter_handle_t) {
+        for (Change* change : perDevice[index]) {
+            if (IsCancelled(cancel)) failed = true;
+            if (failed.load()) break;
+            change->attempted = true;
+            change->previous = change->target; // the custom value is read into the same layout
+            change->result = GetSet(*devices, index, *change->spec, change->previous, false);
+            bool skipped = false;
+            if (change->result == CTL_RESULT_SUCCESS) {
+                change->result = GetSet(*devices, index, *change->spec, change->target, true, &skipped);
+            }
+            if (change->result != CTL_RESULT_SUCCESS) {
+                failed = true;
+                return change->result;
+            }
+            change->applied = true;
+            change->changed = !skipped;
+        }
+        return CTL_RESULT_SUCCESS;
+    }, parallel);
+
+    // 4. 失敗時還原已套用的設定, newest first on every adapter
+    if (failed) {
+        std::vector<uint32_t> applied;
+        for (uint32_t index : indices) {
+            // an adapter stops at its first failure: if its first change was not applied, none was
+            if (!perDevice[index].empty() && perDevice[index].front()->applied) applied.push_back(index);
+        }
+        session.Apply(*devices, applied, [&](uint32_t index, ctl_device_adapter_handle_t) {
+            ctl_result_t result = CTL_RESULT_SUCCESS;
+            for (auto it = perDevice[index].rbegin(); it != perDevice[index].rend(); ++it) {
+                Change* change = *it;
+                if (!change->applied) continue;
+                change->rollback = GetSet(*devices, index, *change->spec, change->previous, true);
+                change->rolledBack = change->rollback == CTL_RESULT_SUCCESS;
+                if (!change->rolledBack) result = change->rollback;
+            }
+            return result;
+        }, parallel);
+    }
+
+    json result = {{"applied", !failed}, {"features", json::array()}};
+    json restoreFailed = json::array();
+    std::string notRestored;
+    for (size_t i = 0; i < features.size(); ++i) {
+        json entry = {{"feature", features[i]["feature"]}, {"value", features[i]["value"]}, {"devices", json::array()}};
+        for (size_t j = 0; j < targets[i].size(); ++j) {
+            const Change& change = changes[i][j];
+            json device = {{"index", targets[i][j]}};
+            if (!change.attempted) {
+                device["status"] = "skipped";
+            } else if (!change.applied) {
+                device["status"] = "failed";
+                device["result"] = change.result;
+            } else if (!failed) {
+                device["status"] = "applied";
+                device["result"] = change.result;
+                device["changed"] = change.changed;
+            } else if (change.rolledBack) {
+                device["status"] = "rolled_back";
+                device["result"] = change.result;
+            } else {
+                device["status"] = "rollback_failed";
+                device["result"] = change.rollback;
+                restoreFailed.push_back({{"feature", change.spec->name}, {"index", targets[i][j]}, {"result", change.rollback}});
+                notRestored += (notRestored.empty() ? " " : ", ") + std::string(change.spec->name) + " on adapter " + std::to_string(targets[i][j]);
+            }
+            entry["devices"].push_back(std::move(device));
+        }
+        result["features"].push_back(std::move(entry));
+    }
+
+    // a failed rollback leaves the adapter half changed, the caller is told which settings stayed
+    result["rolledBack"] = failed && restoreFailed.empty();
+    result["restoreFailed"] = std::move(restoreFailed);
+    std::string summary = !failed ? std::to_string(features.size()) + " settings applied."
+                        : notRestored.empty() ? "Settings not applied, the changes were rolled back."
+                        : "Settings not applied, could not restore" + notRestored + ".";
+    return WriteStructuredResult(out, std::move(result), summary, failed.load());
+}
+
+PluginResult HandleRequestV2Impl(const PluginRequest* req, PluginBuffer* out) {
+    return HandleRequestV4Impl(req, out, nullptr);
+}
+
+char* HandleRequestImpl(const char* req) {
+    return HandleRequestV1(HandleRequestV2Impl, req);
+}
+
+void ShutdownImpl() {
+    IgclSession::Instance().Release();
+}
+
+int GetToolCountImpl() {
+    return sizeof(methods) / sizeof(methods[0]);
+}
+
+const PluginTool* GetToolImpl(int index) {
+    if (index < 0 || index >= GetToolCountImpl()) return nullptr;
+    return &methods[index];
+}
+
+static PluginAPI plugin = {
+    GetNameImpl,
+    GetVersionImpl,
+    GetTypeImpl,
+    InitializeImpl,
+    HandleRequestImpl,
+    ShutdownImpl,
+    GetToolCountImpl,
+    GetToolImpl,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr
+};
+
+extern "C" PLUGIN_API PluginAPI* CreatePlugin() {
+    return &plugin;
+}
+
+extern "C" PLUGIN_API void DestroyPlugin(PluginAPI*) {
+    // Nothing to clean up for this example
+}
+
+const char* GetToolOutputSchemaImpl(int index) {
+    if (index < 0 || index >= GetToolCountImpl()) return nullptr;
+    return outputSchemas[index];
+}
+
+static const PluginExtensions extensions = {
+    PLUGIN_ABI_VERSION,
+    sizeof(PluginExtensions),
+    HandleRequestV2Impl,
+    GetToolOutputSchemaImpl,
+    HandleRequestV4Impl
+};
+
+extern "C" PLUGIN_API const PluginExtensions* GetPluginExtensions() {
+    return &extensions;
+}
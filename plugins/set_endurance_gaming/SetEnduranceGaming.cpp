@@ -31,6 +31,9 @@
 // 請根據你的專案 include 對應的 IGCL API 標頭檔
 #include <igcl_api.h>
 #include <GenericIGCLApp.h>
+#include "IgclSession.h"
+#include "PluginResponse.h"
+#include "DeviceFilter.h"
 
 using json = nlohmann::json;
 
@@ -38,13 +41,14 @@ using json = nlohmann::json;
 static PluginTool methods[] = {
     {
         "set_endurance_gaming_mode",
-        "Set or cycle Endurance Gaming mode and control for a device.",
+        "Set or cycle Endurance Gaming mode and control on every adapter, or on the selected ones.",
         R"({
             "$schema": "http://json-schema.org/draft-07/schema#",
             "type": "object",
             "properties": {
                 "control": { "type": "integer", "description": "Control value: 0=OFF, 1=ON, 2=AUTO" },
-                "mode": { "type": "integer", "description": "Mode value: 0=BETTER_PERFORMANCE, 1=BALANCED, 2=MAXIMUM_BATTERY" }
+                "mode": { "type": "integer", "description": "Mode value: 0=BETTER_PERFORMANCE, 1=BALANCED, 2=MAXIMUM_BATTERY" },
+                )" DEVICE_FILTER_SCHEMA_PROPERTIES R"(
             },
             "required": ["control", "mode"],
             "additionalProperties": false
@@ -52,121 +56,113 @@ static PluginTool methods[] = {
     }
 };
 
+// structuredContent of set_endurance_gaming_mode: the values applied and the outcome on every device
+static const char* outputSchemas[] = {
+    R"({
+        "type": "object",
+        "properties": {
+            "control": { "type": "integer" },
+            "mode": { "type": "integer" },
+            "devices": {
+                "type": "array",
+                "items": {
+                    "type": "object",
+                    "properties": {
+                        "index": { "type": "integer" },
+                        "success": { "type": "boolean" },
+                        "result": { "type": "integer", "description": "ctl_result_t of the driver call" },
+                        "changed": { "type": "boolean", "description": "false when the adapter already had this setting and the driver was not called" }
+                    },
+                    "required": ["index", "success", "result"]
+                }
+            }
+        },
+        "required": ["control", "mode", "devices"]
+    })"
+};
+
 const char* GetNameImpl() { return "endurance-gaming-tools"; }
 const char* GetVersionImpl() { return "1.0.0"; }
 PluginType GetTypeImpl() { return PLUGIN_TYPE_TOOLS; }
 
 int InitializeImpl() {
-    // 這裡可初始化 IGCL API
+    // open the shared IGCL session once, a failure is retried on the first request
+    IgclSession::Instance().Acquire();
     return 1;
 }
 
-char* HandleRequestImpl(const char* req) {
-    json request = json::parse(req);
-    int control = request["params"]["arguments"]["control"].get<int>();
-    int mode = request["params"]["arguments"]["mode"].get<int>();
-
-    // 初始化 API
-    ctl_result_t Result = CTL_RESULT_SUCCESS;
-    ctl_device_adapter_handle_t* hDevices = nullptr;
-    uint32_t AdapterCount = 0;
-    ctl_init_args_t CtlInitArgs;
-    ctl_api_handle_t hAPIHandle;
-
-    ZeroMemory(&CtlInitArgs, sizeof(ctl_init_args_t));
-    CtlInitArgs.AppVersion = CTL_MAKE_VERSION(CTL_IMPL_MAJOR_VERSION, CTL_IMPL_MINOR_VERSION);
-    CtlInitArgs.flags = 0;
-    CtlInitArgs.Size = sizeof(CtlInitArgs);
-    CtlInitArgs.Version = 0;
-
-    Result = ctlInit(&CtlInitArgs, &hAPIHandle);
+PluginResult HandleRequestV2Impl(const PluginRequest* req, PluginBuffer* out) {
+    int control = 0;
+    int mode = 0;
+    json arguments;
+    try {
+        json params = ParseParams(req);
+        arguments = std::move(params["arguments"]);
+        control = arguments["control"].get<int>();
+        mode = arguments["mode"].get<int>();
+    } catch (...) {
+        return WriteInvalidParams(out, "Invalid JSON request.");
+    }
+
+    // 取得共用的 IGCL session
+    IgclSession& session = IgclSession::Instance();
+    ctl_result_t Result = session.Open();
     if (Result != CTL_RESULT_SUCCESS) {
-        json responseContent;
-        responseContent["type"] = "text";
-        responseContent["text"] = "ctlInit failed";
-        json response;
-        response["content"] = json::array();
-        response["content"].push_back(responseContent);
-        response["isError"] = true;
-        std::string result = response.dump();
-        char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-        strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-        strcpy(buffer, result.c_str());
-#endif
-        return buffer;
+        return WriteTextResult(out, "ctlInit failed", true);
     }
 
-    Result = ctlEnumerateDevices(hAPIHandle, &AdapterCount, hDevices);
-    hDevices = (ctl_device_adapter_handle_t*)malloc(sizeof(ctl_device_adapter_handle_t) * AdapterCount);
-    Result = ctlEnumerateDevices(hAPIHandle, &AdapterCount, hDevices);
-    if (Result != CTL_RESULT_SUCCESS || AdapterCount == 0) {
-        json responseContent;
-        responseContent["type"] = "text";
-        responseContent["text"] = "No device found";
-        json response;
-        response["content"] = json::array();
-        response["content"].push_back(responseContent);
-        response["isError"] = true;
-        std::string result = response.dump();
-        char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-        strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-        strcpy(buffer, result.c_str());
-#endif
-        return buffer;
+    std::shared_ptr<const IgclSession::Devices> devices;
+    Result = session.GetDevices(devices);
+    if (Result != CTL_RESULT_SUCCESS || devices->handles.empty()) {
+        return WriteTextResult(out, "No device found", true);
     }
+    std::vector<uint32_t> indices;
+    std::string error;
+    if (!SelectDevices(arguments, devices->handles.size(), indices, error)) {
+        return WriteInvalidParams(out, error);
+    }
+
+    // 寫入新值, 多個 adapter 同時進行; control and mode are both replaced so the current
+    // value is not read first, and an adapter that already has them is not called
+    std::vector<char> unchanged(devices->handles.size(), 0);
+    std::vector<ctl_result_t> results = session.Apply(*devices, indices, [&](uint32_t index, ctl_device_adapter_handle_t) {
+        ctl_endurance_gaming_t EG = {};
+        EG.EGControl = static_cast<ctl_3d_endurance_gaming_control_t>(control);
+        EG.EGMode = static_cast<ctl_3d_endurance_gaming_mode_t>(mode);
+
+        ctl_3d_feature_getset_t Set3DProperty = { 0 };
+        Set3DProperty.Size = sizeof(Set3DProperty);
+        Set3DProperty.FeatureType = CTL_3D_FEATURE_ENDURANCE_GAMING;
+        Set3DProperty.bSet = TRUE;
+        Set3DProperty.CustomValueSize = sizeof(ctl_endurance_gaming_t);
+        Set3DProperty.pCustomValue = &EG;
+        Set3DProperty.ValueType = CTL_PROPERTY_VALUE_TYPE_CUSTOM;
+        Set3DProperty.Version = 0;
+        bool skipped = false;
+        ctl_result_t result = session.GetSet3DFeature(*devices, index, Set3DProperty, &skipped);
+        unchanged[index] = skipped;
+        return result;
+    }, ParallelApply(arguments));
+
+    json result = {{"control", control}, {"mode", mode}, {"devices", json::array()}};
+    bool failed = false;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        failed = failed || results[i] != CTL_RESULT_SUCCESS;
+        result["devices"].push_back({{"index", indices[i]}, {"success", results[i] == CTL_RESULT_SUCCESS}, {"result", results[i]},
+                                     {"changed", results[i] == CTL_RESULT_SUCCESS && !unchanged[indices[i]]}});
+    }
+    std::string summary = "Endurance Gaming set to control " + std::to_string(control) + ", mode " + std::to_string(mode) + " "
+                          + AdaptersSummary(result["devices"]) + ".";
+    return WriteStructuredResult(out, std::move(result), summary, failed);
+}
 
-    // 只對第一個 device 設定
-    ctl_endurance_gaming_t EG = {};
-    ctl_3d_feature_getset_t Set3DProperty = { 0 };
-    ctl_3d_feature_getset_t Get3DProperty = { 0 };
-    Get3DProperty.Size = sizeof(Get3DProperty);
-    Get3DProperty.FeatureType = CTL_3D_FEATURE_ENDURANCE_GAMING;
-    Get3DProperty.bSet = FALSE;
-    Get3DProperty.CustomValueSize = sizeof(ctl_endurance_gaming_t);
-    Get3DProperty.pCustomValue = &EG;
-    Get3DProperty.ValueType = CTL_PROPERTY_VALUE_TYPE_CUSTOM;
-    Result = ctlGetSet3DFeature(hDevices[0], &Get3DProperty);
-
-    // 設定新值
-    EG.EGControl = static_cast<ctl_3d_endurance_gaming_control_t>(control);
-    EG.EGMode = static_cast<ctl_3d_endurance_gaming_mode_t>(mode);
-
-    Set3DProperty.Size = sizeof(Set3DProperty);
-    Set3DProperty.FeatureType = CTL_3D_FEATURE_ENDURANCE_GAMING;
-    Set3DProperty.bSet = TRUE;
-    Set3DProperty.CustomValueSize = sizeof(ctl_endurance_gaming_t);
-    Set3DProperty.pCustomValue = &EG;
-    Set3DProperty.ValueType = CTL_PROPERTY_VALUE_TYPE_CUSTOM;
-    Set3DProperty.Version = 0;
-
-    Result = ctlGetSet3DFeature(hDevices[0], &Set3DProperty);
-
-    json responseContent;
-    responseContent["type"] = "text";
-    responseContent["text"] = (Result == CTL_RESULT_SUCCESS)
-        ? "Endurance Gaming mode/control set successfully."
-        : "Failed to set Endurance Gaming mode/control.";
-
-    json response;
-    response["content"] = json::array();
-    response["content"].push_back(responseContent);
-    response["isError"] = (Result != CTL_RESULT_SUCCESS);
-
-    std::string result = response.dump();
-    char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-    strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-    strcpy(buffer, result.c_str());
-#endif
-    return buffer;
+char* HandleRequestImpl(const char* req) {
+    return HandleRequestV1(HandleRequestV2Impl, req);
 }
 
-void ShutdownImpl() {}
+void ShutdownImpl() {
+    IgclSession::Instance().Release();
+}
 
 int GetToolCountImpl() {
     return sizeof(methods) / sizeof(methods[0]);
@@ -199,3 +195,19 @@ extern "C" PLUGIN_API PluginAPI* CreatePlugin() {
 extern "C" PLUGIN_API void DestroyPlugin(PluginAPI*) {
     // Nothing to clean up for this example
 }
+
+const char* GetToolOutputSchemaImpl(int index) {
+    if (index < 0 || index >= GetToolCountImpl()) return nullptr;
+    return outputSchemas[index];
+}
+
+static const PluginExtensions extensions = {
+    PLUGIN_ABI_VERSION,
+    sizeof(PluginExtensions),
+    HandleRequestV2Impl,
+    GetToolOutputSchemaImpl
+};
+
+extern "C" PLUGIN_API const PluginExtensions* GetPluginExtensions() {
+    return &extensions;
+}
@@ -28,6 +28,9 @@
 
 #include <igcl_api.h>
 #include <GenericIGCLApp.h>
+#include "IgclSession.h"
+#include "PluginResponse.h"
+#include "DeviceFilter.h"
 
 using json = nlohmann::json;
 
@@ -47,12 +50,13 @@ static const FrameSyncMode kFrameSyncModes[] = {
 static PluginTool methods[] = {
     {
         "set_frame_sync",
-        "Set Frame Sync mode for a device.",
+        "Set Frame Sync mode on every adapter, or on the selected ones.",
         R"({
             "$schema": "http://json-schema.org/draft-07/schema#",
             "type": "object",
             "properties": {
-                "mode": { "type": "integer", "description": "Mode value: 0=APPLICATION_CHOICE, 1=VSYNC_ON, 2=SMOOTH_SYNC, 3=SMART_VSYNC" }
+                "mode": { "type": "integer", "description": "Mode value: 0=APPLICATION_CHOICE, 1=VSYNC_ON, 2=SMOOTH_SYNC, 3=SMART_VSYNC" },
+                )" DEVICE_FILTER_SCHEMA_PROPERTIES R"(
             },
             "required": ["mode"],
             "additionalProperties": false
@@ -60,11 +64,39 @@ static PluginTool methods[] = {
     }
 };
 
+// structuredContent of set_frame_sync: the mode applied and the outcome on every device
+static const char* outputSchemas[] = {
+    R"({
+        "type": "object",
+        "properties": {
+            "mode": { "type": "integer" },
+            "modeName": { "type": "string" },
+            "flag": { "type": "integer", "description": "Driver flag of the mode" },
+            "devices": {
+                "type": "array",
+                "items": {
+                    "type": "object",
+                    "properties": {
+                        "index": { "type": "integer" },
+                        "success": { "type": "boolean" },
+                        "result": { "type": "integer", "description": "ctl_result_t of the driver call" },
+                        "changed": { "type": "boolean", "description": "false when the adapter already had this mode and the driver was not called" }
+                    },
+                    "required": ["index", "success", "result"]
+                }
+            }
+        },
+        "required": ["mode", "modeName", "flag", "devices"]
+    })"
+};
+
 const char* GetNameImpl() { return "set-frame-sync"; }
 const char* GetVersionImpl() { return "1.0.0"; }
 PluginType GetTypeImpl() { return PLUGIN_TYPE_TOOLS; }
 
 int InitializeImpl() {
+    // open the shared IGCL session once, a failure is retried on the first request
+    IgclSession::Instance().Acquire();
     return 1;
 }
 
@@ -79,110 +111,47 @@ const char* GetModeNameByIndex(int mode) {
     return kFrameSyncModes[mode].name;
 }
 
-char* HandleRequestImpl(const char* req) {
-    json request;
+PluginResult HandleRequestV2Impl(const PluginRequest* req, PluginBuffer* out) {
     int mode = -1;
+    json arguments = json::object();
     try {
-        request = json::parse(req);
-        if (request.contains("mode")) {
-            mode = request.value("mode", -1);
-        } else if (request.contains("params") && request["params"].contains("arguments") && request["params"]["arguments"].contains("mode")) {
-            mode = request["params"]["arguments"].value("mode", -1);
+        json params = ParseParams(req);
+        if (params.contains("arguments") && params["arguments"].is_object()) {
+            arguments = std::move(params["arguments"]);
+            mode = arguments.value("mode", -1);
         }
     } catch (...) {
-        json responseContent;
-        responseContent["type"] = "text";
-        responseContent["text"] = "Invalid JSON request.";
-        json response;
-        response["content"] = json::array();
-        response["content"].push_back(responseContent);
-        response["isError"] = true;
-        std::string result = response.dump();
-        char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-        strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-        strcpy(buffer, result.c_str());
-#endif
-        return buffer;
+        return WriteInvalidParams(out, "Invalid JSON request.");
     }
 
     uint32_t mode_flag = GetModeFlag(mode);
     if (mode_flag == 0xFFFFFFFF) {
-        json responseContent;
-        responseContent["type"] = "text";
-        responseContent["text"] = "Unsupported mode. Mode value must be 0~3.";
-        json response;
-        response["content"] = json::array();
-        response["content"].push_back(responseContent);
-        response["isError"] = true;
-        std::string result = response.dump();
-        char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-        strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-        strcpy(buffer, result.c_str());
-#endif
-        return buffer;
+        return WriteInvalidParams(out, "Unsupported mode. Mode value must be 0~3.");
     }
 
-    // 1. 初始化 IGCL API
-    ctl_result_t Result = CTL_RESULT_SUCCESS;
-    ctl_device_adapter_handle_t* hDevices = nullptr;
-    uint32_t AdapterCount = 0;
-    ctl_init_args_t CtlInitArgs;
-    ctl_api_handle_t hAPIHandle;
-
-    ZeroMemory(&CtlInitArgs, sizeof(ctl_init_args_t));
-    CtlInitArgs.AppVersion = CTL_MAKE_VERSION(CTL_IMPL_MAJOR_VERSION, CTL_IMPL_MINOR_VERSION);
-    CtlInitArgs.flags = 0;
-    CtlInitArgs.Size = sizeof(CtlInitArgs);
-    CtlInitArgs.Version = 0;
-
-    Result = ctlInit(&CtlInitArgs, &hAPIHandle);
+    // 1. 取得共用的 IGCL session
+    IgclSession& session = IgclSession::Instance();
+    ctl_result_t Result = session.Open();
     if (Result != CTL_RESULT_SUCCESS) {
-        json responseContent;
-        responseContent["type"] = "text";
-        responseContent["text"] = "ctlInit failed";
-        json response;
-        response["content"] = json::array();
-        response["content"].push_back(responseContent);
-        response["isError"] = true;
-        std::string result = response.dump();
-        char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-        strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-        strcpy(buffer, result.c_str());
-#endif
-        return buffer;
+        return WriteTextResult(out, "ctlInit failed", true);
     }
 
-    // 2. Enumerate devices
-    Result = ctlEnumerateDevices(hAPIHandle, &AdapterCount, hDevices);
-    hDevices = (ctl_device_adapter_handle_t*)malloc(sizeof(ctl_device_adapter_handle_t) * AdapterCount);
-    Result = ctlEnumerateDevices(hAPIHandle, &AdapterCount, hDevices);
-    if (Result != CTL_RESULT_SUCCESS || AdapterCount == 0) {
-        json responseContent;
-        responseContent["type"] = "text";
-        responseContent["text"] = "No device found";
-        json response;
-        response["content"] = json::array();
-        response["content"].push_back(responseContent);
-        response["isError"] = true;
-        std::string result = response.dump();
-        char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-        strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-        strcpy(buffer, result.c_str());
-#endif
-        return buffer;
+    // 2. Enumerate devices (cached by the session)
+    std::shared_ptr<const IgclSession::Devices> devices;
+    Result = session.GetDevices(devices);
+    if (Result != CTL_RESULT_SUCCESS || devices->handles.empty()) {
+        return WriteTextResult(out, "No device found", true);
+    }
+    std::vector<uint32_t> indices;
+    std::string error;
+    if (!SelectDevices(arguments, devices->handles.size(), indices, error)) {
+        return WriteInvalidParams(out, error);
     }
 
-    // 3. 設定每個 device 的 Frame Sync mode
-    std::ostringstream oss;
-    for (uint32_t i = 0; i < AdapterCount; ++i) {
+    // 3. 設定選取的 device 的 Frame Sync mode, 每個 adapter 的 IOCTL 同時進行
+    //    已經是相同 mode 的 adapter 不再呼叫 driver
+    std::vector<char> unchanged(devices->handles.size(), 0);
+    std::vector<ctl_result_t> results = session.Apply(*devices, indices, [&](uint32_t index, ctl_device_adapter_handle_t) {
         ctl_3d_feature_getset_t Set3DProperty = { 0 };
         Set3DProperty.Size = sizeof(Set3DProperty);
         Set3DProperty.FeatureType = CTL_3D_FEATURE_GAMING_FLIP_MODES;
@@ -192,39 +161,29 @@ char* HandleRequestImpl(const char* req) {
         Set3DProperty.ValueType = CTL_PROPERTY_VALUE_TYPE_ENUM;
         Set3DProperty.Value.EnumType.EnableType = mode_flag;
         Set3DProperty.Version = 0;
-
-        Result = ctlGetSet3DFeature(hDevices[i], &Set3DProperty);
-        if (Result == CTL_RESULT_SUCCESS) {
-            oss << "Device Index: " << i << "\n  Set Frame Sync Mode: " << GetModeNameByIndex(mode) << " (Flag: " << mode_flag << ")\n  Status: Success\n\n";
-        } else {
-            oss << "Device Index: " << i << "\n  Set Frame Sync Mode: " << GetModeNameByIndex(mode) << " (Flag: " << mode_flag << ")\n  Status: Failed\n\n";
-        }
+        bool skipped = false;
+        ctl_result_t result = session.GetSet3DFeature(*devices, index, Set3DProperty, &skipped);
+        unchanged[index] = skipped;
+        return result;
+    }, ParallelApply(arguments));
+
+    json result = {{"mode", mode}, {"modeName", GetModeNameByIndex(mode)}, {"flag", mode_flag}, {"devices", json::array()}};
+    for (size_t i = 0; i < indices.size(); ++i) {
+        result["devices"].push_back({{"index", indices[i]}, {"success", results[i] == CTL_RESULT_SUCCESS}, {"result", results[i]},
+                                     {"changed", results[i] == CTL_RESULT_SUCCESS && !unchanged[indices[i]]}});
     }
-    free(hDevices);
-
-    std::string text = oss.str();
-    if (text.empty()) text = "No device processed.";
-
-    json responseContent;
-    responseContent["type"] = "text";
-    responseContent["text"] = text;
 
-    json response;
-    response["content"] = json::array();
-    response["content"].push_back(responseContent);
-    response["isError"] = false;
+    std::string summary = std::string("Frame Sync set to ") + GetModeNameByIndex(mode) + " " + AdaptersSummary(result["devices"]) + ".";
+    return WriteStructuredResult(out, std::move(result), summary, false);
+}
 
-    std::string result = response.dump();
-    char* buffer = new char[result.length() + 1];
-#ifdef _WIN32
-    strcpy_s(buffer, result.length() + 1, result.c_str());
-#else
-    strcpy(buffer, result.c_str());
-#endif
-    return buffer;
+char* HandleRequestImpl(const char* req) {
+    return HandleRequestV1(HandleRequestV2Impl, req);
 }
 
-void ShutdownImpl() {}
+void ShutdownImpl() {
+    IgclSession::Instance().Release();
+}
 
 int GetToolCountImpl() {
     return sizeof(methods) / sizeof(methods[0]);
@@ -257,3 +216,19 @@ extern "C" PLUGIN_API PluginAPI* CreatePlugin() {
 extern "C" PLUGIN_API void DestroyPlugin(PluginAPI*) {
     // Nothing to clean up for this example
 }
+
+const char* GetToolOutputSchemaImpl(int index) {
+    if (index < 0 || index >= GetToolCountImpl()) return nullptr;
+    return outputSchemas[index];
+}
+
+static const PluginExtensions extensions = {
+    PLUGIN_ABI_VERSION,
+    sizeof(PluginExtensions),
+    HandleRequestV2Impl,
+    GetToolOutputSchemaImpl
+};
+
+extern "C" PLUGIN_API const PluginExtensions* GetPluginExtensions() {
+    return &extensions;
+}
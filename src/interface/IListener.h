@@ -0,0 +1,58 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_ILISTENER_H
+#define MCP_SERVER_ILISTENER_H
+
+#include <functional>
+#include <string>
+
+namespace vx {
+
+    // A transport serving many clients at once (e.g. HTTP), unlike ITransport which is one
+    // connected peer. Every client gets a session, messages are routed back by session.
+    class IListener {
+    public:
+        // Called once per request with the serialized response, or an empty string when there is none
+        using Reply = std::function<void(std::string)>;
+        // The message is the text received from the client, the server parses it on its own
+        using MessageHandler = std::function<void(const std::string& session, std::string message, Reply reply)>;
+
+        // Accept clients until Stop(), handler is called concurrently from the listener threads
+        virtual bool Listen(MessageHandler handler) = 0;
+        virtual void Stop() = 0;
+
+        // Server to client message for every session listening for notifications
+        virtual void Broadcast(const std::string& message) = 0;
+
+        virtual std::string GetName() = 0;
+        virtual std::string GetVersion() = 0;
+        virtual int GetPort() = 0;
+
+        virtual ~IListener() = default;
+    };
+
+}
+
+#endif //MCP_SERVER_ILISTENER_H
@@ -26,7 +26,13 @@
 #define MCP_SERVER_ITRANSPORT_H
 
 #include <string>
-#include <future>
+#include <string_view>
+#include <vector>
+#include "../utils/Task.h"
+
+namespace vx::transport {
+    class EventLoop;
+}
 
 namespace vx {
 
@@ -35,12 +41,45 @@ namespace vx {
         virtual std::pair<size_t, std::string> Read() = 0;
         virtual void Write(const std::string& json_data) = 0;
 
-        virtual std::future<std::pair<size_t, std::string>> ReadAsync() = 0;
-        virtual std::future<void> WriteAsync(const std::string& json_data) = 0;
+        // Read the next message without copying it when the transport allows it.
+        // The view is valid until the next read. Returns false when the peer is gone.
+        virtual bool ReadView(std::string_view& message) {
+            auto [length, data] = Read();
+            if (length == 0 && data.empty()) return false;
+            lastMessage_ = std::move(data);
+            message = lastMessage_;
+            return true;
+        }
+
+        // Write several messages at once, transports override it to coalesce them in one system call
+        virtual void WriteBatch(const std::vector<std::string>& messages) {
+            for (const auto& message : messages) Write(message);
+        }
+
+        // Async mode: the coroutine flavours below are resumed by this loop instead of blocking,
+        // nullptr goes back to blocking I/O. They must only be awaited on the loop thread.
+        virtual void Attach(vx::transport::EventLoop* loop) {}
+
+        // Wake a pending ReadViewAsync with false, callable from any thread
+        virtual void CancelRead() {}
+
+        virtual Task<bool> ReadViewAsync(std::string_view& message) {
+            co_return ReadView(message);
+        }
+
+        virtual Task<void> WriteBatchAsync(const std::vector<std::string>& messages) {
+            WriteBatch(messages);
+            co_return;
+        }
 
         virtual std::string GetName() = 0;
         virtual std::string GetVersion() = 0;
         virtual int GetPort() = 0;
+
+        virtual ~ITransport() = default;
+
+    private:
+        std::string lastMessage_;
     };
 
 }
@@ -31,10 +31,17 @@
 #define PLUGIN_API __attribute__((visibility("default")))
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Version of the optional extensions below. Plugins that only export
+// CreatePlugin/DestroyPlugin are version 1 and keep working unchanged.
+#define PLUGIN_ABI_VERSION 4
+
 typedef void (*ClientNotificationCallback)(const char* pluginName, const char* notification);
 
 typedef enum {
@@ -82,9 +89,55 @@ typedef struct {
     NotificationSystem* notifications;
 } PluginAPI;
 
+// Output buffer owned by the host (ABI v2). The plugin appends the serialized
+// "result" object of the response with Write(); the host splices these bytes
+// into the response as they are, without parsing them again.
+typedef struct PluginBuffer {
+    void* context;    // host private, do not touch
+    int (*Write)(struct PluginBuffer* buffer, const char* data, size_t length);   // 0 on success
+} PluginBuffer;
+
+// Request handed to HandleRequestV2. Strings are length delimited and not null
+// terminated; they are only valid during the call.
+typedef struct {
+    const char* params;      // raw JSON of the request "params" member
+    size_t paramsLength;
+    const char* name;        // tool or prompt name, or resource uri, the request is routed on
+    size_t nameLength;
+} PluginRequest;
+
+// Cancellation of a running call (ABI v4), owned by the host and only valid during
+// the call. IsCancelled() turns non-zero once the client cancelled the request or
+// its deadline passed; the client has already been answered by then.
+typedef struct PluginCancelToken {
+    void* context;    // host private, do not touch
+    int (*IsCancelled)(const struct PluginCancelToken* token);
+} PluginCancelToken;
+
+typedef enum {
+    PLUGIN_RESULT_OK = 0,
+    PLUGIN_RESULT_ERROR = 1,    // the host answers with an internal error, the buffer is ignored
+    PLUGIN_RESULT_INVALID_PARAMS = 2    // the host answers with an invalid params error, the buffer holds its message
+} PluginResult;
+
+typedef struct {
+    uint32_t abiVersion;    // PLUGIN_ABI_VERSION the plugin was built with
+    uint32_t size;          // sizeof(PluginExtensions), newer fields are only read when present
+    PluginResult (*HandleRequestV2)(const PluginRequest* request, PluginBuffer* out);
+    // ABI v3: JSON schema of the "structuredContent" a tool returns, listed as its
+    // outputSchema; nullptr (function or result) for tools that only return text
+    const char* (*GetToolOutputSchema)(int index);
+    // ABI v4: HandleRequestV2 with the cancellation token of the call, called instead of it
+    // when set. A long handler checks the token between driver calls and returns early.
+    PluginResult (*HandleRequestV4)(const PluginRequest* request, PluginBuffer* out, const PluginCancelToken* cancel);
+} PluginExtensions;
+
 PLUGIN_API PluginAPI* CreatePlugin();
 PLUGIN_API void DestroyPlugin(PluginAPI*);
 
+// Optional (ABI v2): when exported, the host calls HandleRequestV2 instead of HandleRequest
+PLUGIN_API const PluginExtensions* GetPluginExtensions();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,319 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "PluginCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <elf.h>
+#endif
+
+#include "aixlog.hpp"
+
+namespace vx::mcp {
+
+    static const char kMagic[8] = {'V', 'X', 'P', 'L', 'U', 'G', 'I', 'X'};
+
+    // Bounds checked reads from the mapping, a truncated file fails instead of reading past it
+    struct CacheReader {
+        const uint8_t* data;
+        const uint8_t* end;
+
+        template <typename T>
+        bool Read(T& value) {
+            if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+            memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            return true;
+        }
+
+        bool Bytes(size_t size, const uint8_t*& bytes) {
+            if (static_cast<size_t>(end - data) < size) return false;
+            bytes = data;
+            data += size;
+            return true;
+        }
+    };
+
+    template <typename T>
+    static void Append(std::string& buffer, T value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+#ifdef __linux__
+    static std::string ToHex(const unsigned char* data, size_t size) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(size * 2);
+        for (size_t i = 0; i < size; i++) {
+            hex.push_back(digits[data[i] >> 4]);
+            hex.push_back(digits[data[i] & 0x0f]);
+        }
+        return hex;
+    }
+
+    // NT_GNU_BUILD_ID from the PT_NOTE segments, only the program headers and notes are read
+    template <typename Ehdr, typename Phdr>
+    static std::string ReadBuildId(std::ifstream& file) {
+        Ehdr header;
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.e_phentsize != sizeof(Phdr)) return {};
+
+        for (size_t i = 0; i < header.e_phnum; i++) {
+            Phdr segment;
+            file.seekg(static_cast<std::streamoff>(header.e_phoff + i * sizeof(Phdr)));
+            if (!file.read(reinterpret_cast<char*>(&segment), sizeof(segment))) return {};
+            if (segment.p_type != PT_NOTE || segment.p_filesz > 64 * 1024) continue;
+
+            std::vector<unsigned char> notes(segment.p_filesz);
+            file.seekg(static_cast<std::streamoff>(segment.p_offset));
+            if (!file.read(reinterpret_cast<char*>(notes.data()), static_cast<std::streamsize>(notes.size()))) return {};
+
+            size_t align = segment.p_align == 8 ? 8 : 4;
+            auto aligned = [align](size_t size) { return (size + align - 1) & ~(align - 1); };
+            size_t offset = 0;
+            while (offset + sizeof(Elf32_Nhdr) <= notes.size()) {
+                Elf32_Nhdr note; // same layout in 64-bit files
+                memcpy(&note, notes.data() + offset, sizeof(note));
+                size_t name = offset + sizeof(note);
+                size_t desc = name + aligned(note.n_namesz);
+                if (desc + note.n_descsz > notes.size()) break;
+                if (note.n_type == NT_GNU_BUILD_ID && note.n_namesz == 4 && memcmp(notes.data() + name, "GNU", 4) == 0) {
+                    return ToHex(notes.data() + desc, note.n_descsz);
+                }
+                offset = desc + aligned(note.n_descsz);
+            }
+        }
+        return {};
+    }
+#endif
+
+    bool PluginCacheKey::Of(const std::string& path, PluginCacheKey& key) {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error) return false;
+        auto time = std::filesystem::last_write_time(path, error);
+        if (error) return false;
+
+        key.path = path;
+        key.size = size;
+        key.mtime = static_cast<int64_t>(time.time_since_epoch().count());
+        key.buildId.clear();
+#ifdef __linux__
+        // a rebuild within the mtime granularity, or a copy keeping the mtime, still changes the build id
+        std::ifstream file(path, std::ios::binary);
+        unsigned char ident[EI_NIDENT];
+        if (file.read(reinterpret_cast<char*>(ident), sizeof(ident)) && memcmp(ident, ELFMAG, SELFMAG) == 0) {
+            if (ident[EI_CLASS] == ELFCLASS64) {
+                key.buildId = ReadBuildId<Elf64_Ehdr, Elf64_Phdr>(file);
+            } else if (ident[EI_CLASS] == ELFCLASS32) {
+                key.buildId = ReadBuildId<Elf32_Ehdr, Elf32_Phdr>(file);
+            }
+        }
+#endif
+        return true;
+    }
+
+    PluginCache::~PluginCache() {
+        Close();
+    }
+
+    bool PluginCache::Open(const std::string& file) {
+        Close();
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) return false;
+        file_ = handle;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+            Close();
+            return false;
+        }
+        mapping_ = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* view = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            Close();
+            return false;
+        }
+        data_ = static_cast<const uint8_t*>(view);
+        size_ = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps the file alive, even once replaced by a newer cache
+        close(fd);
+        if (view == MAP_FAILED) return false;
+        data_ = static_cast<const uint8_t*>(view);
+        size_ = static_cast<size_t>(info.st_size);
+#endif
+        if (!Index()) {
+            LOG(WARNING) << "Ignoring invalid plugin cache " << file << std::endl;
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void PluginCache::Close() {
+        records_.clear();
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = nullptr;
+#else
+        if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    // Header: magic, version, record count. Record: its size, mtime, size, the lengths of the
+    // path, build id, hash and description, then their bytes.
+    bool PluginCache::Index() {
+        CacheReader reader{data_, data_ + size_};
+        const uint8_t* magic;
+        uint32_t version, count;
+        if (!reader.Bytes(sizeof(kMagic), magic) || memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+            !reader.Read(version) || !reader.Read(count)) {
+            return false;
+        }
+        // another format is not an error, the cache is just written again
+        if (version != PLUGIN_CACHE_VERSION) return true;
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t recordSize;
+            const uint8_t* record;
+            if (!reader.Read(recordSize) || !reader.Bytes(recordSize, record)) return false;
+
+            CacheReader fields{record, record + recordSize};
+            int64_t mtime;
+            uint64_t size;
+            uint32_t pathSize;
+            const uint8_t* path;
+            if (!fields.Read(mtime) || !fields.Read(size) || !fields.Read(pathSize) || !fields.Bytes(pathSize, path)) return false;
+            records_[std::string_view(reinterpret_cast<const char*>(path), pathSize)] = Span{record, recordSize};
+        }
+        return true;
+    }
+
+    bool PluginCache::Find(const PluginCacheKey& key, PluginCacheRecord& record) const {
+        auto it = records_.find(key.path);
+        if (it == records_.end()) return false;
+
+        CacheReader fields{it->second.data, it->second.data + it->second.size};
+        int64_t mtime;
+        uint64_t size;
+        uint32_t pathSize, buildIdSize, hashSize, descriptionSize;
+        const uint8_t *path, *buildId, *hash, *description;
+        if (!fields.Read(mtime) || !fields.Read(size) ||
+            !fields.Read(pathSize) || !fields.Bytes(pathSize, path) ||
+            !fields.Read(buildIdSize) || !fields.Bytes(buildIdSize, buildId) ||
+            !fields.Read(hashSize) || !fields.Bytes(hashSize, hash) ||
+            !fields.Read(descriptionSize) || !fields.Bytes(descriptionSize, description)) {
+            return false;
+        }
+        if (mtime != key.mtime || size != key.size ||
+            std::string_view(reinterpret_cast<const char*>(buildId), buildIdSize) != key.buildId) {
+            return false;
+        }
+
+        // MessagePack is decoded without any text parsing, the schemas were validated when cached
+        auto decoded = nlohmann::ordered_json::from_msgpack(description, description + descriptionSize, true, false);
+        if (decoded.is_discarded() || !decoded.is_object()) return false;
+
+        record.key = key;
+        record.hash.assign(reinterpret_cast<const char*>(hash), hashSize);
+        record.description = std::move(decoded);
+        return true;
+    }
+
+    bool PluginCache::Write(const std::string& file, const std::vector<PluginCacheRecord>& records) {
+        std::string buffer(kMagic, sizeof(kMagic));
+        Append<uint32_t>(buffer, PLUGIN_CACHE_VERSION);
+        Append<uint32_t>(buffer, static_cast<uint32_t>(records.size()));
+
+        std::string record;
+        for (const auto& entry : records) {
+            std::vector<uint8_t> description = nlohmann::ordered_json::to_msgpack(entry.description);
+            record.clear();
+            Append<int64_t>(record, entry.key.mtime);
+            Append<uint64_t>(record, entry.key.size);
+            Append<uint32_t>(record, static_cast<uint32_t>(entry.key.path.size()));
+            record.append(entry.key.path);
+            Append<uint32_t>(record, static_cast<uint32_t>(entry.key.buildId.size()));
+            record.append(entry.key.buildId);
+            Append<uint32_t>(record, static_cast<uint32_t>(entry.hash.size()));
+            record.append(entry.hash);
+            Append<uint32_t>(record, static_cast<uint32_t>(description.size()));
+            record.append(reinterpret_cast<const char*>(description.data()), description.size());
+
+            Append<uint32_t>(buffer, static_cast<uint32_t>(record.size()));
+            buffer.append(record);
+        }
+
+        // a server mapping the previous file keeps reading it, the new one is renamed over it
+        std::string temporary = file + "." + std::to_string(getpid()) + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!out.flush()) {
+                LOG(WARNING) << "Cannot write the plugin cache " << file << std::endl;
+                out.close();
+                std::error_code error;
+                std::filesystem::remove(temporary, error);
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, file, error);
+        if (error) {
+            LOG(WARNING) << "Cannot write the plugin cache " << file << ": " << error.message() << std::endl;
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+
+}
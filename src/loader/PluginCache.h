@@ -0,0 +1,111 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef MCP_SERVER_PLUGIN_CACHE_H
+#define MCP_SERVER_PLUGIN_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+
+// Metadata of every plugin library of a directory, in a file of that directory
+#define PLUGIN_CACHE_FILE ".plugins.cache"
+// Format of the cache file, a file of another format is ignored and written again
+#define PLUGIN_CACHE_VERSION 1
+
+namespace vx::mcp {
+
+    // Identifies one build of a library from its metadata, without reading its content
+    struct PluginCacheKey {
+        std::string path;
+        int64_t mtime = 0;      // last write time, in ticks of the file clock
+        uint64_t size = 0;
+        std::string buildId;    // hex of the GNU build id note, empty when the library has none
+
+        // false if the library cannot be stat'ed
+        static bool Of(const std::string& path, PluginCacheKey& key);
+
+        bool operator==(const PluginCacheKey& other) const = default;
+    };
+
+    struct PluginCacheRecord {
+        PluginCacheKey key;
+        std::string hash;                       // content hash, the key of the library manifest
+        nlohmann::ordered_json description;     // as PluginEntry::description
+    };
+
+    // Binary index of the plugin metadata of a directory, memory mapped at startup so that a
+    // library that did not change is neither introspected nor its schemas parsed again.
+    //
+    // The file is a header followed by one record per library: the key, the content hash and
+    // the description encoded as MessagePack. Records are decoded on lookup, straight from the
+    // mapping; the file is replaced as a whole by Write() and never modified in place.
+    class PluginCache {
+    public:
+        PluginCache() = default;
+        ~PluginCache();
+
+        PluginCache(const PluginCache&) = delete;
+        PluginCache& operator=(const PluginCache&) = delete;
+
+        // Map a cache file, a missing, truncated or outdated file leaves the cache empty
+        bool Open(const std::string& file);
+        void Close();
+
+        // The record of key.path, if the library has not changed since it was cached.
+        // Safe to call from several threads at once.
+        bool Find(const PluginCacheKey& key, PluginCacheRecord& record) const;
+
+        size_t Size() const { return records_.size(); }
+
+        // Write records as the new cache file, in place of the previous one at once
+        static bool Write(const std::string& file, const std::vector<PluginCacheRecord>& records);
+
+    private:
+        struct Span {
+            const uint8_t* data;
+            size_t size;
+        };
+
+        bool Index();
+
+    private:
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+#ifdef _WIN32
+        void* file_ = nullptr;
+        void* mapping_ = nullptr;
+#endif
+        std::unordered_map<std::string_view, Span> records_;  // by path, the keys point into the mapping
+    };
+
+}
+
+#endif //MCP_SERVER_PLUGIN_CACHE_H
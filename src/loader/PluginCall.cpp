@@ -0,0 +1,174 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstddef>
+#include "PluginCall.h"
+#include "aixlog.hpp"
+#include "../utils/MCPBuilder.h"
+#include "../server/Metrics.h"
+
+namespace vx::mcp {
+
+    // PluginBuffer::Write of the host, appends to the std::string in the buffer context
+    static int AppendToString(PluginBuffer* buffer, const char* data, size_t length) {
+        try {
+            static_cast<std::string*>(buffer->context)->append(data, length);
+            return 0;
+        } catch (...) {
+            // never let an exception cross the plugin boundary
+            return -1;
+        }
+    }
+
+    // PluginCancelToken::IsCancelled of the host, the context is the CancelToken of the request
+    static int IsTokenCancelled(const PluginCancelToken* token) {
+        return static_cast<const CancelToken*>(token->context)->IsCancelled() ? 1 : 0;
+    }
+
+    // HandleRequestV4 is only read when the plugin table is recent and large enough to have it
+    static bool HasHandleRequestV4(const PluginExtensions* extensions) {
+        constexpr size_t v4Size = offsetof(PluginExtensions, HandleRequestV4) + sizeof(PluginExtensions::HandleRequestV4);
+        return extensions->abiVersion >= 4 && extensions->size >= v4Size && extensions->HandleRequestV4;
+    }
+
+    PluginResult HandlePluginRequest(const PluginExtensions* extensions, const PluginRequest* request,
+                                     PluginBuffer* out, const CancelToken* cancel) {
+        if (cancel && HasHandleRequestV4(extensions)) {
+            PluginCancelToken token{const_cast<CancelToken*>(cancel), IsTokenCancelled};
+            return extensions->HandleRequestV4(request, out, &token);
+        }
+        return extensions->HandleRequestV2(request, out);
+    }
+
+    static std::string CallPluginV2(const PluginRoute& route, const Envelope& request, std::string_view name, uint64_t& pluginTime) {
+        std::string_view params = request.params.empty() ? std::string_view("{}") : request.params;
+
+        std::string result;
+        PluginResult status;
+        auto start = Metrics::Clock::now();
+        if (route.host) {
+            // the child crashed during the call, or is not back yet
+            if (!route.host->CallV2(name, params, result, status, request.cancel)) status = PLUGIN_RESULT_ERROR;
+        } else {
+            PluginRequest pluginRequest{params.data(), params.size(), name.data(), name.size()};
+            PluginBuffer out{&result, AppendToString};
+            status = HandlePluginRequest(route.extensions, &pluginRequest, &out, request.cancel);
+        }
+        pluginTime = Metrics::Elapsed(start);
+        // the client got its error already, whatever the plugin returned is dropped
+        if (request.cancel && request.cancel->IsCancelled()) return std::string();
+        if (status == PLUGIN_RESULT_INVALID_PARAMS) {
+            return MCPBuilder::Error(MCPBuilder::InvalidParams, request.id, result.empty() ? "Invalid params." : result).dump();
+        }
+        if (status != PLUGIN_RESULT_OK || result.empty()) {
+            LOG(ERROR) << "Plugin " << route.plugin->description.value("name", "") << " failed to handle " << name << "." << std::endl;
+            return MCPBuilder::Error(MCPBuilder::InternalError, request.id, "Plugin failed to handle the request.").dump();
+        }
+        return MCPBuilder::RawResponse(request.id, result);
+    }
+
+    static std::string CallPluginV1(const PluginRoute& route, const Envelope& envelope, std::string_view name, bool isTool, uint64_t& pluginTime) {
+        const json& request = envelope.Request();
+        json response = MCPBuilder::Response(request);
+
+        // the message as received, a DOM built from a batch element is dumped once
+        std::string requestText = envelope.Text().empty() ? request.dump() : std::string(envelope.Text());
+        auto start = Metrics::Clock::now();
+        char* res_ptr = nullptr;
+        std::string hostResult;
+        const char* data;
+        if (route.host) {
+            data = route.host->CallV1(requestText, hostResult, envelope.cancel) && !hostResult.empty() ? hostResult.c_str() : nullptr;
+        } else {
+            res_ptr = route.instance->HandleRequest(requestText.c_str());
+            data = res_ptr;
+        }
+        pluginTime = Metrics::Elapsed(start);
+        if (envelope.cancel && envelope.cancel->IsCancelled()) {
+            delete[] res_ptr;
+            return std::string();
+        }
+        if (!data) {
+            LOG(ERROR) << "Plugin " << name << " returned nullptr." << std::endl;
+            return MCPBuilder::Error(MCPBuilder::InternalError, request["id"], "Plugin returned no data.").dump();
+        }
+
+        try {
+            response["result"] = json::parse(data);
+            if (isTool && !response["result"].contains("isError")) {
+                response["result"]["isError"] = false;
+            }
+        } catch (const json::parse_error& e) {
+            LOG(ERROR) << "Plugin " << name << " returned malformed data." << std::endl;
+            if (isTool) {
+                response["result"]["isError"] = true;
+                response["result"]["content"] = json::array();
+                response["result"]["content"].push_back({{"type", "text"}, {"text", "Plugin returned malformed data."}});
+            } else {
+                response = MCPBuilder::Error(MCPBuilder::InternalError, request["id"], "Plugin returned malformed data.");
+            }
+        }
+        // --- Free the allocated memory ---
+        delete[] res_ptr;
+
+        return response.dump();
+    }
+
+    std::string CallPlugin(const PluginRoute& route, const Envelope& request, std::string_view name, bool isTool) {
+        // a plugin that does not return from its cancelled calls would take every worker in turn;
+        // an isolated one is killed instead, see PluginHost
+        PluginEntry* plugin = route.host ? nullptr : route.plugin;
+        if (plugin && plugin->abandoned.load(std::memory_order_relaxed) >= PLUGIN_MAX_ABANDONED_CALLS) {
+            LOG(WARNING) << "Plugin " << plugin->description.value("name", "") << " is still running " << plugin->abandoned.load()
+                         << " cancelled calls, refusing " << name << std::endl;
+            return MCPBuilder::Error(MCPBuilder::InternalError, request.id, "Plugin is not responding, it is still running cancelled calls.").dump();
+        }
+        // the call is counted as abandoned from its cancel until it returns
+        bool abandoned = false;
+        if (plugin && request.cancel) {
+            request.cancel->SetHandler([plugin, &abandoned]() {
+                plugin->abandoned.fetch_add(1, std::memory_order_relaxed);
+                abandoned = true;
+            });
+        }
+
+        auto start = Metrics::Clock::now();
+        uint64_t pluginTime = 0;
+        bool v2 = route.extensions || (route.host && route.host->AbiVersion() >= 2);
+        std::string response = v2
+                ? CallPluginV2(route, request, name, pluginTime)
+                : CallPluginV1(route, request, name, isTool, pluginTime);
+        if (plugin && request.cancel) {
+            // waits for a handler running meanwhile, abandoned is settled after it
+            request.cancel->ClearHandler();
+            if (abandoned) plugin->abandoned.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // whatever is not spent in the plugin is the host marshalling the request and the response
+        route.pluginTime->Record(pluginTime);
+        route.serializeTime->Record(Metrics::Elapsed(start) - pluginTime);
+        return response;
+    }
+
+}
@@ -0,0 +1,57 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_PLUGIN_CALL_H
+#define MCP_SERVER_PLUGIN_CALL_H
+
+#include <string>
+#include <string_view>
+
+#include "PluginsLoader.h"
+#include "../server/Envelope.h"
+
+namespace vx::mcp {
+
+    // Forwards a tools/call, prompts/get or resources/read request to the plugin owning the
+    // route and returns the complete JSON-RPC response.
+    //
+    // ABI v2 plugins get the raw params span of the envelope, as received from the client, and
+    // write the "result" object straight into a host buffer, which is spliced into the response
+    // without being parsed again: the request is never parsed into a DOM on this path.
+    // ABI v1 plugins get the whole request as text and return a heap string that is parsed,
+    // checked and freed here. For tools, a result without "isError" is reported as successful.
+    // An isolated plugin gets the same through its host child; a call the child crashed on
+    // is answered with an internal error.
+    //
+    // A call cancelled or timed out while the plugin runs returns an empty string, the server
+    // answered the client already. Plugins of ABI v4 get the token and may return early.
+    std::string CallPlugin(const PluginRoute& route, const Envelope& request, std::string_view name, bool isTool);
+
+    // HandleRequestV4 of a plugin with cancel when it has one, HandleRequestV2 otherwise
+    PluginResult HandlePluginRequest(const PluginExtensions* extensions, const PluginRequest* request,
+                                     PluginBuffer* out, const CancelToken* cancel);
+
+}
+
+#endif //MCP_SERVER_PLUGIN_CALL_H
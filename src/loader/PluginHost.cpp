@@ -0,0 +1,543 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "PluginHost.h"
+#include "ShmChannel.h"
+#include "aixlog.hpp"
+
+#ifdef __linux__
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "PluginsLoader.h"
+#include "PluginCall.h"
+#include "../utils/ThreadPool.h"
+#endif
+
+namespace vx::mcp {
+
+    PluginHost::PluginHost(std::string path, ClientNotificationCallback notify)
+        : path_(std::move(path)), notify_(notify) {}
+
+    PluginHost::~PluginHost() {
+        Stop();
+    }
+
+    bool PluginHost::CallV2(std::string_view name, std::string_view params, std::string& result, PluginResult& status,
+                            const CancelToken* cancel) {
+        ChannelMessage request{ChannelKind::CallV2, 0, 0, std::string(name), std::string(params)};
+        PendingCall call;
+        if (!Call(request, call, cancel)) return false;
+        result = std::move(call.result);
+        status = call.status == PLUGIN_RESULT_OK || call.status == PLUGIN_RESULT_INVALID_PARAMS
+                 ? static_cast<PluginResult>(call.status) : PLUGIN_RESULT_ERROR;
+        return true;
+    }
+
+    bool PluginHost::CallV1(std::string_view request, std::string& result, const CancelToken* cancel) {
+        ChannelMessage message{ChannelKind::CallV1, 0, 0, std::string(request), {}};
+        PendingCall call;
+        if (!Call(message, call, cancel)) return false;
+        result = std::move(call.result);
+        return true;
+    }
+
+#ifdef __linux__
+    using Clock = std::chrono::steady_clock;
+
+    bool PluginHost::Supported() {
+        return true;
+    }
+
+    bool PluginHost::Start(const std::string& library, nlohmann::ordered_json* description) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (supervisor_.joinable()) return false;
+        // the child is spawned from the supervisor thread only: its parent death signal fires
+        // when the thread that forked it exits, not the process
+        supervisor_ = std::thread(&PluginHost::Supervise, this, library, description);
+        stateChanged_.wait(lock, [this]() { return state_ != State::Starting; });
+        return state_ == State::Running;
+    }
+
+    void PluginHost::Stop() {
+        std::shared_ptr<ShmChannel> channel;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!supervisor_.joinable()) return;
+            stopping_ = true;
+            channel = channel_;
+        }
+        stateChanged_.notify_all();
+
+        // the child finishes the calls it runs, unloads the plugin and exits; a hung one is killed
+        if (channel) {
+            std::unique_lock<std::timed_mutex> write(writeMutex_, std::chrono::milliseconds(PLUGIN_HOST_STOP_TIMEOUT_MS));
+            if (write.owns_lock()) {
+                channel->Requests().Write(ChannelMessage{ChannelKind::Shutdown, 0, 0, {}, {}}, PLUGIN_HOST_STOP_TIMEOUT_MS);
+            }
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!stateChanged_.wait_for(lock, std::chrono::milliseconds(PLUGIN_HOST_STOP_TIMEOUT_MS),
+                                        [this]() { return state_ == State::Stopped; }) && pid_ > 0) {
+                LOG(WARNING) << "Plugin host of " << path_ << " did not stop, killing it" << std::endl;
+                kill(pid_, SIGKILL);
+            }
+        }
+        supervisor_.join();
+    }
+
+    bool PluginHost::Call(ChannelMessage& request, PendingCall& call, const CancelToken* cancel) {
+        while (true) {
+            if (cancel && cancel->IsCancelled()) return false;
+            std::shared_ptr<ShmChannel> channel;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                // a crashed child is being restarted, the call goes to the new one
+                stateChanged_.wait_for(lock, std::chrono::milliseconds(PLUGIN_HOST_RESTART_WAIT_MS),
+                                       [this]() { return state_ != State::Restarting; });
+                if (state_ != State::Running || stopping_) return false;
+                request.id = ++nextId_;
+                call.finished = false;
+                call.failed = false;
+                call.cancelled = false;
+                pending_[request.id] = &call;
+                channel = channel_;
+            }
+
+            bool written;
+            uint64_t end;
+            {
+                std::lock_guard<std::timed_mutex> write(writeMutex_);
+                written = channel->Requests().Write(request);
+                end = channel->Requests().Published();
+            }
+
+            // the caller stops waiting on a cancel, the child may still be running the call
+            if (written && cancel) {
+                cancel->SetHandler([this, &call, id = request.id]() {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (call.finished) return;
+                    pending_.erase(id);
+                    abandoned_[id] = Clock::now() + std::chrono::milliseconds(PLUGIN_HOST_CANCEL_GRACE_MS);
+                    call.cancelled = true;
+                    call.finished = true;
+                    call.done.notify_one();
+                });
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!written) {
+                pending_.erase(request.id);
+                // the channel was closed under the call by a crash, the child never saw it
+                if (channel_ != channel) continue;
+                LOG(ERROR) << "Cannot send a call to the plugin host of " << path_ << std::endl;
+                return false;
+            }
+            // answered by the reader thread, failed by the supervisor when the child exits, or cancelled
+            call.done.wait(lock, [&call]() { return call.finished; });
+            lock.unlock();
+            // the handler takes mutex_, and clearing waits for it to be done
+            if (cancel) cancel->ClearHandler();
+
+            if (call.cancelled) {
+                std::unique_lock<std::timed_mutex> write(writeMutex_, std::chrono::milliseconds(PLUGIN_HOST_HANG_CHECK_MS));
+                if (write.owns_lock()) {
+                    channel->Requests().Write(ChannelMessage{ChannelKind::Cancel, 0, request.id, {}, {}}, PLUGIN_HOST_HANG_CHECK_MS);
+                }
+                return false;
+            }
+            if (!call.failed) return true;
+            // a request the child had not taken yet cannot have crashed it, it is sent again
+            if (call.consumed >= end) return false;
+        }
+    }
+
+    void PluginHost::ReadResponses(std::shared_ptr<ShmChannel> channel, int pid) {
+        ChannelMessage message;
+        int read;
+        while ((read = channel->Responses().Read(message, PLUGIN_HOST_HANG_CHECK_MS)) >= 0) {
+            if (read == 1 && message.kind == ChannelKind::Notify) {
+                if (notify_) notify_(message.first.c_str(), message.second.c_str());
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (read == 1 && message.kind == ChannelKind::Result) {
+                abandoned_.erase(message.id);
+                auto it = pending_.find(message.id);
+                if (it != pending_.end()) {
+                    PendingCall* call = it->second;
+                    pending_.erase(it);
+                    call->status = message.status;
+                    call->result = std::move(message.first);
+                    call->finished = true;
+                    call->done.notify_one();
+                }
+            }
+
+            // the plugin ignores the cancel and is likely stuck in the driver, only a restart frees its worker
+            auto now = Clock::now();
+            if (std::any_of(abandoned_.begin(), abandoned_.end(), [now](const auto& call) { return call.second < now; })) {
+                LOG(ERROR) << "Plugin host of " << path_ << " is still running a call cancelled "
+                           << PLUGIN_HOST_CANCEL_GRACE_MS << " ms ago, killing it" << std::endl;
+                break;
+            }
+        }
+        // closed after the child exited, the child wrote garbage and is not trusted anymore, or it hung.
+        // Not reaped until the supervisor joins this thread, the pid cannot be reused meanwhile.
+        kill(pid, SIGKILL);
+    }
+
+    bool PluginHost::Spawn(const std::string& library, nlohmann::ordered_json* description) {
+        std::shared_ptr<ShmChannel> channel(ShmChannel::Create(PLUGIN_HOST_RING_SIZE));
+        if (!channel) {
+            LOG(ERROR) << "Cannot create the channel of the plugin host for " << path_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        // everything the child needs is built before fork, the server is multithreaded
+        int fd = channel->Fd();
+        std::string fdArgument = std::to_string(fd);
+        std::string describeArgument = description ? "1" : "0";
+        char* arguments[] = {const_cast<char*>("mcp-plugin-host"), const_cast<char*>(PLUGIN_HOST_ARGUMENT),
+                             fdArgument.data(), const_cast<char*>(library.c_str()), describeArgument.data(), nullptr};
+        pid_t parent = getpid();
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            LOG(ERROR) << "Cannot start the plugin host for " << path_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        if (pid == 0) {
+            // async-signal-safe calls only until exec
+            fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) & ~FD_CLOEXEC);
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (getppid() != parent) _exit(127);
+            // stdin and stdout may carry the stdio transport, the child must neither read nor write them
+            int null = open("/dev/null", O_RDONLY);
+            if (null >= 0) dup2(null, STDIN_FILENO);
+            dup2(STDERR_FILENO, STDOUT_FILENO);
+            execv("/proc/self/exe", arguments);
+            _exit(127);
+        }
+
+        // the child says hello once its plugin is initialized, or that it failed to load it
+        auto start = Clock::now();
+        ChannelMessage hello;
+        int read;
+        while (true) {
+            read = channel->Responses().Read(hello, 100);
+            if (read == 1 && hello.kind == ChannelKind::Notify) {
+                // sent by the plugin while it initializes
+                if (notify_) notify_(hello.first.c_str(), hello.second.c_str());
+                continue;
+            }
+            if (read != 0) break;
+            siginfo_t info{};
+            bool exited = waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid;
+            bool stopping;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping = stopping_;
+            }
+            if (exited || stopping || Clock::now() - start > std::chrono::milliseconds(PLUGIN_HOST_START_TIMEOUT_MS)) break;
+        }
+
+        bool ready = read == 1 && hello.kind == ChannelKind::Hello && hello.status == 0;
+        nlohmann::ordered_json info;
+        if (ready) {
+            info = nlohmann::ordered_json::parse(hello.first, nullptr, false);
+            ready = info.is_object() && info.contains("name") && info["name"].is_string() &&
+                    (!description || info.contains("description"));
+        }
+        if (!ready) {
+            LOG(ERROR) << "Plugin host failed to load " << path_ << std::endl;
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == State::Starting) {
+            // a restart keeps what the first child reported, the routes were built on it
+            name_ = info["name"].get<std::string>();
+            version_ = info.value("version", "");
+            abiVersion_ = info.value("abiVersion", 1u);
+            if (description) *description = std::move(info["description"]);
+        }
+        pid_ = pid;
+        channel_ = channel;
+        reader_ = std::thread(&PluginHost::ReadResponses, this, channel, pid);
+        state_ = State::Running;
+        stateChanged_.notify_all();
+        return true;
+    }
+
+    void PluginHost::Supervise(std::string library, nlohmann::ordered_json* description) {
+        int backoff = PLUGIN_HOST_MIN_BACKOFF_MS;
+        size_t restarts = 0;
+        bool first = true;
+        while (true) {
+            // the first child may load a private copy, restarts load the library itself
+            auto spawnedAt = Clock::now();
+            bool spawned = Spawn(first ? library : path_, first ? description : nullptr);
+            if (first && !spawned) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                state_ = State::Stopped;
+                stateChanged_.notify_all();
+                return;
+            }
+            first = false;
+
+            if (spawned) {
+                int pid;
+                std::shared_ptr<ShmChannel> channel;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    pid = pid_;
+                    channel = channel_;
+                }
+                if (restarts > 0) {
+                    LOG(INFO) << "Plugin host of " << path_ << " restarted (pid " << pid << ", restart " << restarts << ")" << std::endl;
+                }
+
+                // left unreaped so that Stop() and the reader cannot signal a reused pid
+                siginfo_t info{};
+                while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {}
+                channel->Close();
+                reader_.join();
+
+                std::unordered_map<uint64_t, PendingCall*> failed;
+                bool stopping;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    pid_ = -1;
+                    channel_.reset();
+                    failed.swap(pending_);
+                    abandoned_.clear();
+                    uint64_t consumed = channel->Requests().Consumed();
+                    for (auto& [id, call] : failed) {
+                        call->failed = true;
+                        call->consumed = consumed;
+                        call->finished = true;
+                        call->done.notify_one();
+                    }
+                    stopping = stopping_;
+                    state_ = stopping ? State::Stopped : State::Restarting;
+                }
+                stateChanged_.notify_all();
+                int status = 0;
+                waitpid(pid, &status, 0);
+                if (stopping) return;
+
+                std::string reason = WIFSIGNALED(status) ? "killed by signal " + std::to_string(WTERMSIG(status))
+                                                         : "exited with code " + std::to_string(WEXITSTATUS(status));
+                LOG(ERROR) << "Plugin host of " << path_ << " " << reason << " with " << failed.size()
+                           << " calls pending, restarting in " << backoff << " ms" << std::endl;
+                // a child that ran for a while crashed on a call, not at startup
+                if (Clock::now() - spawnedAt > std::chrono::milliseconds(PLUGIN_HOST_MAX_BACKOFF_MS)) {
+                    backoff = PLUGIN_HOST_MIN_BACKOFF_MS;
+                }
+            } else {
+                LOG(ERROR) << "Restart of the plugin host of " << path_ << " failed, retrying in " << backoff << " ms" << std::endl;
+            }
+            restarts++;
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stateChanged_.wait_for(lock, std::chrono::milliseconds(backoff), [this]() { return stopping_; })) {
+                state_ = State::Stopped;
+                stateChanged_.notify_all();
+                return;
+            }
+            backoff = std::min(backoff * 2, PLUGIN_HOST_MAX_BACKOFF_MS);
+        }
+    }
+
+    //============================================================================================
+    // child side
+    //============================================================================================
+
+    // Responses of the child: results of the workers and notifications of the plugin threads
+    static ShmChannel* g_hostChannel = nullptr;
+    static std::mutex g_hostWriteMutex;
+
+    static void WriteResponse(const ChannelMessage& message) {
+        std::lock_guard<std::mutex> lock(g_hostWriteMutex);
+        if (!g_hostChannel->Responses().Write(message) && message.kind == ChannelKind::Result) {
+            // too large for the ring, the host answers with an internal error
+            LOG(ERROR) << "Result of " << message.first.size() << " bytes does not fit in the plugin host channel" << std::endl;
+            g_hostChannel->Responses().Write(ChannelMessage{ChannelKind::Result, PLUGIN_RESULT_ERROR, message.id, {}, {}});
+        }
+    }
+
+    static void ForwardNotification(const char* pluginName, const char* notification) {
+        WriteResponse(ChannelMessage{ChannelKind::Notify, 0, 0, pluginName ? pluginName : "", notification ? notification : ""});
+    }
+
+    static int AppendToString(PluginBuffer* buffer, const char* data, size_t length) {
+        try {
+            static_cast<std::string*>(buffer->context)->append(data, length);
+            return 0;
+        } catch (...) {
+            return -1;
+        }
+    }
+
+    // A call taken from the channel. Whoever claims it first answers it: a worker starting it, or
+    // the reader when the host cancels it while it is still queued
+    struct ChildCall {
+        CancelToken cancel;
+        std::atomic<bool> claimed{false};
+    };
+
+    // Calls taken from the channel and not answered yet, cancelled by the host
+    static std::mutex g_callsMutex;
+    static std::unordered_map<uint64_t, std::shared_ptr<ChildCall>> g_calls;
+
+    static void Serve(const PluginEntry& entry, const ChannelMessage& request, ChildCall& call) {
+        // cancelled while queued, the reader answered it already
+        if (call.claimed.exchange(true)) return;
+        const CancelToken& cancel = call.cancel;
+        ChannelMessage response{ChannelKind::Result, PLUGIN_RESULT_ERROR, request.id, {}, {}};
+        if (request.kind == ChannelKind::CallV2 && entry.extensions) {
+            PluginRequest pluginRequest{request.second.data(), request.second.size(), request.first.data(), request.first.size()};
+            PluginBuffer out{&response.first, AppendToString};
+            response.status = HandlePluginRequest(entry.extensions, &pluginRequest, &out, &cancel);
+        } else if (request.kind == ChannelKind::CallV1) {
+            char* result = entry.instance->HandleRequest(request.first.c_str());
+            if (result) {
+                response.first = result;
+                response.status = PLUGIN_RESULT_OK;
+                delete[] result;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_callsMutex);
+            g_calls.erase(request.id);
+        }
+        WriteResponse(response);
+    }
+
+    int RunPluginHost(int argc, char** argv) {
+        if (argc < 5) return 2;
+        // Ctrl+C reaches the whole process group, the server decides when the child stops
+        signal(SIGINT, SIG_IGN);
+        AixLog::Log::init<AixLog::SinkCerr>(AixLog::Severity::warning);
+
+        std::unique_ptr<ShmChannel> channel = ShmChannel::Attach(atoi(argv[2]));
+        if (!channel) {
+            LOG(ERROR) << "Plugin host cannot map its channel" << std::endl;
+            return 2;
+        }
+        g_hostChannel = channel.get();
+        std::string library = argv[3];
+        bool describe = std::string(argv[4]) == "1";
+
+        PluginsLoader loader;
+        loader.SetNotificationCallback(ForwardNotification);
+        nlohmann::ordered_json known = nlohmann::ordered_json::object();
+        std::shared_ptr<PluginEntry> plugin = loader.LoadPlugin(library, describe ? nullptr : &known);
+
+        ChannelMessage hello{ChannelKind::Hello, plugin ? 0 : 1, 0, {}, {}};
+        if (plugin) {
+            nlohmann::ordered_json info;
+            info["name"] = plugin->instance->GetName();
+            info["version"] = plugin->instance->GetVersion();
+            info["abiVersion"] = plugin->extensions ? plugin->extensions->abiVersion : 1;
+            if (describe) info["description"] = plugin->description;
+            hello.first = info.dump();
+        }
+        WriteResponse(hello);
+        if (!plugin) return 1;
+
+        ThreadPool pool(PLUGIN_HOST_WORKERS, PLUGIN_HOST_QUEUE_DEPTH);
+        auto request = std::make_shared<ChannelMessage>();
+        while (channel->Requests().Read(*request, -1) == 1 && request->kind != ChannelKind::Shutdown) {
+            if (request->kind == ChannelKind::Cancel) {
+                // the call may be answered already. One still queued behind busy workers is answered
+                // here: the host only waits for that to forget it, and kills a child that is too late
+                bool queued = false;
+                {
+                    std::lock_guard<std::mutex> lock(g_callsMutex);
+                    auto it = g_calls.find(request->id);
+                    if (it != g_calls.end()) {
+                        it->second->cancel.Cancel(CancelToken::Reason::Cancelled);
+                        queued = !it->second->claimed.exchange(true);
+                        if (queued) g_calls.erase(it);
+                    }
+                }
+                if (queued) WriteResponse(ChannelMessage{ChannelKind::Result, PLUGIN_RESULT_ERROR, request->id, {}, {}});
+                continue;
+            }
+            auto call = std::make_shared<ChildCall>();
+            {
+                std::lock_guard<std::mutex> lock(g_callsMutex);
+                g_calls[request->id] = call;
+            }
+            // never wait for a worker here: the cancels and the shutdown behind this call must be read
+            if (!pool.TrySubmit([&plugin, request, call]() { Serve(*plugin, *request, *call); })) {
+                LOG(WARNING) << "Plugin host of " << library << " is busy, refusing call " << request->id << std::endl;
+                {
+                    std::lock_guard<std::mutex> lock(g_callsMutex);
+                    g_calls.erase(request->id);
+                }
+                WriteResponse(ChannelMessage{ChannelKind::Result, PLUGIN_RESULT_ERROR, request->id, {}, {}});
+                continue;
+            }
+            request = std::make_shared<ChannelMessage>();
+        }
+        // the calls already taken are answered before the plugin goes away
+        pool.Shutdown();
+        PluginsLoader::UnloadPlugin(*plugin);
+        return 0;
+    }
+#else
+    bool PluginHost::Supported() {
+        return false;
+    }
+
+    bool PluginHost::Start(const std::string&, nlohmann::ordered_json*) {
+        return false;
+    }
+
+    void PluginHost::Stop() {}
+
+    bool PluginHost::Call(ChannelMessage&, PendingCall&, const CancelToken*) {
+        return false;
+    }
+
+    int RunPluginHost(int, char**) {
+        return 2;
+    }
+#endif
+
+}
@@ -0,0 +1,160 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef MCP_SERVER_PLUGIN_HOST_H
+#define MCP_SERVER_PLUGIN_HOST_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "json.hpp"
+#include "PluginAPI.h"
+#include "../utils/CancelToken.h"
+
+// First argument of the server binary started as a plugin host child
+#define PLUGIN_HOST_ARGUMENT "--plugin-host"
+// Max time a child gets to load and initialize its plugin
+#define PLUGIN_HOST_START_TIMEOUT_MS 10000
+// Max time a call waits for a crashed child to be restarted before failing
+#define PLUGIN_HOST_RESTART_WAIT_MS 5000
+// Max time a child gets to unload its plugin before being killed
+#define PLUGIN_HOST_STOP_TIMEOUT_MS 2000
+// Delay before restarting a crashed child, doubled after every crash that follows quickly
+#define PLUGIN_HOST_MIN_BACKOFF_MS 100
+#define PLUGIN_HOST_MAX_BACKOFF_MS 5000
+// Calls a child runs at once, and calls it queues beyond them; a call past the queue is
+// answered with an error at once, the child never stops reading its channel
+#define PLUGIN_HOST_WORKERS 4
+#define PLUGIN_HOST_QUEUE_DEPTH 64
+// Time a child gets to return from a cancelled call before it is killed as hung and restarted
+#define PLUGIN_HOST_CANCEL_GRACE_MS 2000
+// Period of the hung call check, and max time spent telling a child about a cancelled call
+#define PLUGIN_HOST_HANG_CHECK_MS 250
+
+namespace vx::mcp {
+
+    class ShmChannel;
+    struct ChannelMessage;
+
+    // One plugin running in a child process (--isolate): a crash or an abort in the plugin or
+    // in the driver it calls only takes the child down. The child is the server binary started
+    // again with PLUGIN_HOST_ARGUMENT, it loads the library like the loader does in process and
+    // serves the calls coming through a ShmChannel.
+    //
+    // A supervisor thread spawns the child, waits for it to exit and starts it again with a
+    // backoff. The calls the crashed child had taken fail, the ones still queued in the channel
+    // and the calls made while it restarts go to the new one. The child is killed if the
+    // server goes away.
+    //
+    // A cancelled call returns at once and the child is told, so that an ABI v4 plugin stops
+    // working on it. A child still busy with it after PLUGIN_HOST_CANCEL_GRACE_MS is killed:
+    // the restart is what frees a worker stuck in the driver.
+    //
+    // Linux only, Supported() is false elsewhere and the plugins are loaded in process.
+    class PluginHost {
+    public:
+        // path is the library loaded again at every restart
+        PluginHost(std::string path, ClientNotificationCallback notify);
+        ~PluginHost();
+
+        PluginHost(const PluginHost&) = delete;
+        PluginHost& operator=(const PluginHost&) = delete;
+
+        static bool Supported();
+
+        // Start the child on library (a copy of path with hot reload) and wait for its plugin to be
+        // initialized. description receives what the plugin lists, unless nullptr. false when the
+        // child could not be started or the plugin failed to load, nothing is restarted then.
+        bool Start(const std::string& library, nlohmann::ordered_json* description);
+
+        // Unload the plugin and end the child, the calls still waiting fail
+        void Stop();
+
+        const std::string& Name() const { return name_; }
+        const std::string& Version() const { return version_; }
+        uint32_t AbiVersion() const { return abiVersion_; }
+
+        // HandleRequestV2 in the child. false when the child died during the call or is not back
+        // after PLUGIN_HOST_RESTART_WAIT_MS, or when cancel fired
+        bool CallV2(std::string_view name, std::string_view params, std::string& result, PluginResult& status,
+                    const CancelToken* cancel = nullptr);
+        // HandleRequest in the child, result is empty when the plugin returned nullptr
+        bool CallV1(std::string_view request, std::string& result, const CancelToken* cancel = nullptr);
+
+    private:
+        enum class State { Starting, Running, Restarting, Stopped };
+
+        struct PendingCall {
+            std::condition_variable done;
+            bool finished = false;
+            bool failed = false;
+            bool cancelled = false;
+            uint64_t consumed = 0;  // taken by the child when it died, see Call()
+            int32_t status = 0;
+            std::string result;
+        };
+
+        void Supervise(std::string library, nlohmann::ordered_json* description);
+        // Fork and exec a child on library and wait for its hello, on the supervisor thread
+        bool Spawn(const std::string& library, nlohmann::ordered_json* description);
+        void ReadResponses(std::shared_ptr<ShmChannel> channel, int pid);
+        bool Call(ChannelMessage& request, PendingCall& call, const CancelToken* cancel);
+
+    private:
+        std::string path_;
+        ClientNotificationCallback notify_;
+        std::string name_;
+        std::string version_;
+        uint32_t abiVersion_ = 1;
+
+        std::mutex mutex_;
+        std::condition_variable stateChanged_;
+        State state_ = State::Starting;
+        bool stopping_ = false;
+        int pid_ = -1;
+        std::shared_ptr<ShmChannel> channel_;
+        uint64_t nextId_ = 0;
+        std::unordered_map<uint64_t, PendingCall*> pending_;
+        // cancelled calls the child still runs, by the time it is considered hung
+        std::unordered_map<uint64_t, std::chrono::steady_clock::time_point> abandoned_;
+
+        std::timed_mutex writeMutex_;  // the callers take turns as the producer of the request ring
+        std::thread supervisor_;
+        std::thread reader_;
+    };
+
+    // main() of a plugin host child, argv as built by PluginHost
+    int RunPluginHost(int argc, char** argv);
+
+}
+
+#endif //MCP_SERVER_PLUGIN_HOST_H
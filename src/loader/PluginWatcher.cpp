@@ -0,0 +1,238 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "PluginWatcher.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "aixlog.hpp"
+
+namespace vx::mcp {
+
+    PluginWatcher::PluginWatcher(std::shared_ptr<PluginsLoader> loader, std::string directory, ChangeHandler onChange)
+        : loader_(std::move(loader)), directory_(std::move(directory)), onChange_(std::move(onChange)) {}
+
+    PluginWatcher::~PluginWatcher() {
+        Stop();
+    }
+
+    bool PluginWatcher::Start() {
+        if (running_) return true;
+#ifdef __linux__
+        inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        wake_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (inotify_ < 0 || wake_ < 0) {
+            LOG(ERROR) << "Failed to watch the plugins directory: " << strerror(errno) << std::endl;
+            Stop();
+            return false;
+        }
+        AddWatches(directory_);
+        if (watches_.empty()) {
+            LOG(ERROR) << "Failed to watch the plugins directory " << directory_.string() << std::endl;
+            Stop();
+            return false;
+        }
+#else
+        Scan(false);
+#endif
+        running_ = true;
+        thread_ = std::thread(&PluginWatcher::Run, this);
+        LOG(INFO) << "Watching " << directory_.string() << " for plugin changes" << std::endl;
+        return true;
+    }
+
+    void PluginWatcher::Stop() {
+        running_ = false;
+#ifdef __linux__
+        if (wake_ >= 0) {
+            uint64_t one = 1;
+            [[maybe_unused]] auto written = write(wake_, &one, sizeof(one));
+        }
+#else
+        {
+            std::lock_guard<std::mutex> lock(stopMutex_);
+        }
+        stopCv_.notify_all();
+#endif
+        if (thread_.joinable()) thread_.join();
+#ifdef __linux__
+        if (inotify_ >= 0) close(inotify_);
+        if (wake_ >= 0) close(wake_);
+        inotify_ = -1;
+        wake_ = -1;
+        watches_.clear();
+#endif
+    }
+
+    void PluginWatcher::Run() {
+        using namespace std::chrono;
+        while (running_) {
+            // sleep until the next library settles, or the next look at the retired plugins
+            milliseconds timeout(-1);
+            if (!pending_.empty()) {
+                auto next = pending_.begin()->second;
+                for (const auto& [path, changed] : pending_) next = std::min(next, changed);
+                auto due = duration_cast<milliseconds>(next + milliseconds(PLUGIN_RELOAD_DEBOUNCE_MS) - steady_clock::now());
+                timeout = std::max(due, milliseconds(0));
+            }
+            if (retired_ > 0 && (timeout.count() < 0 || timeout > milliseconds(PLUGIN_RETIRED_POLL_MS))) {
+                timeout = milliseconds(PLUGIN_RETIRED_POLL_MS);
+            }
+
+            WaitForChanges(timeout);
+            if (!running_) break;
+            ReloadSettled();
+            retired_ = loader_->ReleaseRetired();
+        }
+    }
+
+    void PluginWatcher::ReloadSettled() {
+        auto now = std::chrono::steady_clock::now();
+        auto before = loader_->GetIndex();
+        bool changed = false;
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (now - it->second < std::chrono::milliseconds(PLUGIN_RELOAD_DEBOUNCE_MS)) {
+                ++it;
+                continue;
+            }
+            LOG(INFO) << "Plugin library changed: " << it->first << std::endl;
+            changed = loader_->ReloadPlugin(it->first) || changed;
+            it = pending_.erase(it);
+        }
+        if (changed && onChange_) {
+            onChange_(*before, *loader_->GetIndex());
+        }
+    }
+
+    void PluginWatcher::MarkChanged(const std::string& path) {
+        pending_[path] = std::chrono::steady_clock::now();
+    }
+
+    void PluginWatcher::MarkDirectory(const std::filesystem::path& directory) {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (it->is_regular_file(error) && PluginsLoader::IsPluginLibrary(it->path())) {
+                MarkChanged(it->path().string());
+            }
+        }
+        // and the ones it no longer has, e.g. a subdirectory moved away
+        std::string prefix = (directory / "").string();
+        for (const auto& plugin : loader_->GetIndex()->plugins) {
+            if (plugin->path.compare(0, prefix.size(), prefix) == 0) MarkChanged(plugin->path);
+        }
+    }
+
+#ifdef __linux__
+    void PluginWatcher::AddWatches(const std::filesystem::path& directory) {
+        constexpr uint32_t mask = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR;
+        int wd = inotify_add_watch(inotify_, directory.c_str(), mask);
+        if (wd < 0) {
+            LOG(WARNING) << "Cannot watch " << directory.string() << ": " << strerror(errno) << std::endl;
+            return;
+        }
+        watches_[wd] = directory;
+
+        std::error_code error;
+        for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+            if (it->is_directory(error) && !it->is_symlink(error)) AddWatches(it->path());
+        }
+    }
+
+    void PluginWatcher::WaitForChanges(std::chrono::milliseconds timeout) {
+        pollfd fds[2] = {{inotify_, POLLIN, 0}, {wake_, POLLIN, 0}};
+        if (poll(fds, 2, static_cast<int>(timeout.count())) <= 0 || (fds[1].revents & POLLIN)) return;
+
+        alignas(inotify_event) char buffer[16 * 1024];
+        for (;;) {
+            ssize_t length = read(inotify_, buffer, sizeof(buffer));
+            if (length <= 0) break;
+            for (char* p = buffer; p < buffer + length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    LOG(WARNING) << "Plugin watch events lost, checking the whole directory" << std::endl;
+                    MarkDirectory(directory_);
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    watches_.erase(event->wd);
+                    continue;
+                }
+                auto watch = watches_.find(event->wd);
+                if (watch == watches_.end() || event->len == 0) continue;
+
+                std::filesystem::path path = watch->second / event->name;
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) AddWatches(path);
+                    MarkDirectory(path);
+                } else if (PluginsLoader::IsPluginLibrary(path)) {
+                    MarkChanged(path.string());
+                }
+            }
+        }
+    }
+#else
+    void PluginWatcher::Scan(bool mark) {
+        std::unordered_map<std::string, std::pair<std::filesystem::file_time_type, uintmax_t>> files;
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory_, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            std::error_code fileError;
+            if (!it->is_regular_file(fileError) || !PluginsLoader::IsPluginLibrary(it->path())) continue;
+            auto stamp = std::make_pair(it->last_write_time(fileError), it->file_size(fileError));
+            std::string path = it->path().string();
+            auto known = files_.find(path);
+            if (mark && (known == files_.end() || known->second != stamp)) MarkChanged(path);
+            files.emplace(std::move(path), stamp);
+        }
+        if (mark) {
+            for (const auto& [path, stamp] : files_) {
+                if (!files.count(path)) MarkChanged(path);
+            }
+        }
+        files_ = std::move(files);
+    }
+
+    void PluginWatcher::WaitForChanges(std::chrono::milliseconds timeout) {
+        if (timeout.count() < 0 || timeout > std::chrono::milliseconds(PLUGIN_SCAN_INTERVAL_MS)) {
+            timeout = std::chrono::milliseconds(PLUGIN_SCAN_INTERVAL_MS);
+        }
+        {
+            std::unique_lock<std::mutex> lock(stopMutex_);
+            if (stopCv_.wait_for(lock, timeout, [this] { return !running_; })) return;
+        }
+        Scan(true);
+    }
+#endif
+
+}
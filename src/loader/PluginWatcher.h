@@ -0,0 +1,111 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef MCP_SERVER_PLUGIN_WATCHER_H
+#define MCP_SERVER_PLUGIN_WATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "PluginsLoader.h"
+
+// A library is reloaded once it has not changed for this long, a build writes it in several steps
+#define PLUGIN_RELOAD_DEBOUNCE_MS 250
+// How often the retired plugins are checked for calls still running on them
+#define PLUGIN_RETIRED_POLL_MS 100
+// Scan period of the plugins directory where inotify is not available
+#define PLUGIN_SCAN_INTERVAL_MS 1000
+
+namespace vx::mcp {
+
+    // Hot reload of the plugins directory (--watch): a library that is rebuilt, added or
+    // removed is reloaded through PluginsLoader::ReloadPlugin, and the versions it replaces
+    // are unloaded from this thread once the calls running on them are done.
+    //
+    // Changes come from inotify on Linux, with a watch on every subdirectory, and from a
+    // periodic scan elsewhere. onChange runs on the watcher thread after every batch of
+    // reloads, with the routing index before and after it.
+    class PluginWatcher {
+    public:
+        using ChangeHandler = std::function<void(const PluginsIndex& before, const PluginsIndex& after)>;
+
+        PluginWatcher(std::shared_ptr<PluginsLoader> loader, std::string directory, ChangeHandler onChange);
+        ~PluginWatcher();
+
+        PluginWatcher(const PluginWatcher&) = delete;
+        PluginWatcher& operator=(const PluginWatcher&) = delete;
+
+        bool Start();
+        void Stop();
+
+    private:
+        void Run();
+        // Wait up to timeout (negative: no limit) for changes, and mark the libraries touched
+        void WaitForChanges(std::chrono::milliseconds timeout);
+        // Reload the libraries left alone for PLUGIN_RELOAD_DEBOUNCE_MS
+        void ReloadSettled();
+        void MarkChanged(const std::string& path);
+        // Every library under directory, and every loaded plugin that was in it
+        void MarkDirectory(const std::filesystem::path& directory);
+#ifdef __linux__
+        void AddWatches(const std::filesystem::path& directory);
+#else
+        // Compares the directory with the last scan, marks what changed when mark is set
+        void Scan(bool mark);
+#endif
+
+    private:
+        std::shared_ptr<PluginsLoader> loader_;
+        std::filesystem::path directory_;
+        ChangeHandler onChange_;
+
+        std::map<std::string, std::chrono::steady_clock::time_point> pending_; // library, last change
+        size_t retired_ = 0;
+
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+#ifdef __linux__
+        int inotify_ = -1;
+        int wake_ = -1; // eventfd signalled by Stop()
+        std::unordered_map<int, std::filesystem::path> watches_;
+#else
+        std::mutex stopMutex_;
+        std::condition_variable stopCv_;
+        std::unordered_map<std::string, std::pair<std::filesystem::file_time_type, uintmax_t>> files_;
+#endif
+    };
+
+}
+
+#endif //MCP_SERVER_PLUGIN_WATCHER_H
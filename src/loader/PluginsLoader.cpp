@@ -22,50 +22,381 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "PluginsLoader.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+#include "json.hpp"
+#include "PluginCache.h"
+#include "../server/Metrics.h"
+#include "../utils/ThreadPool.h"
 
 namespace vx::mcp {
 
+    using Clock = std::chrono::steady_clock;
+
+    static double ElapsedMs(Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Fields past HandleRequestV2 are only read when the plugin table is recent and large enough to have them
+    static const char* GetToolOutputSchema(const PluginExtensions* extensions, int index) {
+        constexpr size_t v3Size = offsetof(PluginExtensions, GetToolOutputSchema) + sizeof(PluginExtensions::GetToolOutputSchema);
+        if (!extensions || extensions->abiVersion < 3 || extensions->size < v3Size || !extensions->GetToolOutputSchema) {
+            return nullptr;
+        }
+        return extensions->GetToolOutputSchema(index);
+    }
+
+    // "<size>-<hash of the content>", empty if the file cannot be read. FNV-1a taking 8 bytes
+    // per step: the libraries are hashed at every start, byte steps would cost more than dlopen
+    static std::string HashFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return {};
+        uint64_t hash = 14695981039346656037ull;
+        uint64_t size = 0;
+        char buffer[64 * 1024];
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+            size_t count = static_cast<size_t>(file.gcount());
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, buffer + i, sizeof(word));
+                hash = (hash ^ word) * 1099511628211ull;
+            }
+            for (; i < count; i++) {
+                hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ull;
+            }
+            size += count;
+        }
+        if (file.bad()) return {};
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+        return std::to_string(size) + "-" + hex;
+    }
+
+    static std::string ManifestPath(const std::string& path) {
+        return path + PLUGIN_MANIFEST_SUFFIX;
+    }
+
+    // What the clients see of a plugin, also the content of its manifest. A tool or prompt
+    // with an invalid schema keeps its route but has no schema, and is left out of the lists.
+    static nlohmann::ordered_json Describe(const PluginEntry& entry) {
+        PluginAPI* instance = entry.instance;
+        nlohmann::ordered_json description;
+        description["name"] = instance->GetName();
+        description["version"] = instance->GetVersion();
+        description["type"] = instance->GetType();
+        description["tools"] = nlohmann::ordered_json::array();
+        description["prompts"] = nlohmann::ordered_json::array();
+        description["resources"] = nlohmann::ordered_json::array();
+        switch (instance->GetType()) {
+            case PLUGIN_TYPE_TOOLS:
+                for (int i = 0; i < instance->GetToolCount(); i++) {
+                    auto pluginTool = instance->GetTool(i);
+                    nlohmann::ordered_json tool;
+                    tool["name"] = pluginTool->name;
+                    tool["description"] = pluginTool->description;
+                    try {
+                        auto inputSchema = nlohmann::ordered_json::parse(pluginTool->inputSchema);
+                        const char* outputSchema = GetToolOutputSchema(entry.extensions, i);
+                        auto parsedOutputSchema = outputSchema ? nlohmann::ordered_json::parse(outputSchema) : nlohmann::ordered_json();
+                        tool["inputSchema"] = std::move(inputSchema);
+                        if (outputSchema) tool["outputSchema"] = std::move(parsedOutputSchema);
+                    } catch (const std::exception& ex) {
+                        LOG(ERROR) << "Invalid schema for tool " << pluginTool->name << ": " << ex.what() << std::endl;
+                    }
+                    description["tools"].push_back(std::move(tool));
+                }
+                break;
+            case PLUGIN_TYPE_PROMPTS:
+                for (int i = 0; i < instance->GetPromptCount(); i++) {
+                    auto pluginPrompt = instance->GetPrompt(i);
+                    nlohmann::ordered_json prompt;
+                    prompt["name"] = pluginPrompt->name;
+                    prompt["description"] = pluginPrompt->description;
+                    try {
+                        prompt["arguments"] = nlohmann::ordered_json::parse(pluginPrompt->arguments);
+                    } catch (const std::exception& ex) {
+                        LOG(ERROR) << "Invalid arguments for prompt " << pluginPrompt->name << ": " << ex.what() << std::endl;
+                    }
+                    description["prompts"].push_back(std::move(prompt));
+                }
+                break;
+            case PLUGIN_TYPE_RESOURCES:
+                for (int i = 0; i < instance->GetResourceCount(); i++) {
+                    auto pluginResource = instance->GetResource(i);
+                    nlohmann::ordered_json resource;
+                    resource["name"] = pluginResource->name;
+                    resource["description"] = pluginResource->description;
+                    resource["uri"] = pluginResource->uri;
+                    resource["mimeType"] = pluginResource->mime;
+                    description["resources"].push_back(std::move(resource));
+                }
+                break;
+        }
+        return description;
+    }
+
+    // A manifest is only trusted as far as RebuildIndex reads it
+    static bool IsValidDescription(const nlohmann::ordered_json& description) {
+        if (!description.is_object() || !description.contains("name") || !description["name"].is_string()) return false;
+        for (const char* list : {"tools", "prompts", "resources"}) {
+            if (!description.contains(list) || !description[list].is_array()) return false;
+            const char* key = std::string_view(list) == "resources" ? "uri" : "name";
+            for (const auto& item : description[list]) {
+                if (!item.is_object() || !item.contains(key) || !item[key].is_string()) return false;
+            }
+        }
+        return true;
+    }
+
+    // The description in the manifest of path, if the manifest was written for this content of the library
+    static bool ReadManifest(const std::string& path, const std::string& hash, nlohmann::ordered_json& description) {
+        std::ifstream file(ManifestPath(path));
+        if (!file) return false;
+        auto manifest = nlohmann::ordered_json::parse(file, nullptr, false);
+        if (!manifest.is_object() || manifest.value("manifestVersion", 0) != PLUGIN_MANIFEST_VERSION ||
+            manifest.value("hash", "") != hash || !manifest.contains("plugin") || !IsValidDescription(manifest["plugin"])) {
+            return false;
+        }
+        description = std::move(manifest["plugin"]);
+        return true;
+    }
+
+    // Written aside and renamed over the previous one, a concurrent reader never sees half a manifest
+    static void WriteManifest(const PluginEntry& entry) {
+        nlohmann::ordered_json manifest;
+        manifest["manifestVersion"] = PLUGIN_MANIFEST_VERSION;
+        manifest["library"] = std::filesystem::path(entry.path).filename().string();
+        manifest["hash"] = entry.hash;
+        manifest["plugin"] = entry.description;
+
+        std::string path = ManifestPath(entry.path);
+        std::string temporary = path + "." + std::to_string(getpid()) + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::trunc);
+            file << manifest.dump(2);
+            if (!file.flush()) {
+                LOG(WARNING) << "Cannot write the manifest of " << entry.path << ", it is loaded at every start" << std::endl;
+                file.close();
+                std::error_code error;
+                std::filesystem::remove(temporary, error);
+                return;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        if (error) {
+            LOG(WARNING) << "Cannot write the manifest of " << entry.path << ": " << error.message() << std::endl;
+            std::filesystem::remove(temporary, error);
+        }
+    }
+
     PluginsLoader::PluginsLoader() = default;
 
     PluginsLoader::~PluginsLoader() {
         UnloadPlugins();
     }
 
-    bool PluginsLoader::LoadPlugins(const std::string& directory) {
-        try {
-            for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
-                if (entry.is_regular_file()) {
-                    std::string extension = entry.path().extension().string();
-
-                    // Check if this is a shared library
+    bool PluginsLoader::IsPluginLibrary(const std::filesystem::path& path) {
+        std::string extension = path.extension().string();
 #ifdef _WIN32
-                    if (extension == ".dll")
+        return extension == ".dll";
 #else
     #ifdef __APPLE__
-                    if (extension == ".dylib" || extension == ".so")
+        return extension == ".dylib" || extension == ".so";
     #else
-                    if (extension == ".so")
+        return extension == ".so";
     #endif
 #endif
-                    {
-                        LoadPlugin(entry.path().string());
-                    }
+    }
+
+    bool PluginsLoader::LoadPlugins(const std::string& directory, size_t threads) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto start = Clock::now();
+        std::vector<std::string> paths;
+        try {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+                // Check if this is a shared library
+                if (entry.is_regular_file() && IsPluginLibrary(entry.path())) {
+                    paths.push_back(entry.path().string());
                 }
             }
-            return true;
         } catch (const std::exception& ex) {
             LOG(ERROR) << "Error loading plugins: " << ex.what() << std::endl;
+            RebuildIndex();
             return false;
         }
+        // the directory order depends on the file system, the paths give the routes a stable precedence
+        std::sort(paths.begin(), paths.end());
+
+        // a library unchanged since the last start is described by the cache, without being hashed
+        m_cacheFile = (std::filesystem::path(directory) / PLUGIN_CACHE_FILE).string();
+        PluginCache cache;
+        cache.Open(m_cacheFile);
+
+        // hashing, dlopen and Initialize of every plugin run on the pool, each result lands in the slot of its path.
+        // LoadPlugin only reads the loader settings, which cannot change while m_mutex is held.
+        std::vector<std::shared_ptr<PluginEntry>> loaded(paths.size());
+        std::vector<PluginCacheKey> keys(paths.size());
+        std::vector<char> hits(paths.size(), 0);
+        auto load = [this, &paths, &loaded, &keys, &hits, &cache](size_t i) {
+            try {
+                PluginCacheRecord record;
+                if (PluginCacheKey::Of(paths[i], keys[i]) && cache.Find(keys[i], record)) {
+                    hits[i] = 1;
+                    loaded[i] = OpenPlugin(paths[i], m_lazy, &record);
+                } else {
+                    loaded[i] = OpenPlugin(paths[i], m_lazy);
+                }
+            } catch (const std::exception& ex) {
+                LOG(ERROR) << "Error loading plugin " << paths[i] << ": " << ex.what() << std::endl;
+            }
+        };
+        threads = std::max<size_t>(1, std::min(threads, paths.size()));
+        if (threads > 1) {
+            ThreadPool pool(threads, paths.size());
+            for (size_t i = 0; i < paths.size(); i++) {
+                pool.Submit([&load, i]() { load(i); });
+            }
+            // drains the queue and joins the workers, every slot is written past this point
+            pool.Shutdown();
+        } else {
+            for (size_t i = 0; i < paths.size(); i++) {
+                load(i);
+            }
+        }
+
+        // the cache describes the plugins found this time, it is written again when that changed
+        std::vector<PluginCacheRecord> records;
+        size_t hitCount = 0;
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (!loaded[i] || loaded[i]->hash.empty() || keys[i].path.empty()) continue;
+            records.push_back({keys[i], loaded[i]->hash, loaded[i]->description});
+            hitCount += hits[i];
+        }
+        bool stale = hitCount != records.size() || hitCount != cache.Size();
+        cache.Close();
+        if (stale) PluginCache::Write(m_cacheFile, records);
+
+        size_t count = 0;
+        size_t listed = 0;
+        for (auto& plugin : loaded) {
+            if (!plugin) continue;
+            if (!plugin->instance && !plugin->host) listed++;
+            m_plugins.push_back(std::move(plugin));
+            count++;
+        }
+        RebuildIndex();
+        LOG(INFO) << "Loaded " << count << " of " << paths.size() << " plugin libraries (" << listed << " not loaded until called, "
+                  << hitCount << " described by the cache) in "
+                  << ElapsedMs(start, Clock::now()) << " ms, " << threads << " at once" << std::endl;
+        return true;
+    }
+
+    std::shared_ptr<PluginEntry> PluginsLoader::OpenPlugin(const std::string& path, bool allowLazy, PluginCacheRecord* cached) {
+        auto start = Clock::now();
+        std::string hash;
+        nlohmann::ordered_json description;
+        bool known;
+        if (cached) {
+            // unchanged since the cache was written, the manifest would say the same
+            hash = std::move(cached->hash);
+            description = std::move(cached->description);
+            known = true;
+            std::error_code error;
+            if (!std::filesystem::exists(ManifestPath(path), error)) {
+                PluginEntry entry;
+                entry.path = path;
+                entry.hash = hash;
+                entry.description = description;
+                WriteManifest(entry);
+            }
+        } else {
+            hash = HashFile(path);
+            known = !hash.empty() && ReadManifest(path, hash, description);
+        }
+
+        if (known && allowLazy) {
+            auto plugin = std::make_shared<PluginEntry>();
+            plugin->path = path;
+            plugin->hash = std::move(hash);
+            plugin->description = std::move(description);
+            LOG(INFO) << "Listed plugin: " << plugin->description["name"].get<std::string>()
+                      << " v" << plugin->description.value("version", "") << " from its " << (cached ? "cache" : "manifest") << " in "
+                      << ElapsedMs(start, Clock::now()) << " ms, loaded on first call" << std::endl;
+            return plugin;
+        }
+
+        // a known build is not introspected again
+        auto plugin = LoadPlugin(path, known ? &description : nullptr);
+        if (plugin && !hash.empty()) {
+            plugin->hash = std::move(hash);
+            if (!known) WriteManifest(*plugin);
+        }
+        return plugin;
     }
 
-    bool PluginsLoader::LoadPlugin(const std::string& path) {
-        PluginEntry entry;
+    // ".<name>.<pid>.<n>" next to the library: its dependencies resolve the same way, and the
+    // extension keeps it out of the plugin scan and of the watcher
+    std::string PluginsLoader::CopyForLoading(const std::string& path) {
+        std::filesystem::path source(path);
+        std::filesystem::path copy = source.parent_path() /
+                ("." + source.filename().string() + "." + std::to_string(getpid()) + "." + std::to_string(++m_loadCount));
+        std::error_code error;
+        std::filesystem::copy_file(source, copy, std::filesystem::copy_options::overwrite_existing, error);
+        if (error) {
+            LOG(ERROR) << "Failed to copy plugin " << path << " for loading: " << error.message() << std::endl;
+            return {};
+        }
+        return copy.string();
+    }
+
+    std::shared_ptr<PluginEntry> PluginsLoader::LoadPlugin(const std::string& path, const nlohmann::ordered_json* description) {
+        auto start = Clock::now();
+        auto plugin = std::make_shared<PluginEntry>();
+        PluginEntry& entry = *plugin;
         entry.path = path;
+        std::string loadPath = path;
+        if (m_hotReload) {
+            loadPath = CopyForLoading(path);
+            if (loadPath.empty()) return nullptr;
+            entry.loadedPath = loadPath;
+        }
+
+        if (m_isolated) {
+            // the child loads the copy, restarts load the library itself
+            entry.host = std::make_unique<PluginHost>(path, m_notificationCallback);
+            nlohmann::ordered_json described;
+            bool started = entry.host->Start(loadPath, description ? nullptr : &described);
+            if (!started || (!description && !IsValidDescription(described))) {
+                LOG(ERROR) << "Failed to load plugin in a host process: " << path << std::endl;
+                UnloadPlugin(entry);
+                return nullptr;
+            }
+            if (!entry.loadedPath.empty()) {
+                std::error_code error;
+                std::filesystem::remove(entry.loadedPath, error);
+                entry.loadedPath.clear();
+            }
+            entry.description = description ? *description : std::move(described);
+            LOG(INFO) << "Loaded plugin: " << entry.host->Name() << " v" << entry.host->Version()
+                      << " (ABI v" << entry.host->AbiVersion() << ") in a host process in " << ElapsedMs(start, Clock::now()) << " ms" << std::endl;
+            return plugin;
+        }
 
         // Load the shared library
 #ifdef _WIN32
-        entry.handle = LoadLibraryA(path.c_str());
+        // the directory of the plugin is searched for its own dependencies, e.g. the shared IGCL session
+        entry.handle = LoadLibraryExA(std::filesystem::absolute(loadPath).string().c_str(), nullptr, LOAD_WITH_ALTERED_SEARCH_PATH);
         if (!entry.handle) {
             DWORD error = GetLastError();
             char errorMsg[256] = {0};
@@ -80,69 +411,253 @@ namespace vx::mcp {
             );
             LOG(ERROR) << "Failed to load plugin: " << path
                        << " - Error " << error << ": " << errorMsg << std::endl;
-            return false;
+            UnloadPlugin(entry);
+            return nullptr;
         }
         // Get function pointers
         entry.createFunc = (PluginAPI * (*)())GetProcAddress(entry.handle, "CreatePlugin");
         entry.destroyFunc = (void (*)(PluginAPI *))GetProcAddress(entry.handle, "DestroyPlugin");
+        void* extensionsSymbol = (void*)GetProcAddress(entry.handle, "GetPluginExtensions");
 #else
-        entry.handle = dlopen(path.c_str(), RTLD_LAZY);
+        entry.handle = dlopen(loadPath.c_str(), RTLD_LAZY);
         if (!entry.handle) {
             LOG(ERROR) << "Failed to load plugin: " << path << " - " << dlerror() << std::endl;
-            return false;
+            UnloadPlugin(entry);
+            return nullptr;
+        }
+        // the mapping outlives the file, the copy is not needed anymore
+        if (!entry.loadedPath.empty()) {
+            std::error_code error;
+            std::filesystem::remove(entry.loadedPath, error);
+            entry.loadedPath.clear();
         }
 
         // Get function pointers
         entry.createFunc = (PluginAPI * (*)())dlsym(entry.handle, "CreatePlugin");
         entry.destroyFunc = (void (*)(PluginAPI *))dlsym(entry.handle, "DestroyPlugin");
+        void* extensionsSymbol = dlsym(entry.handle, "GetPluginExtensions");
 #endif
 
         // Check if required functions were found
         if (!entry.createFunc || !entry.destroyFunc) {
-            LOG(ERROR) << "Plugin does not export required functions: " << path << std::endl;
-
-#ifdef _WIN32
-            FreeLibrary(entry.handle);
-#else
-            dlclose(entry.handle);
-#endif
-
-            return false;
+            // helper libraries shared by plugins may live next to them, they are not an error
+            LOG(WARNING) << "Skipping library without plugin entry points: " << path << std::endl;
+            UnloadPlugin(entry);
+            return nullptr;
         }
 
-        // Create plugin instance
+        // Create plugin instance, with the notification system ready before it initializes
+        auto loadedAt = Clock::now();
         entry.instance = entry.createFunc();
+        if (m_notificationCallback) {
+            entry.notifications = std::make_unique<NotificationSystem>();
+            entry.notifications->SendToClient = m_notificationCallback;
+            entry.instance->notifications = entry.notifications.get();
+        }
 
         // Initialize the plugin
         if (!entry.instance->Initialize()) {
-            LOG(ERROR) << "Plugin initialization failed: " << path << std::endl;
+            LOG(ERROR) << "Plugin initialization failed: " << path
+                       << " (init " << ElapsedMs(loadedAt, Clock::now()) << " ms)" << std::endl;
             entry.destroyFunc(entry.instance);
+            entry.instance = nullptr;
+            UnloadPlugin(entry);
+            return nullptr;
+        }
 
-#ifdef _WIN32
-            FreeLibrary(entry.handle);
-#else
-            dlclose(entry.handle);
-#endif
+        auto initializedAt = Clock::now();
 
-            return false;
-        }
+        // Optional ABI v2 entry points
+        entry.extensions = ResolveExtensions(entry, extensionsSymbol);
+        entry.description = description ? *description : Describe(entry);
 
-        // Add to a plugin list
-        m_plugins.push_back(entry);
+        // load covers the copy, dlopen and symbol lookup, init is CreatePlugin and Initialize
         LOG(INFO) << "Loaded plugin: " << entry.instance->GetName()
-                  << " v" << entry.instance->GetVersion() << std::endl;
+                  << " v" << entry.instance->GetVersion()
+                  << " (ABI v" << (entry.extensions ? entry.extensions->abiVersion : 1) << ")"
+                  << " load " << ElapsedMs(start, loadedAt) << " ms, init " << ElapsedMs(loadedAt, initializedAt) << " ms" << std::endl;
 
-        return true;
+        return plugin;
+    }
+
+    const PluginExtensions* PluginsLoader::ResolveExtensions(const PluginEntry& entry, void* symbol) {
+        if (!symbol) return nullptr;
+
+        auto getExtensions = (const PluginExtensions* (*)())symbol;
+        const PluginExtensions* extensions = getExtensions();
+        if (!extensions) return nullptr;
+
+        // only read the fields the plugin actually has, an older or broken table falls back to v1
+        constexpr size_t v2Size = offsetof(PluginExtensions, HandleRequestV2) + sizeof(extensions->HandleRequestV2);
+        if (extensions->abiVersion < 2 || extensions->size < v2Size || !extensions->HandleRequestV2) {
+            LOG(WARNING) << "Ignoring invalid plugin extensions of " << entry.path
+                         << ", falling back to ABI v1." << std::endl;
+            return nullptr;
+        }
+        return extensions;
     }
 
     void PluginsLoader::UnloadPlugins() {
-        for (auto& entry : m_plugins) {
-            UnloadPlugin(entry);
+        // unpublish the routes first, so no new lookup lands on a plugin being unloaded
+        std::vector<std::shared_ptr<PluginEntry>> plugins;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            plugins.swap(m_plugins);
+            plugins.insert(plugins.end(), m_retired.begin(), m_retired.end());
+            m_retired.clear();
+            RebuildIndex();
+        }
+
+        for (auto& entry : plugins) {
+            UnloadPlugin(*entry);
         }
-        m_plugins.clear();
+    }
+
+    void PluginsLoader::SetNotificationCallback(ClientNotificationCallback callback) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_notificationCallback = callback;
+    }
+
+    void PluginsLoader::EnableLazyActivation() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lazy = true;
+    }
+
+    void PluginsLoader::EnableIsolation() {
+        if (!PluginHost::Supported()) {
+            LOG(WARNING) << "Plugin isolation is not supported on this platform, loading the plugins in process" << std::endl;
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isolated = true;
+    }
+
+    void PluginsLoader::EnableHotReload() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hotReload = true;
+    }
+
+    bool PluginsLoader::ReloadPlugin(const std::string& path) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto current = std::find_if(m_plugins.begin(), m_plugins.end(), [&path](const auto& entry) { return entry->path == path; });
+
+        std::error_code error;
+        bool exists = std::filesystem::is_regular_file(path, error);
+        // a rebuilt plugin is loaded at once, a broken build must not replace the running version
+        std::shared_ptr<PluginEntry> plugin = exists ? OpenPlugin(path, false) : nullptr;
+        if (!plugin) {
+            if (exists || current == m_plugins.end()) {
+                if (current != m_plugins.end()) {
+                    LOG(WARNING) << "Keeping the running version of " << path << std::endl;
+                }
+                return false;
+            }
+            LOG(INFO) << "Plugin removed: " << path << std::endl;
+        }
+
+        // the new version takes the place of the old one, so duplicate routes resolve the same way
+        if (current != m_plugins.end()) {
+            m_retired.push_back(std::move(*current));
+            if (plugin) {
+                *current = std::move(plugin);
+            } else {
+                m_plugins.erase(current);
+            }
+        } else {
+            m_plugins.push_back(std::move(plugin));
+        }
+        RebuildIndex();
+        return true;
+    }
+
+    std::shared_ptr<const PluginsIndex> PluginsLoader::Activate(PluginEntry* listed) {
+        std::lock_guard<std::mutex> activation(listed->activation);
+        if (listed->activated) {
+            // loaded by the call that got here first, which published the index routing to it
+            return GetIndex();
+        }
+        listed->activated = true;
+
+        // loaded outside of m_mutex: the other plugins keep serving calls, and being loaded meanwhile
+        std::shared_ptr<PluginEntry> plugin = LoadPlugin(listed->path, &listed->description);
+        if (plugin) {
+            plugin->hash = listed->hash;
+        } else {
+            // a manifest is no reason to list a plugin that cannot load, the next start tries it again
+            LOG(ERROR) << "Failed to activate plugin " << listed->path << ", removing it" << std::endl;
+            std::error_code error;
+            std::filesystem::remove(ManifestPath(listed->path), error);
+            if (!m_cacheFile.empty()) std::filesystem::remove(m_cacheFile, error);
+        }
+
+        std::shared_ptr<const PluginsIndex> index;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto current = std::find_if(m_plugins.begin(), m_plugins.end(), [listed](const auto& entry) { return entry.get() == listed; });
+            if (current == m_plugins.end()) {
+                // reloaded or unloaded meanwhile, nothing routes to this one anymore
+                if (plugin) m_retired.push_back(std::move(plugin));
+            } else {
+                m_retired.push_back(std::move(*current));
+                if (plugin) {
+                    *current = std::move(plugin);
+                } else {
+                    m_plugins.erase(current);
+                }
+                RebuildIndex();
+            }
+            index = m_index.load(std::memory_order_acquire);
+        }
+        // the loader swapped the entry itself, without --watch nobody else would release it
+        ReleaseRetired();
+        return index;
+    }
+
+    const PluginRoute* PluginsLoader::Resolve(std::shared_ptr<const PluginsIndex>& index, RouteMap PluginsIndex::*map, std::string_view key) {
+        index = GetIndex();
+        const PluginRoute* route = PluginsIndex::Find((*index).*map, key);
+        // every round loads or drops one plugin, a failed one can leave the key to another listed plugin
+        while (route && !route->instance && !route->host) {
+            index = Activate(route->plugin);
+            route = PluginsIndex::Find((*index).*map, key);
+        }
+        return route;
+    }
+
+    size_t PluginsLoader::ReleaseRetired() {
+        std::vector<std::shared_ptr<PluginEntry>> unused;
+        size_t remaining;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // only the retired list owns them: no published index, hence no call, can reach them.
+            // An entry listed from its manifest has nothing to unload, the indexes still routing
+            // to it keep it alive by themselves
+            auto end = std::stable_partition(m_retired.begin(), m_retired.end(), [](const auto& entry) {
+                return entry.use_count() > 1 && (entry->handle || entry->host);
+            });
+            unused.assign(std::make_move_iterator(end), std::make_move_iterator(m_retired.end()));
+            m_retired.erase(end, m_retired.end());
+            remaining = m_retired.size();
+        }
+        // pairs with the release of the last index reference, the calls it served are complete
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        for (auto& entry : unused) {
+            // an entry listed from its manifest was never loaded
+            if (!entry->handle && !entry->host) continue;
+            LOG(INFO) << "Unloading previous version of " << entry->path << std::endl;
+            UnloadPlugin(*entry);
+        }
+        return remaining;
     }
 
     void PluginsLoader::UnloadPlugin(PluginEntry& entry) {
+        if (entry.host) {
+            // the child shuts the plugin down and unloads it
+            entry.host->Stop();
+            entry.host.reset();
+        }
+
         if (entry.instance) {
             // Shutdown the plugin
             entry.instance->Shutdown();
@@ -161,10 +676,88 @@ namespace vx::mcp {
 #endif
             entry.handle = nullptr;
         }
+
+        // a loaded copy can only be deleted once unloaded on Windows
+        if (!entry.loadedPath.empty()) {
+            std::error_code error;
+            std::filesystem::remove(entry.loadedPath, error);
+            entry.loadedPath.clear();
+        }
     }
 
-    const std::vector<PluginEntry>& PluginsLoader::GetPlugins() const {
+    const std::vector<std::shared_ptr<PluginEntry>>& PluginsLoader::GetPlugins() const {
         return m_plugins;
     }
 
+    std::shared_ptr<const PluginsIndex> PluginsLoader::GetIndex() const {
+        return m_index.load(std::memory_order_acquire);
+    }
+
+    void PluginsLoader::AddHostResource(const std::string& uri, const std::string& name, const std::string& description, const std::string& mime) {
+        nlohmann::ordered_json resource;
+        resource["name"] = name;
+        resource["description"] = description;
+        resource["uri"] = uri;
+        resource["mimeType"] = mime;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hostResources.push_back(std::move(resource));
+        RebuildIndex();
+    }
+
+    void PluginsLoader::RebuildIndex() {
+        auto index = std::make_shared<PluginsIndex>();
+
+        // a name already routed to another plugin is shadowed: neither routed nor listed, the
+        // clients would see it twice and reach the first plugin through both entries
+        auto addRoute = [this](RouteMap& map, const std::string& key, PluginEntry& entry, int i) {
+            Metrics& metrics = Metrics::GetInstance();
+            PluginRoute route{entry.instance, entry.extensions, i, &entry, entry.host.get(),
+                              &metrics.Get(Metrics::PLUGIN, key), &metrics.Get(Metrics::SERIALIZE, key)};
+            if (map.try_emplace(key, route).second) return true;
+            const std::string& name = entry.description["name"].get_ref<const std::string&>();
+            // every rebuild meets the same conflict again
+            if (m_conflicts.insert(name + '/' + key).second) {
+                LOG(WARNING) << "Duplicate route '" << key << "' in plugin " << name << ", keeping the first one." << std::endl;
+            }
+            return false;
+        };
+
+        // the list payloads cannot change until the next rebuild, serialize them once here
+        nlohmann::ordered_json tools = nlohmann::ordered_json::array();
+        nlohmann::ordered_json prompts = nlohmann::ordered_json::array();
+        nlohmann::ordered_json resources = nlohmann::ordered_json(m_hostResources);
+
+        // loaded plugins and plugins listed from their manifest are indexed the same way,
+        // only the routes of the latter have no instance yet
+        for (const auto& plugin : m_plugins) {
+            PluginEntry& entry = *plugin;
+            index->plugins.push_back(plugin);
+            const auto& description = entry.description;
+            int i = 0;
+            for (const auto& tool : description["tools"]) {
+                if (addRoute(index->tools, tool["name"].get_ref<const std::string&>(), entry, i++) && tool.contains("inputSchema")) {
+                    tools.push_back(tool);
+                }
+            }
+            i = 0;
+            for (const auto& prompt : description["prompts"]) {
+                if (addRoute(index->prompts, prompt["name"].get_ref<const std::string&>(), entry, i++) && prompt.contains("arguments")) {
+                    prompts.push_back(prompt);
+                }
+            }
+            i = 0;
+            for (const auto& resource : description["resources"]) {
+                if (addRoute(index->resources, resource["uri"].get_ref<const std::string&>(), entry, i++)) {
+                    resources.push_back(resource);
+                }
+            }
+        }
+
+        index->toolsList = nlohmann::ordered_json({{"tools", std::move(tools)}}).dump();
+        index->promptsList = nlohmann::ordered_json({{"prompts", std::move(prompts)}}).dump();
+        index->resourcesList = nlohmann::ordered_json({{"resources", std::move(resources)}}).dump();
+
+        m_index.store(std::move(index), std::memory_order_release);
+    }
+
 }
\ No newline at end of file
@@ -32,7 +32,12 @@ typedef HMODULE LibraryHandle;
 #include <dlfcn.h>
     typedef void* LibraryHandle;
 #endif
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <memory>
 #include <iostream>
@@ -40,18 +45,100 @@ typedef HMODULE LibraryHandle;
 #include <algorithm>
 
 #include "aixlog.hpp"
+#include "json.hpp"
 #include "PluginAPI.h"
+#include "PluginHost.h"
+
+// Max plugins loaded and initialized at once by LoadPlugins()
+#define DEFAULT_PLUGIN_LOAD_THREADS 4
+
+// Format of the manifest written next to every plugin library, a manifest of another format is rebuilt
+#define PLUGIN_MANIFEST_VERSION 1
+#define PLUGIN_MANIFEST_SUFFIX ".manifest.json"
+
+// In process calls of a plugin that may still be running after they were cancelled or timed out,
+// each one holding a request worker; past it the plugin is refused new calls until some return
+#define PLUGIN_MAX_ABANDONED_CALLS 2
+
+class Histogram;
 
 namespace vx::mcp {
 
+    struct PluginCacheRecord;
+
+    // A plugin library. With lazy activation it is first listed from its manifest only: instance
+    // stays nullptr and the library is loaded into a new entry on the first call routed to it.
+    // An isolated plugin is loaded by a child process: host is set and instance stays nullptr.
     struct PluginEntry {
-        std::string path;
-        LibraryHandle handle;
-        PluginAPI* instance;
+        std::string path;           // the library in the plugins directory
+        std::string loadedPath;     // the private copy loaded instead with hot reload, if it still exists
+        std::string hash;           // of the library file, keys its manifest; empty if it could not be read
+        LibraryHandle handle = nullptr;
+        PluginAPI* instance = nullptr;
+        const PluginExtensions* extensions = nullptr;   // nullptr for ABI v1 plugins
+        std::unique_ptr<NotificationSystem> notifications;
+        std::unique_ptr<PluginHost> host;
+
+        // Name, version, type and the tools, prompts and resources of the plugin, as listed to the
+        // clients; read from the plugin once it is initialized or from its manifest
+        nlohmann::ordered_json description;
+
+        // Serializes the first calls to a plugin listed from its manifest, one of them loads it
+        std::mutex activation;
+        bool activated = false;
+
+        // In process calls cancelled or timed out that the plugin has not returned from yet
+        std::atomic<uint32_t> abandoned{0};
 
         // Function pointers
-        PluginAPI* (*createFunc)();
-        void (*destroyFunc)(PluginAPI*);
+        PluginAPI* (*createFunc)() = nullptr;
+        void (*destroyFunc)(PluginAPI*) = nullptr;
+    };
+
+    // Where a tool, prompt or resource lives: the owning plugin and its index in it.
+    // instance is nullptr until a plugin listed from its manifest is loaded, see PluginsLoader::Resolve,
+    // and for an isolated plugin, which is called through host.
+    struct PluginRoute {
+        PluginAPI* instance;
+        const PluginExtensions* extensions;
+        int index;
+        PluginEntry* plugin;
+        PluginHost* host;
+        Histogram* pluginTime;     // Metrics PLUGIN and SERIALIZE of the name, looked up once per rebuild
+        Histogram* serializeTime;
+    };
+
+    // Allows map lookups with a string_view key, without building a std::string
+    struct RouteKeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+    };
+
+    using RouteMap = std::unordered_map<std::string, PluginRoute, RouteKeyHash, std::equal_to<>>;
+
+    // Immutable lookup tables built from the loaded plugins.
+    // A new index is published as a whole every time the plugin set changes. The index owns a
+    // reference to the plugins it routes to: a call holding it finishes on the plugin it looked
+    // up even if that one was replaced meanwhile.
+    struct PluginsIndex {
+        std::vector<std::shared_ptr<const PluginEntry>> plugins;
+
+        RouteMap tools;      // by tool name
+        RouteMap prompts;    // by prompt name
+        RouteMap resources;  // by resource uri
+
+        // Pre-serialized "result" objects of tools/list, prompts/list and resources/list
+        std::string toolsList;
+        std::string promptsList;
+        std::string resourcesList;
+
+        static const PluginRoute* Find(const RouteMap& map, std::string_view key) {
+            auto it = map.find(key);
+            return it != map.end() ? &it->second : nullptr;
+        }
+        const PluginRoute* FindTool(std::string_view name) const { return Find(tools, name); }
+        const PluginRoute* FindPrompt(std::string_view name) const { return Find(prompts, name); }
+        const PluginRoute* FindResource(std::string_view uri) const { return Find(resources, uri); }
     };
 
     class PluginsLoader {
@@ -59,21 +146,85 @@ namespace vx::mcp {
         PluginsLoader();
         ~PluginsLoader();
 
-        // Load plugins from a directory
-        bool LoadPlugins(const std::string& directory);
+        // Load plugins from a directory, up to threads of them at once. The plugins are kept in
+        // the order of their paths whatever order they finish loading in.
+        bool LoadPlugins(const std::string& directory, size_t threads = DEFAULT_PLUGIN_LOAD_THREADS);
 
         // Unload all plugins
         void UnloadPlugins();
 
-        // Get loaded plugins
-        const std::vector<PluginEntry>& GetPlugins() const;
+        // Get loaded plugins, only while the plugin set cannot change (no hot reload running)
+        const std::vector<std::shared_ptr<PluginEntry>>& GetPlugins() const;
+
+        // Notification system handed to every plugin loaded from now on
+        void SetNotificationCallback(ClientNotificationCallback callback);
+
+        // List the plugins that have an up to date manifest without loading them, each one is loaded
+        // and initialized on the first call routed to it. Call before LoadPlugins.
+        void EnableLazyActivation();
+
+        // Run every plugin loaded from now on in a child process of its own, restarted when it crashes.
+        // Ignored where PluginHost is not supported. Call before LoadPlugins.
+        void EnableIsolation();
+
+        // Load every library from a private copy next to it, so that a plugin can be rebuilt in
+        // place and loaded again while the previous version still serves calls. Call before LoadPlugins.
+        void EnableHotReload();
+
+        // Load the plugin of a library again, load it if it is new or unload it if the file is gone.
+        // The new version is routed to at once; the previous one is retired until no call uses it
+        // anymore. A library that fails to load leaves the running version in place.
+        // Returns false when the plugin set did not change.
+        bool ReloadPlugin(const std::string& path);
+
+        // Shutdown and unload the retired plugins no call uses anymore, returns how many are left.
+        // Called by the loader after an activation and polled by PluginWatcher after a reload
+        size_t ReleaseRetired();
+
+        // Shared libraries the loader looks at, whatever their directory
+        static bool IsPluginLibrary(const std::filesystem::path& path);
+
+        // Get the current routing index, safe to call from any thread without locking
+        std::shared_ptr<const PluginsIndex> GetIndex() const;
+
+        // Look up key in a route map of the current index, e.g. &PluginsIndex::tools, and load the
+        // plugin owning it if it was only listed from its manifest. index receives the index the
+        // route lives in and keeps it valid. nullptr for an unknown key or a plugin that failed to load.
+        const PluginRoute* Resolve(std::shared_ptr<const PluginsIndex>& index, RouteMap PluginsIndex::*map, std::string_view key);
+
+        // List a resource served by the host itself next to the plugin ones; it has no route,
+        // the host answers resources/read for its uri
+        void AddHostResource(const std::string& uri, const std::string& name, const std::string& description, const std::string& mime);
+
+        // Load and initialize a library, the plugin is introspected unless its description is given.
+        // The entry is not routed to; the plugin host child uses it to load its plugin.
+        std::shared_ptr<PluginEntry> LoadPlugin(const std::string& path, const nlohmann::ordered_json* description = nullptr);
+        static void UnloadPlugin(PluginEntry& entry);
 
     private:
-        bool LoadPlugin(const std::string& path);
-        void UnloadPlugin(PluginEntry& entry);
+        // Entry of a library: listed from its cache record or its manifest if allowLazy and one of
+        // them is up to date, loaded otherwise, and the manifest written again if it was not
+        std::shared_ptr<PluginEntry> OpenPlugin(const std::string& path, bool allowLazy, PluginCacheRecord* cached = nullptr);
+        // Load a plugin listed from its manifest and route to it, returns the resulting index
+        std::shared_ptr<const PluginsIndex> Activate(PluginEntry* listed);
+        std::string CopyForLoading(const std::string& path);
+        static const PluginExtensions* ResolveExtensions(const PluginEntry& entry, void* symbol);
+        // callers hold m_mutex
+        void RebuildIndex();
 
     private:
-        std::vector<PluginEntry> m_plugins;
+        std::mutex m_mutex;  // serializes changes of the plugin set, lookups only use m_index
+        std::vector<std::shared_ptr<PluginEntry>> m_plugins;
+        std::vector<std::shared_ptr<PluginEntry>> m_retired;  // replaced, unloaded once unreferenced
+        ClientNotificationCallback m_notificationCallback = nullptr;
+        bool m_hotReload = false;
+        bool m_lazy = false;
+        bool m_isolated = false;
+        std::string m_cacheFile;  // metadata cache of the plugins directory, set by LoadPlugins
+        std::atomic<uint64_t> m_loadCount{0};  // names the private copies, plugins load concurrently
+        std::vector<nlohmann::ordered_json> m_hostResources;
+        std::unordered_set<std::string> m_conflicts;  // shadowed routes already reported, as plugin/key
+        std::atomic<std::shared_ptr<const PluginsIndex>> m_index{std::make_shared<const PluginsIndex>()};
     };
 
 }
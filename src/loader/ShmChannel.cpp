@@ -0,0 +1,266 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "ShmChannel.h"
+
+#ifdef __linux__
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace vx::mcp {
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                  "futex words must be plain 32-bit integers");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring positions are shared between processes");
+
+    static const uint32_t kChannelMagic = 0x43504d56; // "VMPC"
+
+    struct ChannelLayout {
+        uint32_t magic;
+        uint32_t capacity;
+        std::atomic<uint32_t> closed;
+        ShmRingState requests;
+        ShmRingState responses;
+    };
+
+    // the rings start on their own page
+    static constexpr size_t kDataOffset = (sizeof(ChannelLayout) + 4095) & ~size_t(4095);
+
+    // size, kind, status, id, then the two strings with their sizes
+    static constexpr size_t kFrameHeader = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(int32_t) + sizeof(uint64_t);
+
+    // Shared, not FUTEX_PRIVATE: the peer sleeping on the word lives in another process
+    static void FutexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs) {
+        struct timespec timeout;
+        struct timespec* limit = nullptr;
+        if (timeoutMs >= 0) {
+            timeout.tv_sec = timeoutMs / 1000;
+            timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000;
+            limit = &timeout;
+        }
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, limit, nullptr, 0);
+    }
+
+    static void FutexWake(std::atomic<uint32_t>* word, int count) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+    }
+
+    void ShmRing::Put(uint64_t position, const void* data, size_t size) {
+        size_t offset = static_cast<size_t>(position & (capacity_ - 1));
+        size_t first = std::min(size, capacity_ - offset);
+        memcpy(data_ + offset, data, first);
+        memcpy(data_, static_cast<const uint8_t*>(data) + first, size - first);
+    }
+
+    void ShmRing::Get(uint64_t position, void* data, size_t size) const {
+        size_t offset = static_cast<size_t>(position & (capacity_ - 1));
+        size_t first = std::min(size, capacity_ - offset);
+        memcpy(data, data_ + offset, first);
+        memcpy(static_cast<uint8_t*>(data) + first, data_, size - first);
+    }
+
+    bool ShmRing::Write(const ChannelMessage& message, int timeoutMs) {
+        using Clock = std::chrono::steady_clock;
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+        uint64_t size = kFrameHeader + sizeof(uint32_t) + message.first.size() + sizeof(uint32_t) + message.second.size();
+        if (size > capacity_) return false;
+
+        // only this side moves the tail
+        uint64_t tail = state_->tail.load(std::memory_order_relaxed);
+        while (capacity_ - (tail - state_->head.load(std::memory_order_acquire)) < size) {
+            if (closed_->load()) return false;
+            int wait = 100;
+            if (timeoutMs >= 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                if (left <= 0) return false;
+                wait = static_cast<int>(std::min<long long>(left, wait));
+            }
+            state_->spaceWaiters.fetch_add(1);
+            uint32_t seq = state_->spaceSeq.load();
+            if (capacity_ - (tail - state_->head.load()) < size && !closed_->load()) {
+                FutexWait(&state_->spaceSeq, seq, wait);
+            }
+            state_->spaceWaiters.fetch_sub(1);
+        }
+        if (closed_->load()) return false;
+
+        uint32_t frameSize = static_cast<uint32_t>(size);
+        uint32_t kind = static_cast<uint32_t>(message.kind);
+        uint32_t firstSize = static_cast<uint32_t>(message.first.size());
+        uint32_t secondSize = static_cast<uint32_t>(message.second.size());
+        uint64_t position = tail;
+        Put(position, &frameSize, sizeof(frameSize)); position += sizeof(frameSize);
+        Put(position, &kind, sizeof(kind)); position += sizeof(kind);
+        Put(position, &message.status, sizeof(message.status)); position += sizeof(message.status);
+        Put(position, &message.id, sizeof(message.id)); position += sizeof(message.id);
+        Put(position, &firstSize, sizeof(firstSize)); position += sizeof(firstSize);
+        Put(position, message.first.data(), firstSize); position += firstSize;
+        Put(position, &secondSize, sizeof(secondSize)); position += sizeof(secondSize);
+        Put(position, message.second.data(), secondSize);
+
+        // publish, then wake the consumer only if it is asleep
+        state_->tail.store(tail + size, std::memory_order_release);
+        state_->dataSeq.fetch_add(1);
+        if (state_->dataWaiters.load() > 0) FutexWake(&state_->dataSeq, 1);
+        return true;
+    }
+
+    int ShmRing::Read(ChannelMessage& message, int timeoutMs) {
+        using Clock = std::chrono::steady_clock;
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+
+        // only this side moves the head
+        uint64_t head = state_->head.load(std::memory_order_relaxed);
+        while (state_->tail.load(std::memory_order_acquire) == head) {
+            if (closed_->load()) return -1;
+            int wait = -1;
+            if (timeoutMs >= 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                if (left <= 0) return 0;
+                wait = static_cast<int>(left);
+            }
+            state_->dataWaiters.fetch_add(1);
+            uint32_t seq = state_->dataSeq.load();
+            if (state_->tail.load() == head && !closed_->load()) {
+                FutexWait(&state_->dataSeq, seq, wait);
+            }
+            state_->dataWaiters.fetch_sub(1);
+        }
+
+        // the peer is another process, a frame that does not add up closes the channel
+        uint64_t available = state_->tail.load(std::memory_order_acquire) - head;
+        uint32_t frameSize, kind, firstSize, secondSize;
+        uint64_t position = head;
+        Get(position, &frameSize, sizeof(frameSize)); position += sizeof(frameSize);
+        if (frameSize < kFrameHeader + 2 * sizeof(uint32_t) || frameSize > available) {
+            closed_->store(1);
+            return -1;
+        }
+        Get(position, &kind, sizeof(kind)); position += sizeof(kind);
+        Get(position, &message.status, sizeof(message.status)); position += sizeof(message.status);
+        Get(position, &message.id, sizeof(message.id)); position += sizeof(message.id);
+        Get(position, &firstSize, sizeof(firstSize)); position += sizeof(firstSize);
+        if (firstSize > frameSize - kFrameHeader - 2 * sizeof(uint32_t)) {
+            closed_->store(1);
+            return -1;
+        }
+        message.kind = static_cast<ChannelKind>(kind);
+        message.first.resize(firstSize);
+        Get(position, message.first.data(), firstSize); position += firstSize;
+        Get(position, &secondSize, sizeof(secondSize)); position += sizeof(secondSize);
+        if (secondSize != frameSize - kFrameHeader - 2 * sizeof(uint32_t) - firstSize) {
+            closed_->store(1);
+            return -1;
+        }
+        message.second.resize(secondSize);
+        Get(position, message.second.data(), secondSize);
+
+        state_->head.store(head + frameSize, std::memory_order_release);
+        state_->spaceSeq.fetch_add(1);
+        if (state_->spaceWaiters.load() > 0) FutexWake(&state_->spaceSeq, 1);
+        return 1;
+    }
+
+    void ShmRing::WakeAll() {
+        state_->dataSeq.fetch_add(1);
+        state_->spaceSeq.fetch_add(1);
+        FutexWake(&state_->dataSeq, INT_MAX);
+        FutexWake(&state_->spaceSeq, INT_MAX);
+    }
+
+    ShmChannel::~ShmChannel() {
+        if (mapping_) munmap(mapping_, size_);
+        if (fd_ >= 0) close(fd_);
+    }
+
+    std::unique_ptr<ShmChannel> ShmChannel::Create(uint32_t capacity) {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) return nullptr;
+        // close on exec, the spawner clears the flag for the one child that gets it
+        int fd = static_cast<int>(syscall(SYS_memfd_create, "mcp-plugin-channel", MFD_CLOEXEC));
+        if (fd < 0) return nullptr;
+        std::unique_ptr<ShmChannel> channel(new ShmChannel());
+        channel->fd_ = fd;
+        if (ftruncate(fd, static_cast<off_t>(kDataOffset + 2 * size_t(capacity))) != 0 || !channel->Map(fd, true, capacity)) {
+            return nullptr;
+        }
+        return channel;
+    }
+
+    std::unique_ptr<ShmChannel> ShmChannel::Attach(int fd) {
+        std::unique_ptr<ShmChannel> channel(new ShmChannel());
+        channel->fd_ = fd;
+        if (!channel->Map(fd, false, 0)) return nullptr;
+        return channel;
+    }
+
+    bool ShmChannel::Map(int fd, bool create, uint32_t capacity) {
+        struct stat info;
+        if (fstat(fd, &info) != 0) return false;
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ < kDataOffset) return false;
+        mapping_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            return false;
+        }
+
+        ChannelLayout* layout;
+        if (create) {
+            // the memfd starts zeroed, the atomics only need their constructors to run once
+            layout = new (mapping_) ChannelLayout();
+            layout->magic = kChannelMagic;
+            layout->capacity = capacity;
+        } else {
+            layout = static_cast<ChannelLayout*>(mapping_);
+            capacity = layout->capacity;
+            if (layout->magic != kChannelMagic || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+                size_ != kDataOffset + 2 * size_t(capacity)) {
+                return false;
+            }
+        }
+
+        uint8_t* data = static_cast<uint8_t*>(mapping_) + kDataOffset;
+        closed_ = &layout->closed;
+        requests_ = std::make_unique<ShmRing>(&layout->requests, data, capacity, closed_);
+        responses_ = std::make_unique<ShmRing>(&layout->responses, data + capacity, capacity, closed_);
+        return true;
+    }
+
+    void ShmChannel::Close() {
+        closed_->store(1);
+        requests_->WakeAll();
+        responses_->WakeAll();
+    }
+
+}
+#endif
@@ -0,0 +1,142 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef MCP_SERVER_SHM_CHANNEL_H
+#define MCP_SERVER_SHM_CHANNEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Bytes of each direction of a plugin host channel, a message must fit in one
+#define PLUGIN_HOST_RING_SIZE (4u << 20)
+
+namespace vx::mcp {
+
+    enum class ChannelKind : uint8_t {
+        Hello = 1,      // child -> host: the plugin is initialized (status 0) or failed to load
+        CallV2,         // host -> child: first is the name routed on, second the raw params
+        CallV1,         // host -> child: first is the whole request
+        Result,         // child -> host: status is the PluginResult, first the result
+        Notify,         // child -> host: first is the plugin name, second the notification
+        Shutdown,       // host -> child: unload the plugin and exit
+        Cancel          // host -> child: the call with this id was cancelled
+    };
+
+    struct ChannelMessage {
+        ChannelKind kind = ChannelKind::Result;
+        int32_t status = 0;
+        uint64_t id = 0;        // pairs a Result with its call
+        std::string first;
+        std::string second;
+    };
+
+#ifdef __linux__
+    // State of one direction, in the shared mapping. Positions only grow, the byte at
+    // position p is at p % capacity of the data area.
+    struct ShmRingState {
+        alignas(64) std::atomic<uint64_t> head{0};         // consumed up to, written by the consumer
+        alignas(64) std::atomic<uint64_t> tail{0};         // published up to, written by the producer
+        alignas(64) std::atomic<uint32_t> dataSeq{0};      // futex word, bumped after every publish
+        std::atomic<uint32_t> dataWaiters{0};
+        alignas(64) std::atomic<uint32_t> spaceSeq{0};     // futex word, bumped after every consume
+        std::atomic<uint32_t> spaceWaiters{0};
+    };
+
+    // One direction of a channel: a single producer and a single consumer, in two processes.
+    // A side only enters the kernel to sleep when the ring is empty (or full) and to wake a
+    // sleeping peer; a message is copied once into the mapping and once out of it.
+    class ShmRing {
+    public:
+        ShmRing(ShmRingState* state, uint8_t* data, uint32_t capacity, std::atomic<uint32_t>* closed)
+            : state_(state), data_(data), capacity_(capacity), closed_(closed) {}
+
+        // Append a message, waiting up to timeoutMs (negative: no limit) for room. false when
+        // the channel is closed, on timeout or if the message can never fit.
+        bool Write(const ChannelMessage& message, int timeoutMs = -1);
+
+        // Take the next message. 1 when one was read, 0 on timeout (negative: no limit),
+        // -1 when the channel is closed or its content is invalid.
+        int Read(ChannelMessage& message, int timeoutMs);
+
+        // Wake both sides, e.g. once the channel is closed
+        void WakeAll();
+
+        // Position up to which the consumer has taken messages, and up to which the producer
+        // has published them; a message written at tail is taken once Consumed() passes it
+        uint64_t Consumed() const { return state_->head.load(std::memory_order_acquire); }
+        uint64_t Published() const { return state_->tail.load(std::memory_order_acquire); }
+
+    private:
+        void Put(uint64_t position, const void* data, size_t size);
+        void Get(uint64_t position, void* data, size_t size) const;
+
+    private:
+        ShmRingState* state_;
+        uint8_t* data_;
+        uint32_t capacity_;
+        std::atomic<uint32_t>* closed_;
+    };
+
+    // Shared memory channel between the server and a plugin host child: requests flow in
+    // one ring, results and notifications in the other. The memfd is created by the server
+    // and inherited by the child across exec.
+    class ShmChannel {
+    public:
+        ~ShmChannel();
+
+        ShmChannel(const ShmChannel&) = delete;
+        ShmChannel& operator=(const ShmChannel&) = delete;
+
+        // Create a channel, capacity is the size of each ring and a power of two
+        static std::unique_ptr<ShmChannel> Create(uint32_t capacity);
+        // Map the channel created by the parent process, from the inherited descriptor
+        static std::unique_ptr<ShmChannel> Attach(int fd);
+
+        int Fd() const { return fd_; }
+        ShmRing& Requests() { return *requests_; }
+        ShmRing& Responses() { return *responses_; }
+
+        // Fail every pending and future Read/Write on both sides
+        void Close();
+
+    private:
+        ShmChannel() = default;
+        bool Map(int fd, bool create, uint32_t capacity);
+
+    private:
+        int fd_ = -1;
+        void* mapping_ = nullptr;
+        size_t size_ = 0;
+        std::atomic<uint32_t>* closed_ = nullptr;
+        std::unique_ptr<ShmRing> requests_;
+        std::unique_ptr<ShmRing> responses_;
+    };
+#endif
+
+}
+
+#endif //MCP_SERVER_SHM_CHANNEL_H
@@ -22,13 +22,22 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
 #include "version.h"
-#include "httplib.h"
 #include "popl.hpp"
 #include "StdioTransport.h"
+#include "HttpTransport.h"
+#include "UnixSocketTransport.h"
 #include "server/Server.h"
 #include "aixlog.hpp"
 #include "loader/PluginsLoader.h"
+#include "loader/PluginCall.h"
+#include "loader/PluginWatcher.h"
+#include "loader/PluginHost.h"
+#include "server/Metrics.h"
 #include "json.hpp"
 #include "utils/MCPBuilder.h"
 
@@ -61,12 +70,28 @@ void ClientNotificationCallbackImpl(const char* pluginName, const char* notifica
 
 /// main entry point
 int main(int argc, char **argv) {
+    // the server binary started again to host one isolated plugin
+    if (argc > 1 && strcmp(argv[1], PLUGIN_HOST_ARGUMENT) == 0) {
+        return vx::mcp::RunPluginHost(argc, argv);
+    }
+
     std::string name;
     std::string plugins_directory;
     std::string logs_directory;
     bool verbose;
+    size_t workers;
+    size_t queue_depth;
+    size_t write_batch;
+    size_t flush_latency;
+    std::string transport_name;
+    std::string host;
+    int port;
+    size_t http_threads;
+    std::string socket_path;
+    size_t load_threads;
+    size_t call_timeout;
+    std::vector<std::pair<std::string, size_t>> tool_timeouts;
 
-    auto transport = std::make_shared<vx::transport::Stdio>();
     auto loader = std::make_shared<vx::mcp::PluginsLoader>();
     server = std::make_shared<vx::mcp::Server>();
 
@@ -84,10 +109,37 @@ int main(int argc, char **argv) {
     auto plugins_directory_option = op.add<Value<std::string>>("p", "plugins", "the directory where to load the plugins", "./plugins");
     auto logs_directory_option = op.add<Value<std::string>>("l", "logs", "the directory where to store the logs", "./logs");
     auto verbose_option = op.add<Value<bool>>("v", "verbose", "enable verbose", verbose);
+    auto workers_option = op.add<Value<size_t>>("w", "workers", "the number of threads serving requests concurrently", DEFAULT_WORKER_COUNT);
+    auto queue_depth_option = op.add<Value<size_t>>("q", "queue-depth", "the max number of requests waiting for a worker", DEFAULT_QUEUE_DEPTH);
+    auto write_batch_option = op.add<Value<size_t>>("b", "write-batch", "the max number of messages written to the client at once", DEFAULT_WRITE_BATCH);
+    auto async_option = op.add<Switch>("a", "async", "serve the transport from an event loop instead of a blocking reader");
+    auto flush_latency_option = op.add<Value<size_t>>("", "flush-latency", "the max microseconds a partial batch waits for more messages", DEFAULT_FLUSH_LATENCY_US);
+    auto transport_option = op.add<Value<std::string>>("t", "transport", "the transport serving the clients: stdio, http or unix", "stdio");
+    auto host_option = op.add<Value<std::string>>("", "host", "the address the http transport listens on", DEFAULT_HTTP_HOST);
+    auto port_option = op.add<Value<int>>("", "port", "the port the http transport listens on, 0 picks a free one", DEFAULT_HTTP_PORT);
+    auto http_threads_option = op.add<Value<size_t>>("", "http-threads", "the max number of http connections served at once, at most half of them SSE streams", DEFAULT_HTTP_THREADS);
+    auto socket_option = op.add<Value<std::string>>("", "socket", "the path the unix transport listens on", DEFAULT_UNIX_SOCKET_PATH);
+    auto load_threads_option = op.add<Value<size_t>>("", "load-threads", "the max number of plugins loaded and initialized at once", DEFAULT_PLUGIN_LOAD_THREADS);
+    auto eager_option = op.add<Switch>("", "eager", "load and initialize every plugin at startup, instead of listing it from its manifest until its first call");
+    auto isolate_option = op.add<Switch>("", "isolate", "run every plugin in a child process of its own, restarted when it crashes (Linux)");
+    auto watch_option = op.add<Switch>("", "watch", "reload a plugin when its library changes in the plugins directory");
+    auto call_timeout_option = op.add<Value<size_t>>("", "call-timeout", "the max milliseconds a request may take before it is answered with an error, 0 for no limit", DEFAULT_CALL_TIMEOUT_MS);
+    auto tool_timeout_option = op.add<Value<std::string>>("", "tool-timeout", "the max milliseconds of the calls of one tool as name=ms, overrides --call-timeout (repeatable)");
     name_option->assign_to(&name);
     plugins_directory_option->assign_to(&plugins_directory);
     logs_directory_option->assign_to(&logs_directory);
     verbose_option->assign_to(&verbose);
+    workers_option->assign_to(&workers);
+    queue_depth_option->assign_to(&queue_depth);
+    write_batch_option->assign_to(&write_batch);
+    flush_latency_option->assign_to(&flush_latency);
+    transport_option->assign_to(&transport_name);
+    host_option->assign_to(&host);
+    port_option->assign_to(&port);
+    http_threads_option->assign_to(&http_threads);
+    socket_option->assign_to(&socket_path);
+    load_threads_option->assign_to(&load_threads);
+    call_timeout_option->assign_to(&call_timeout);
 
     //============================================================================================
     // parse options
@@ -98,6 +150,15 @@ int main(int argc, char **argv) {
             std::cout << op << std::endl;
             return 0;
         }
+        for (size_t i = 0; i < tool_timeout_option->count(); i++) {
+            const std::string& value = tool_timeout_option->value(i);
+            size_t separator = value.rfind('=');
+            if (separator == std::string::npos || separator == 0) {
+                throw popl::invalid_option(tool_timeout_option.get(), popl::invalid_option::Error::invalid_argument,
+                                           popl::OptionName::long_name, value, "expected name=ms");
+            }
+            tool_timeouts.emplace_back(value.substr(0, separator), std::stoul(value.substr(separator + 1)));
+        }
     } catch (const popl::invalid_option& e) {
         std::cerr << "Invalid Option Exception: " << e.what() << std::endl;
         return -1;
@@ -106,6 +167,22 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    //============================================================================================
+    // setup transport
+    //============================================================================================
+    std::shared_ptr<vx::ITransport> transport;
+    std::shared_ptr<vx::IListener> listener;
+    if (transport_name == "stdio") {
+        transport = std::make_shared<vx::transport::Stdio>();
+    } else if (transport_name == "http") {
+        listener = std::make_shared<vx::transport::Http>(host, port, http_threads);
+    } else if (transport_name == "unix") {
+        listener = std::make_shared<vx::transport::UnixSocket>(socket_path);
+    } else {
+        std::cerr << "Unknown transport: " << transport_name << std::endl;
+        return -1;
+    }
+
     //============================================================================================
     // setup logger
     //============================================================================================
@@ -130,22 +207,49 @@ int main(int argc, char **argv) {
     LOG(INFO) << "| |\\/| | |    |  ___/______\\___ \\|  __| |  _  / \\ \\/ / |  __| |  _  / " << std::endl;
     LOG(INFO) << "| |  | | |____| |          ____) | |____| | \\ \\  \\  /  | |____| | \\ \\ " << std::endl;
     LOG(INFO) << "|_|  |_|\\_____|_|         |_____/|______|_|  \\_\\  \\/   |______|_|  \\_\\" << std::endl;
-    LOG(INFO) << "Starting mcp-server v" << PROJECT_VERSION << " (transport: " << transport->GetName() << " v" << transport->GetVersion() << ") on port: " << transport->GetPort() << std::endl;
+    if (listener) {
+        LOG(INFO) << "Starting mcp-server v" << PROJECT_VERSION << " (transport: " << listener->GetName() << " v" << listener->GetVersion() << ") on port: " << listener->GetPort() << std::endl;
+    } else {
+        LOG(INFO) << "Starting mcp-server v" << PROJECT_VERSION << " (transport: " << transport->GetName() << " v" << transport->GetVersion() << ") on port: " << transport->GetPort() << std::endl;
+    }
     LOG(INFO) << "Press Ctrl+C to exit." << std::endl;
 
     //============================================================================================
     // load all plugins from the plugins directory
     //============================================================================================
-    if (loader->LoadPlugins(plugins_directory)) {
+    // every plugin gets the notification system, including the ones loaded again later
+    loader->SetNotificationCallback(ClientNotificationCallbackImpl);
+    if (!eager_option->is_set()) {
+        loader->EnableLazyActivation();
+    }
+    if (isolate_option->is_set()) {
+        loader->EnableIsolation();
+    }
+    if (watch_option->is_set()) {
+        loader->EnableHotReload();
+    }
+    loader->AddHostResource(METRICS_RESOURCE_URI, "metrics", "Latency histograms of the server (parse, queue wait, dispatch, plugin, serialize, flush) in microseconds", "application/json");
+    if (loader->LoadPlugins(plugins_directory, load_threads)) {
         LOG(INFO) << "Successfully loaded plugins" << std::endl;
     }
 
     //============================================================================================
-    // enable notification system
+    // hot reload: tell the clients which lists changed after a plugin was swapped
     //============================================================================================
-    for (auto& plugin : loader->GetPlugins()) {
-        plugin.instance->notifications = new NotificationSystem();
-        plugin.instance->notifications->SendToClient = ClientNotificationCallbackImpl;
+    std::unique_ptr<vx::mcp::PluginWatcher> watcher;
+    if (watch_option->is_set()) {
+        watcher = std::make_unique<vx::mcp::PluginWatcher>(loader, plugins_directory, [](const vx::mcp::PluginsIndex& before, const vx::mcp::PluginsIndex& after) {
+            if (before.toolsList != after.toolsList) {
+                ClientNotificationCallbackImpl("plugins", MCPBuilder::NotificationListChanged("tools").dump().c_str());
+            }
+            if (before.promptsList != after.promptsList) {
+                ClientNotificationCallbackImpl("plugins", MCPBuilder::NotificationListChanged("prompts").dump().c_str());
+            }
+            if (before.resourcesList != after.resourcesList) {
+                ClientNotificationCallbackImpl("plugins", MCPBuilder::NotificationListChanged("resources").dump().c_str());
+            }
+        });
+        watcher->Start();
     }
 
     //============================================================================================
@@ -153,156 +257,64 @@ int main(int argc, char **argv) {
     //============================================================================================
     server->Name(name);
     server->VerboseLevel(verbose ? 1 : 0);
-    server->OverrideCallback("tools/list", [&loader](const json& request) {
-        nlohmann::ordered_json response = MCPBuilder::Response(request);
-        response["result"]["tools"] = json::array();
-
-        for (const auto& plugin : loader->GetPlugins()) {
-            if (plugin.instance->GetType() == PLUGIN_TYPE_TOOLS) {
-                for (int i = 0; i < plugin.instance->GetToolCount(); i++) {
-                    nlohmann::ordered_json tool;
-                    auto pluginTool = plugin.instance->GetTool(i);
-                    tool["name"] = pluginTool->name;
-                    tool["description"] = pluginTool->description;
-                    tool["inputSchema"] = nlohmann::json::parse(pluginTool->inputSchema);
-                    response["result"]["tools"].push_back(tool);
-                }
-            }
-        }
-
-        return response;
+    server->WorkerCount(workers);
+    server->QueueDepth(queue_depth);
+    server->WriteBatchSize(write_batch);
+    server->FlushLatency(std::chrono::microseconds(flush_latency));
+    server->CallTimeout(std::chrono::milliseconds(call_timeout));
+    for (const auto& [tool, timeout] : tool_timeouts) {
+        server->ToolTimeout(tool, std::chrono::milliseconds(timeout));
+    }
+    server->OverrideRawCallback("tools/list", [&loader](const json& request) {
+        return MCPBuilder::RawResponse(request["id"], loader->GetIndex()->toolsList);
     });
-    server->OverrideCallback("tools/call", [&loader](const json& request) {
-        nlohmann::ordered_json response = MCPBuilder::Response(request);
-
-        char* res_ptr = nullptr;
-
-        for (const auto& plugin : loader->GetPlugins()) {
-            if (plugin.instance->GetType() == PLUGIN_TYPE_TOOLS) {
-                for (int i = 0; i < plugin.instance->GetToolCount(); i++) {
-                    auto pluginTool = plugin.instance->GetTool(i);
-                    if (pluginTool->name == request["params"]["name"]) {
-                        res_ptr = plugin.instance->HandleRequest(request.dump().c_str());
-                        if (res_ptr) {
-                            try {
-                                response["result"] = json::parse(res_ptr);
-                                response["result"]["isError"] = false;
-                            } catch (const json::parse_error& e) {
-                                response["result"]["isError"] = true;
-                                response["result"]["content"] = json::array();
-                                response["result"]["content"].push_back({{"type", "text"}, {"text", "Plugin returned malformed data."}});
-                            }
-                            // --- Free the allocated memory ---
-                            delete[] res_ptr;
-                        } else {
-                            LOG(ERROR) << "Plugin " << pluginTool->name << " returned nullptr." << std::endl;
-                        }
-                        return response;
-                    }
-                }
-            }
+    server->OverrideEnvelopeCallback("tools/call", [&loader](const vx::mcp::Envelope& request) {
+        std::shared_ptr<const vx::mcp::PluginsIndex> index;
+        auto route = loader->Resolve(index, &vx::mcp::PluginsIndex::tools, request.name);
+        if (!route) {
+            return MCPBuilder::Error(MCPBuilder::InvalidParams, request.id, "Unknown tool: " + request.name).dump();
         }
-
-        return response;
+        return vx::mcp::CallPlugin(*route, request, request.name, true);
     });
-    server->OverrideCallback("prompts/list", [&loader](const json& request) {
-        nlohmann::ordered_json response = MCPBuilder::Response(request);
-        response["result"]["prompts"] = json::array();
-
-        for (const auto& plugin : loader->GetPlugins()) {
-            if (plugin.instance->GetType() == PLUGIN_TYPE_PROMPTS) {
-                for (int i = 0; i < plugin.instance->GetPromptCount(); i++) {
-                    nlohmann::ordered_json prompt;
-                    auto pluginPrompt = plugin.instance->GetPrompt(i);
-                    prompt["name"] = pluginPrompt->name;
-                    prompt["description"] = pluginPrompt->description;
-                    prompt["arguments"] = nlohmann::json::parse(pluginPrompt->arguments);
-                    response["result"]["prompts"].push_back(prompt);
-                }
-            }
-        }
-
-        return response;
+    server->OverrideRawCallback("prompts/list", [&loader](const json& request) {
+        return MCPBuilder::RawResponse(request["id"], loader->GetIndex()->promptsList);
     });
-    server->OverrideCallback("prompts/get", [&loader](const json& request) {
-        nlohmann::ordered_json response = MCPBuilder::Response(request);
-
-        char* res_ptr = nullptr;
-
-        for (const auto& plugin : loader->GetPlugins()) {
-            if (plugin.instance->GetType() == PLUGIN_TYPE_PROMPTS) {
-                for (int i = 0; i < plugin.instance->GetPromptCount(); i++) {
-                    auto pluginPrompt = plugin.instance->GetPrompt(i);
-                    if (pluginPrompt->name == request["params"]["name"]) {
-                        res_ptr = plugin.instance->HandleRequest(request.dump().c_str());
-                        if (res_ptr) {
-                            try {
-                                response["result"] = json::parse(res_ptr);
-                            } catch (const json::parse_error& e) {
-                                LOG(ERROR) << "Plugin " << pluginPrompt->name << " returned malformed data." << std::endl;
-                                // TODO: how can we handle error here ?
-                            }
-                            // --- Free the allocated memory ---
-                            delete[] res_ptr;
-                        }
-                    }
-                    return response;
-                }
-            }
+    server->OverrideEnvelopeCallback("prompts/get", [&loader](const vx::mcp::Envelope& request) {
+        std::shared_ptr<const vx::mcp::PluginsIndex> index;
+        auto route = loader->Resolve(index, &vx::mcp::PluginsIndex::prompts, request.name);
+        if (!route) {
+            return MCPBuilder::Error(MCPBuilder::InvalidParams, request.id, "Unknown prompt: " + request.name).dump();
         }
-
-        return response;
+        return vx::mcp::CallPlugin(*route, request, request.name, false);
     });
-    server->OverrideCallback("resources/list", [&loader](const json& request) {
-        nlohmann::ordered_json response = MCPBuilder::Response(request);
-        response["result"]["resources"] = json::array();
-
-        for (const auto& plugin : loader->GetPlugins()) {
-            if (plugin.instance->GetType() == PLUGIN_TYPE_RESOURCES) {
-                for (int i = 0; i < plugin.instance->GetResourceCount(); i++) {
-                    nlohmann::ordered_json resource;
-                    auto pluginResource = plugin.instance->GetResource(i);
-                    resource["name"] = pluginResource->name;
-                    resource["description"] = pluginResource->description;
-                    resource["uri"] = pluginResource->uri;
-                    resource["mimeType"] = pluginResource->mime;
-                    response["result"]["resources"].push_back(resource);
-                }
-            }
-        }
-
-        return response;
+    server->OverrideRawCallback("resources/list", [&loader](const json& request) {
+        return MCPBuilder::RawResponse(request["id"], loader->GetIndex()->resourcesList);
     });
-    server->OverrideCallback("resources/read", [&loader](const json& request) {
-        nlohmann::ordered_json response = MCPBuilder::Response(request);
-
-        char* res_ptr = nullptr;
-
-        for (const auto& plugin : loader->GetPlugins()) {
-            if (plugin.instance->GetType() == PLUGIN_TYPE_RESOURCES) {
-                for (int i = 0; i < plugin.instance->GetResourceCount(); i++) {
-                    auto pluginResource = plugin.instance->GetResource(i);
-                    if (pluginResource->uri == request["params"]["uri"]) {
-                        res_ptr = plugin.instance->HandleRequest(request.dump().c_str());
-                        if (res_ptr) {
-                            try {
-                                response["result"] = json::parse(res_ptr);
-                            } catch (const json::parse_error& e) {
-                                LOG(ERROR) << "Plugin " << pluginResource->name << " returned malformed data." << std::endl;
-                                // TODO: how can we handle error here ?
-                            }
-                            // --- Free the allocated memory ---
-                            delete[] res_ptr;
-                        }
-                    }
-                }
-            }
+    server->OverrideEnvelopeCallback("resources/read", [&loader](const vx::mcp::Envelope& request) {
+        const auto& uri = request.uri;
+        if (uri == METRICS_RESOURCE_URI) {
+            json contents = json::array();
+            contents.push_back(MCPBuilder::ResourceText(uri, "application/json", vx::mcp::Metrics::GetInstance().ToJson()));
+            json result = {{"contents", std::move(contents)}};
+            return MCPBuilder::RawResponse(request.id, result.dump());
         }
-
-        return response;
+        std::shared_ptr<const vx::mcp::PluginsIndex> index;
+        auto route = loader->Resolve(index, &vx::mcp::PluginsIndex::resources, uri);
+        if (!route) {
+            return MCPBuilder::Error(MCPBuilder::InvalidParams, request.id, "Unknown resource: " + uri).dump();
+        }
+        return vx::mcp::CallPlugin(*route, request, uri, false);
     });
 
-    server->Connect(transport);
+    if (listener) {
+        if (!server->Serve(listener)) return -1;
+    } else if (async_option->is_set()) {
+        server->ConnectAsync(transport);
+        server->Wait();
+        server->StopAsync();
+    } else {
+        server->Connect(transport);
+    }
 
     return 0;
 }
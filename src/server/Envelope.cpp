@@ -0,0 +1,222 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <iterator>
+#include "Envelope.h"
+
+using json = nlohmann::json;
+
+namespace vx::mcp {
+
+    namespace {
+
+        // Iterator over the message text that publishes how far the lexer has read. The parser
+        // reports a token right after reading its last character, so at start_object/end_object
+        // the cursor is just past the bracket: that is how the raw params span is found.
+        struct CountingIterator {
+            using iterator_category = std::input_iterator_tag;
+            using value_type = char;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const char*;
+            using reference = const char&;
+
+            const char* position;
+            const char** cursor;
+
+            reference operator*() const { return *position; }
+            CountingIterator& operator++() {
+                *cursor = ++position;
+                return *this;
+            }
+            CountingIterator operator++(int) {
+                CountingIterator previous = *this;
+                ++*this;
+                return previous;
+            }
+            bool operator==(const CountingIterator& other) const { return position == other.position; }
+            bool operator!=(const CountingIterator& other) const { return position != other.position; }
+        };
+
+        class EnvelopeReader {
+        public:
+            enum Field { NONE, JSONRPC, ID, METHOD, PARAMS, NAME, URI };
+
+            EnvelopeReader(Envelope& envelope, const char* const& cursor,
+                           const std::function<bool(std::string_view)>& filter)
+                : envelope_(envelope), cursor_(cursor), filter_(filter) {}
+
+            bool null() { return Scalar(nullptr); }
+            bool boolean(bool value) { return Scalar(value); }
+            bool number_integer(json::number_integer_t value) { return Scalar(value); }
+            bool number_unsigned(json::number_unsigned_t value) { return Scalar(value); }
+            bool number_float(json::number_float_t value, const json::string_t&) { return Scalar(value); }
+            bool binary(json::binary_t&) { return Scalar(nullptr); }
+
+            bool string(json::string_t& value) {
+                if (depth_ == 1) {
+                    if (field_ == JSONRPC) envelope_.jsonrpc = value;
+                    if (field_ == METHOD) {
+                        envelope_.method = value;
+                        if (filter_ && !filter_(envelope_.method)) return Stop();
+                    }
+                } else if (depth_ == 2 && inParams_) {
+                    if (field_ == NAME) envelope_.name = value;
+                    if (field_ == URI) envelope_.uri = value;
+                }
+                return Scalar(value);
+            }
+
+            bool start_object(std::size_t) { return Open(); }
+            bool start_array(std::size_t) {
+                if (depth_ == 0) {
+                    envelope_.batch = true;
+                    return Stop();
+                }
+                return Open();
+            }
+            bool end_object() { return Close(); }
+            bool end_array() { return Close(); }
+
+            bool key(json::string_t& key) {
+                field_ = NONE;
+                if (depth_ == 1) {
+                    if (key == "jsonrpc") field_ = JSONRPC;
+                    else if (key == "id") field_ = ID;
+                    else if (key == "method") field_ = METHOD;
+                    else if (key == "params") field_ = PARAMS;
+                } else if (depth_ == 2 && inParams_) {
+                    if (key == "name") field_ = NAME;
+                    else if (key == "uri") field_ = URI;
+                }
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+                envelope_.error = e.what();
+                return false;
+            }
+
+            inline bool Stopped() const { return stopped_; }
+
+        private:
+            // only the id is kept, the other values are not even copied
+            template<typename T>
+            bool Scalar(T&& value) {
+                if (depth_ == 1 && field_ == ID) {
+                    envelope_.id = json(std::forward<T>(value));
+                    envelope_.hasId = true;
+                }
+                field_ = NONE;
+                return true;
+            }
+
+            bool Open() {
+                if (depth_ == 0) {
+                    envelope_.object = true;
+                } else if (depth_ == 1 && field_ == PARAMS) {
+                    paramsBegin_ = cursor_ - 1;
+                    inParams_ = true;
+                } else if (depth_ == 1 && field_ == ID) {
+                    // not a valid id, but the DOM path would keep it: let it answer
+                    envelope_.hasId = true;
+                }
+                field_ = NONE;
+                depth_++;
+                return true;
+            }
+
+            bool Close() {
+                depth_--;
+                if (depth_ == 1 && inParams_) {
+                    envelope_.params = std::string_view(paramsBegin_, static_cast<size_t>(cursor_ - paramsBegin_));
+                    inParams_ = false;
+                }
+                field_ = NONE;
+                return true;
+            }
+
+            bool Stop() {
+                stopped_ = true;
+                return false;
+            }
+
+        private:
+            Envelope& envelope_;
+            const char* const& cursor_;
+            const std::function<bool(std::string_view)>& filter_;
+            int depth_ = 0;
+            Field field_ = NONE;
+            bool inParams_ = false;
+            bool stopped_ = false;
+            const char* paramsBegin_ = nullptr;
+        };
+
+    }
+
+    Envelope::Envelope(const json& request) {
+        request_ = request;
+        if (request.is_array()) {
+            batch = true;
+            return;
+        }
+        if (!request.is_object()) return;
+        object = true;
+
+        auto it = request.find("id");
+        if (it != request.end()) {
+            id = *it;
+            hasId = true;
+        }
+        it = request.find("jsonrpc");
+        if (it != request.end() && it->is_string()) jsonrpc = it->get<std::string>();
+        it = request.find("method");
+        if (it != request.end() && it->is_string()) method = it->get<std::string>();
+        it = request.find("params");
+        if (it != request.end()) {
+            if (it->is_object()) {
+                auto field = it->find("name");
+                if (field != it->end() && field->is_string()) name = field->get<std::string>();
+                field = it->find("uri");
+                if (field != it->end() && field->is_string()) uri = field->get<std::string>();
+            }
+            paramsText_ = it->dump();
+            params = paramsText_;
+        }
+    }
+
+    Envelope::Result Envelope::Parse(const std::function<bool(std::string_view method)>& filter) {
+        const char* cursor = text_.data();
+        EnvelopeReader reader(*this, cursor, filter);
+        CountingIterator first{text_.data(), &cursor};
+        CountingIterator last{text_.data() + text_.size(), &cursor};
+        if (json::sax_parse(first, last, &reader)) return Result::COMPLETE;
+        return reader.Stopped() ? Result::STOPPED : Result::SYNTAX_ERROR;
+    }
+
+    const json& Envelope::Request() const {
+        if (!request_) request_ = json::parse(text_);
+        return *request_;
+    }
+
+}
@@ -0,0 +1,89 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_ENVELOPE_H
+#define MCP_SERVER_ENVELOPE_H
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "json.hpp"
+#include "../utils/CancelToken.h"
+
+namespace vx::mcp {
+
+    // The routing fields of a JSON-RPC message, read without building the DOM.
+    //
+    // Parse() runs the message through the nlohmann SAX parser: the scalars of the envelope
+    // (jsonrpc, id, method, params.name, params.uri) are kept and everything else is only
+    // validated. "params" is kept as the raw span of the message text, plugins get those bytes
+    // as they came from the client instead of a parse and dump round trip.
+    //
+    // The views point into the envelope itself, it can be neither copied nor moved.
+    class Envelope {
+    public:
+        enum class Result {
+            COMPLETE,     // the whole message was read
+            STOPPED,      // a batch, or a method rejected by the filter: parse the DOM instead
+            SYNTAX_ERROR  // not valid JSON, see error
+        };
+
+        explicit Envelope(std::string text) : text_(std::move(text)) {}
+        // The envelope of a message already parsed, e.g. an element of a batch
+        explicit Envelope(const nlohmann::json& request);
+
+        Envelope(const Envelope&) = delete;
+        Envelope& operator=(const Envelope&) = delete;
+
+        // The filter gets the method as soon as it is read, returning false stops the scan
+        Result Parse(const std::function<bool(std::string_view method)>& filter = nullptr);
+
+        // The whole message as a DOM, parsed on first use (ABI v1 plugins want the request)
+        const nlohmann::json& Request() const;
+
+        inline std::string_view Text() const { return text_; }
+
+    public:
+        bool object = false;  // a single message, not a batch or a bare value
+        bool batch = false;
+        bool hasId = false;   // notifications have no id
+        nlohmann::json id;
+        std::string jsonrpc;
+        std::string method;
+        std::string name;     // params.name of tools/call and prompts/get
+        std::string uri;      // params.uri of resources/read
+        std::string_view params; // raw JSON text of params, empty when absent
+        std::string error;
+        const CancelToken* cancel = nullptr; // set by the server while the request runs
+
+    private:
+        std::string text_;
+        std::string paramsText_; // backs params for the envelope of a DOM
+        mutable std::optional<nlohmann::json> request_;
+    };
+
+}
+
+#endif //MCP_SERVER_ENVELOPE_H
@@ -0,0 +1,134 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "Metrics.h"
+
+#include <cstdio>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vx::mcp {
+
+    static const char* STAGE_NAMES[Metrics::STAGE_COUNT] = {
+            "parse", "queue_wait", "dispatch", "plugin", "serialize", "flush"
+    };
+
+    static const std::initializer_list<double> QUANTILES = {0.5, 0.9, 0.99, 0.999};
+    static const char* QUANTILE_NAMES[] = {"p50", "p90", "p99", "p999"};
+    static const char* QUANTILE_LABELS[] = {"0.5", "0.9", "0.99", "0.999"};
+
+    Histogram& Metrics::Get(Stage stage, std::string_view name) {
+        HistogramMap& map = histograms_[stage];
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = map.find(name);
+            if (it != map.end()) return *it->second;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto [it, inserted] = map.try_emplace(std::string(name));
+        if (inserted) it->second = std::make_unique<Histogram>();
+        return *it->second;
+    }
+
+    std::string_view Metrics::MethodOf(const nlohmann::json& message) {
+        if (message.is_array()) return "batch";
+        if (message.is_object()) {
+            auto method = message.find("method");
+            if (method != message.end() && method->is_string()) {
+                return method->get_ref<const std::string&>();
+            }
+            // a response to a server request
+            if (message.contains("id")) return "response";
+        }
+        return "invalid";
+    }
+
+    std::string Metrics::ToJson() const {
+        auto micros = [](uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1000.0; };
+
+        nlohmann::ordered_json stages = nlohmann::ordered_json::object();
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (int stage = 0; stage < STAGE_COUNT; stage++) {
+            nlohmann::ordered_json names = nlohmann::ordered_json::object();
+            for (const auto& [name, histogram] : histograms_[stage]) {
+                Histogram::Snapshot snapshot = histogram->Read(QUANTILES);
+                if (snapshot.count == 0) continue;
+                nlohmann::ordered_json entry;
+                entry["count"] = snapshot.count;
+                entry["mean"] = micros(snapshot.sum / snapshot.count);
+                for (size_t i = 0; i < snapshot.quantiles.size(); i++) {
+                    entry[QUANTILE_NAMES[i]] = micros(snapshot.quantiles[i]);
+                }
+                entry["max"] = micros(snapshot.max);
+                names[name] = std::move(entry);
+            }
+            stages[STAGE_NAMES[stage]] = std::move(names);
+        }
+        return nlohmann::ordered_json({{"unit", "us"}, {"stages", std::move(stages)}}).dump();
+    }
+
+    // label values are quoted strings, backslash, quote and new line are escaped
+    static std::string EscapeLabel(std::string_view value) {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value) {
+            if (c == '\\' || c == '"') escaped += '\\';
+            if (c == '\n') {
+                escaped += "\\n";
+                continue;
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::string Metrics::ToPrometheus() const {
+        auto seconds = [](uint64_t nanoseconds) {
+            char text[32];
+            snprintf(text, sizeof(text), "%.9f", static_cast<double>(nanoseconds) / 1e9);
+            return std::string(text);
+        };
+
+        std::string text;
+        text += "# HELP mcp_request_stage_seconds Latency of the request path stages.\n";
+        text += "# TYPE mcp_request_stage_seconds summary\n";
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (int stage = 0; stage < STAGE_COUNT; stage++) {
+            for (const auto& [name, histogram] : histograms_[stage]) {
+                Histogram::Snapshot snapshot = histogram->Read(QUANTILES);
+                if (snapshot.count == 0) continue;
+                std::string labels = std::string("stage=\"") + STAGE_NAMES[stage] + "\",name=\"" + EscapeLabel(name) + "\"";
+                for (size_t i = 0; i < snapshot.quantiles.size(); i++) {
+                    text += "mcp_request_stage_seconds{" + labels + ",quantile=\"" + QUANTILE_LABELS[i] + "\"} "
+                            + seconds(snapshot.quantiles[i]) + "\n";
+                }
+                text += "mcp_request_stage_seconds_sum{" + labels + "} " + seconds(snapshot.sum) + "\n";
+                text += "mcp_request_stage_seconds_count{" + labels + "} " + std::to_string(snapshot.count) + "\n";
+            }
+        }
+        return text;
+    }
+
+}
@@ -0,0 +1,95 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_METRICS_H
+#define MCP_SERVER_METRICS_H
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "json.hpp"
+#include "../utils/Histogram.h"
+#include "../utils/TSingleton.h"
+
+#define METRICS_RESOURCE_URI "metrics://server"
+
+namespace vx::mcp {
+
+    // Latency histograms of the request path, in nanoseconds, one per stage and name.
+    // Exposed as the metrics://server resource and, over HTTP, as Prometheus text on /metrics.
+    class Metrics : public TSingleton<Metrics> {
+        friend class TSingleton<Metrics>;
+
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum Stage {
+            PARSE,      // request text to json, by method
+            QUEUE_WAIT, // waiting for a worker, by method
+            DISPATCH,   // handling on the worker, response included, by method
+            PLUGIN,     // inside the plugin HandleRequest, by tool, prompt or resource
+            SERIALIZE,  // host side marshalling around the plugin call, by tool, prompt or resource
+            FLUSH,      // writing a batch of messages to the client, by transport
+            STAGE_COUNT
+        };
+
+        // The histogram of a stage and name, created on first use and never freed: call it when
+        // a method, route or transport is set up, with names the server knows, and keep the
+        // reference. Recording into it takes no lock.
+        Histogram& Get(Stage stage, std::string_view name);
+
+        static inline uint64_t Elapsed(Clock::time_point start) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+
+        // The method of a message, or a placeholder for batches and invalid messages
+        static std::string_view MethodOf(const nlohmann::json& message);
+
+        // {"unit":"us","stages":{"dispatch":{"tools/call":{"count":1,"mean":..,"p50":..,...}}}}
+        std::string ToJson() const;
+
+        // Prometheus text exposition format, one summary family over all the stages
+        std::string ToPrometheus() const;
+
+    private:
+        Metrics() = default;
+
+        struct NameHash {
+            using is_transparent = void;
+            size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+        };
+        using HistogramMap = std::unordered_map<std::string, std::unique_ptr<Histogram>, NameHash, std::equal_to<>>;
+
+        // histograms are only ever added, lookups take the shared side
+        mutable std::shared_mutex mutex_;
+        std::array<HistogramMap, STAGE_COUNT> histograms_;
+    };
+
+}
+
+#endif //MCP_SERVER_METRICS_H
@@ -22,9 +22,11 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include "Server.h"
+#include "Metrics.h"
 #include "aixlog.hpp"
 #include "version.h"
 #include "../utils/MCPBuilder.h"
@@ -56,6 +58,14 @@ namespace vx::mcp {
                 {"notifications/tools/list_changed", [this](const json& req) { return this->NotificationToolsListChangedCmd(req); }},
                 {"notifications/message", [this](const json& req) { return this->NotificationMessageCmd(req); }}
         };
+
+        Metrics& metrics = Metrics::GetInstance();
+        auto addMetrics = [this, &metrics](const std::string& method) {
+            methodMetrics_[method] = MethodMetrics{&metrics.Get(Metrics::PARSE, method), &metrics.Get(Metrics::QUEUE_WAIT, method),
+                                                   &metrics.Get(Metrics::DISPATCH, method), &metrics.Get(Metrics::SERIALIZE, method)};
+        };
+        for (const auto& [method, function] : functionMap) addMetrics(method);
+        for (const char* placeholder : {"batch", "response", "invalid", "unknown"}) addMetrics(placeholder);
     }
 
     Server::~Server() {
@@ -64,42 +74,42 @@ namespace vx::mcp {
 
     void Server::WriterLoop() {
         LOG(INFO) << "Writer thread started." << std::endl;
-        while (writer_running_.load()) {
-            std::string notification_to_send;
+        std::vector<std::string> batch;
+        batch.reserve(writeBatchSize_);
+        Histogram& flushTime = Metrics::GetInstance().Get(Metrics::FLUSH, transport_->GetName());
+        while (true) {
             {
                 std::unique_lock<std::mutex> lock(output_mutex_);
                 // Wait until queue is not empty OR the writer should stop
-                queue_cv_.wait(lock, [this] { return !notification_queue_.empty() || !writer_running_.load(); });
+                queue_cv_.wait(lock, [this] { return !output_queue_.empty() || !writer_running_.load(); });
 
-                // Check running flag again after waking up
-                if (!writer_running_.load() && notification_queue_.empty()) {
-                    break; // Exit loop if stopped and queue is empty
-                }
+                // Exit loop if stopped and queue is empty
+                if (output_queue_.empty()) break;
 
-                if (!notification_queue_.empty()) {
-                    notification_to_send = std::move(notification_queue_.front());
-                    notification_queue_.pop();
+                // let a partial batch fill up, for at most the flush latency
+                if (flushLatency_.count() > 0 && output_queue_.size() < writeBatchSize_ && writer_running_.load()) {
+                    queue_cv_.wait_for(lock, flushLatency_, [this] {
+                        return output_queue_.size() >= writeBatchSize_ || !writer_running_.load();
+                    });
                 }
-            } // Release lock before potentially blocking write
-
-            if (!notification_to_send.empty() && transport_) {
-                try {
-                    // Note: Write itself is not locked here, assuming transport handles internal sync
-                    // If transport->Write is not thread-safe, the lock needs to span this call too.
-                    // For stdio, writing from one thread should be okay, but locking provides safety.
-                    // Re-locking here for safety with potential other writes (responses).
-                    std::lock_guard<std::mutex> write_lock(output_mutex_);
-                    if (transport_) { // Check transport again after potential delay
-                        LOG(DEBUG) << "Sending Notification: " << notification_to_send << std::endl;
-                        transport_->Write(notification_to_send);
-                    }
-                } catch (const std::exception& e) {
-                    LOG(ERROR) << "Error writing notification: " << e.what() << std::endl;
-                    // Decide how to handle write errors (e.g., log, ignore, stop?)
+
+                // take everything pending, up to the batch size
+                size_t count = std::min(output_queue_.size(), writeBatchSize_);
+                for (size_t i = 0; i < count; i++) {
+                    batch.push_back(std::move(output_queue_.front()));
+                    output_queue_.pop_front();
                 }
+            } // Release lock before the blocking write, producers keep queueing meanwhile
+
+            // only this thread writes to the transport
+            try {
+                auto start = Metrics::Clock::now();
+                transport_->WriteBatch(batch);
+                flushTime.Record(Metrics::Elapsed(start));
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Error writing " << batch.size() << " messages: " << e.what() << std::endl;
             }
-            // Small sleep to prevent tight loop if errors occur rapidly
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            batch.clear();
         }
         LOG(INFO) << "Writer thread stopped." << std::endl;
     }
@@ -113,35 +123,31 @@ namespace vx::mcp {
         transport_ = transport; // Store the transport pointer
         isStopping_ = false; // Reset stopping flag
 
-        // Start the writer thread
+        // Start the writer thread and the request workers
         writer_running_ = true;
         writer_thread_ = std::thread(&Server::WriterLoop, this);
+        StartWorkers();
 
+        IListener::Reply writeReply = [this](std::string response) {
+            if (!response.empty()) WriteResponse(std::move(response));
+        };
+        std::string_view json_string;
         while (!isStopping_) {
-            auto [length, json_string] = transport->Read();
+            bool connected = transport->ReadView(json_string);
             if (isStopping_) break;
 
-            if (length == 0 && json_string.empty()) {
+            if (!connected) {
                 LOG(INFO) << "Read returned empty data, potentially client disconnected." << std::endl;
-                isStopping_ = true;
-                break;
+                break; // Stop() below drains the workers and joins the writer
             }
 
-            try {
-                if (json_string.empty()) continue;
-                LOG(DEBUG) << "Received: " << json_string << std::endl;
-                json request = json::parse(json_string);
+            if (json_string.empty()) continue;
+            LOG(DEBUG) << "Received: " << json_string << std::endl;
+            if (Receive(std::string(json_string), writeReply)) {
                 parserErrors_ = 0; // reset parser error
-                json response = HandleRequest(request);
-                if (response != nullptr) {
-                    std::lock_guard<std::mutex> lock(output_mutex_);
-                    LOG(DEBUG) << "Sending Response: " << response.dump() << std::endl;
-                    transport_->Write(response.dump());
-                }
-            } catch (json::parse_error &e) {
+            } else {
                 // ok... what should we do in this case ? exit process ? does nothing ?
                 // for now, we manage a max parser consecutive errors
-                LOG(ERROR) << "Error parsing JSON: " << e.what() << std::endl;
                 if (++parserErrors_ > MAX_PARSER_ERRORS) return false;
             }
         }
@@ -159,62 +165,137 @@ namespace vx::mcp {
 
         transport_ = transport;
         isStopping_ = false;
+        StartWorkers();
 
-        // Start the writer thread
-        writer_running_ = true;
-        writer_thread_ = std::thread(&Server::WriterLoop, this);
+        // One thread runs the event loop; the reader and the writer are coroutines on it
+        loop_ = std::make_unique<vx::transport::EventLoop>();
+        output_event_ = std::make_unique<vx::transport::AsyncEvent>(*loop_);
+        transport_->Attach(loop_.get());
 
-        // Start the async reader thread
+        writer_running_ = true;
         reader_running_ = true;
         reader_thread_ = std::thread([this]() {
-            LOG(INFO) << "Async Reader thread started." << std::endl;
-            while (reader_running_ && !isStopping_) {
-                try {
-                    auto future = transport_->ReadAsync();
-                    auto [length, json_string] = future.get();
-
-                    if (isStopping_ || (length == 0 && json_string.empty())) {
-                        LOG(INFO) << "Empty message or stopping. Reader exiting.";
-                        break;
-                    }
+            LOG(INFO) << "Event loop started." << std::endl;
+            Task<void> reader = ReadLoopAsync();
+            Task<void> writer = WriteLoopAsync();
+            reader.Start();
+            writer.Start();
+            loop_->Run();
+            LOG(INFO) << "Event loop stopped." << std::endl;
+        });
 
-                    if (!json_string.empty()) {
-                        LOG(DEBUG) << "Received: " << json_string << std::endl;
-                        json request = json::parse(json_string);
-                        parserErrors_ = 0;
-
-                        json response = HandleRequest(request);
-                        if (response != nullptr) {
-                            std::lock_guard<std::mutex> lock(output_mutex_);
-                            LOG(DEBUG) << "Sending Response: " << response.dump() << std::endl;
-                            transport_->Write(response.dump());
-                        }
-                    }
-                } catch (json::parse_error &e) {
-                    LOG(ERROR) << "Error parsing JSON: " << e.what() << std::endl;
-                    if (++parserErrors_ > MAX_PARSER_ERRORS) {
-                        isStopping_ = true;
-                        break;
-                    }
-                } catch (const std::exception &e) {
-                    LOG(ERROR) << "Reader thread exception: " << e.what() << std::endl;
-                    isStopping_ = true;
+        return true;
+    }
+
+    bool Server::Serve(const std::shared_ptr<IListener>& listener) {
+        if (!listener) {
+            LOG(ERROR) << "Serve called with null listener." << std::endl;
+            return false;
+        }
+
+        listener_ = listener;
+        isStopping_ = false;
+        StartWorkers();
+
+        // the listener threads only parse and wait, the requests run on the worker pool;
+        // responses go straight back to the session, there is no shared writer in this mode
+        bool result = listener_->Listen([this](const std::string& session, std::string message, IListener::Reply reply) {
+            if (!Receive(std::move(message), reply, session)) {
+                reply(MCPBuilder::Error(MCPBuilder::ParseError, json(), "Parse error").dump());
+            }
+        });
+
+        Stop();
+        return result;
+    }
+
+    void Server::Wait() {
+        // an atomic wait rather than a condition variable: the Ctrl+C handler exits the process
+        // from this thread, and destroying a condition variable that still has a waiter blocks
+        while (reader_running_.load()) {
+            reader_running_.wait(true);
+        }
+    }
+
+    Task<void> Server::ReadLoopAsync() {
+        IListener::Reply writeReply = [this](std::string response) {
+            if (!response.empty()) WriteResponse(std::move(response));
+        };
+        std::string_view json_string;
+        while (reader_running_ && !isStopping_) {
+            try {
+                if (!co_await transport_->ReadViewAsync(json_string)) {
+                    LOG(INFO) << "Read returned empty data, potentially client disconnected." << std::endl;
                     break;
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                if (json_string.empty()) continue;
+
+                LOG(DEBUG) << "Received: " << json_string << std::endl;
+                if (Receive(std::string(json_string), writeReply)) {
+                    parserErrors_ = 0;
+                } else if (++parserErrors_ > MAX_PARSER_ERRORS) {
+                    break;
+                }
+            } catch (const std::exception &e) {
+                LOG(ERROR) << "Reader exception: " << e.what() << std::endl;
+                break;
             }
-            LOG(INFO) << "Async Reader thread exiting." << std::endl;
-        });
+        }
 
-        return true;
+        reader_running_ = false;
+        reader_running_.notify_all();
+    }
+
+    Task<void> Server::WriteLoopAsync() {
+        std::vector<std::string> batch;
+        batch.reserve(writeBatchSize_);
+        Histogram& flushTime = Metrics::GetInstance().Get(Metrics::FLUSH, transport_->GetName());
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(output_mutex_);
+                size_t count = std::min(output_queue_.size(), writeBatchSize_);
+                for (size_t i = 0; i < count; i++) {
+                    batch.push_back(std::move(output_queue_.front()));
+                    output_queue_.pop_front();
+                }
+                if (batch.empty() && !writer_running_.load()) break;
+            }
+
+            if (batch.empty()) {
+                co_await output_event_->Wait();
+                continue;
+            }
+
+            try {
+                auto start = Metrics::Clock::now();
+                co_await transport_->WriteBatchAsync(batch);
+                flushTime.Record(Metrics::Elapsed(start));
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Error writing " << batch.size() << " messages: " << e.what() << std::endl;
+            }
+            batch.clear();
+        }
+
+        // everything is written, the loop has nothing left to do
+        loop_->Stop();
     }
 
     void Server::Stop() {
+        if (loop_) {
+            StopAsync();
+            return;
+        }
         if (isStopping_) return; // Avoid redundant stopping
 
         isStopping_ = true;
         LOG(INFO) << "Stopping server..." << std::endl;
 
+        // No new clients, the sessions waiting for a response still get it
+        if (listener_) listener_->Stop();
+
+        // Let the in-flight requests complete so their responses are written
+        StopWorkers();
+
         // Signal and join writer thread
         writer_running_ = false;
         queue_cv_.notify_one(); // Wake up the writer thread if waiting
@@ -231,12 +312,385 @@ namespace vx::mcp {
             return;
         }
 
+        LOG(DEBUG) << "Sending Notification: " << notification << std::endl;
+        if (listener_) {
+            listener_->Broadcast(notification);
+            return;
+        }
+
         // Add notification to the queue (protected by the mutex)
         {
             std::lock_guard<std::mutex> lock(output_mutex_);
-            notification_queue_.emplace(notification);
+            output_queue_.emplace_back(notification);
+        }
+        NotifyWriter();
+    }
+
+    void Server::NotifyWriter() {
+        queue_cv_.notify_one();
+        if (output_event_) output_event_->Notify();
+    }
+
+    void Server::StartWorkers() {
+        pool_ = std::make_unique<ThreadPool>(workerCount_, queueDepth_);
+        LOG(INFO) << "Request workers started: " << workerCount_ << " (queue depth " << queueDepth_ << ")" << std::endl;
+        StartDeadlines();
+    }
+
+    void Server::StopWorkers() {
+        if (pool_) {
+            pool_->Shutdown();
+            pool_.reset();
+            LOG(INFO) << "Request workers stopped." << std::endl;
+        }
+        StopDeadlines();
+    }
+
+    void Server::StartDeadlines() {
+        // nothing to watch without a timeout
+        if (callTimeout_.count() <= 0 && toolTimeouts_.empty()) return;
+        deadline_running_ = true;
+        deadline_thread_ = std::thread(&Server::DeadlineLoop, this);
+    }
+
+    void Server::StopDeadlines() {
+        {
+            std::lock_guard<std::mutex> lock(deadline_mutex_);
+            deadline_running_ = false;
+            for (auto& [at, entry] : deadlines_) {
+                if (auto request = entry.lock()) request->armed = false;
+            }
+            deadlines_.clear();
+        }
+        deadline_cv_.notify_one();
+        if (deadline_thread_.joinable()) deadline_thread_.join();
+    }
+
+    void Server::DeadlineLoop() {
+        std::unique_lock<std::mutex> lock(deadline_mutex_);
+        while (deadline_running_) {
+            if (deadlines_.empty()) {
+                deadline_cv_.wait(lock);
+                continue;
+            }
+            auto first = deadlines_.begin();
+            if (std::chrono::steady_clock::now() < first->first) {
+                deadline_cv_.wait_until(lock, first->first);
+                continue;
+            }
+
+            std::shared_ptr<InFlight> request = first->second.lock();
+            deadlines_.erase(first);
+            if (!request) continue;
+            request->armed = false;
+
+            // cancelling runs the handler of whoever waits on the token, not under our lock
+            lock.unlock();
+            if (request->cancel.Cancel(CancelToken::Reason::TimedOut)) {
+                LOG(WARNING) << "Request " << request->key << " timed out, answering it." << std::endl;
+                Answer(*request, MCPBuilder::Error(MCPBuilder::RequestTimeout, request->id, "Request timed out").dump());
+            }
+            lock.lock();
+        }
+    }
+
+    std::chrono::milliseconds Server::TimeoutOf(std::string_view method, std::string_view tool) const {
+        if (!toolTimeouts_.empty() && method == "tools/call") {
+            auto it = toolTimeouts_.find(tool);
+            if (it != toolTimeouts_.end()) return it->second;
+        }
+        return callTimeout_;
+    }
+
+    bool Server::Receive(std::string message, const IListener::Reply& reply, const std::string& scope) {
+        auto start = Metrics::Clock::now();
+
+        // methods with an envelope callback are routed without building the DOM,
+        // for the others the scan stops at the method and the message is parsed as usual
+        auto envelope = std::make_shared<Envelope>(std::move(message));
+        Envelope::Result result = envelope->Parse([this](std::string_view method) {
+            return envelopeFunctionMap.find(method) != envelopeFunctionMap.end();
+        });
+        if (result == Envelope::Result::SYNTAX_ERROR) {
+            LOG(ERROR) << "Error parsing JSON: " << envelope->error << std::endl;
+            return false;
+        }
+
+        auto it = envelopeFunctionMap.find(envelope->method);
+        if (result == Envelope::Result::COMPLETE && it != envelopeFunctionMap.end()) {
+            const MethodMetrics& metrics = MetricsOf(envelope->method);
+            metrics.parse->Record(Metrics::Elapsed(start));
+            Submit(envelope->hasId, envelope->id, metrics, TimeoutOf(envelope->method, envelope->name),
+                   [this, envelope, &function = it->second](const CancelToken& cancel) {
+                envelope->cancel = &cancel;
+                if (verboseLevel_ == 1) {
+                    LOG(DEBUG) << "=== Request START ===" << std::endl;
+                    LOG(DEBUG) << envelope->Text() << std::endl;
+                    LOG(DEBUG) << "=== Request END ===" << std::endl;
+                }
+                return function(*envelope);
+            }, reply, scope);
+            return true;
+        }
+
+        json request;
+        try {
+            request = json::parse(envelope->Text());
+        } catch (json::parse_error& e) {
+            LOG(ERROR) << "Error parsing JSON: " << e.what() << std::endl;
+            return false;
+        }
+        MetricsOf(Metrics::MethodOf(request)).parse->Record(Metrics::Elapsed(start));
+        Dispatch(std::move(request), reply, scope);
+        return true;
+    }
+
+    void Server::Dispatch(json request, IListener::Reply reply, const std::string& scope) {
+        if (request.is_array()) {
+            DispatchBatch(std::move(request), std::move(reply), scope);
+            return;
+        }
+
+        // notifications carry no id and never produce a response
+        bool hasId = request.is_object() && request.contains("id");
+        json id = hasId ? request["id"] : json();
+        std::string method(Metrics::MethodOf(request));
+
+        // handled here rather than on a worker: the workers may all be busy with the requests it cancels
+        if (!hasId && method == "notifications/cancelled") {
+            Cancel(request, scope);
+            reply(std::string());
+            return;
+        }
+
+        std::chrono::milliseconds timeout = callTimeout_;
+        if (hasId && !toolTimeouts_.empty() && method == "tools/call") {
+            auto params = request.find("params");
+            if (params != request.end() && params->is_object()) {
+                auto name = params->find("name");
+                if (name != params->end() && name->is_string()) {
+                    timeout = TimeoutOf(method, name->get_ref<const std::string&>());
+                }
+            }
+        }
+
+        Submit(hasId, std::move(id), MetricsOf(method), timeout, [this, request = std::move(request)](const CancelToken& cancel) {
+            return HandleRequestRaw(request, &cancel);
+        }, std::move(reply), scope);
+    }
+
+    const Server::MethodMetrics& Server::MetricsOf(std::string_view method) const {
+        auto it = methodMetrics_.find(method);
+        return it != methodMetrics_.end() ? it->second : methodMetrics_.find("unknown")->second;
+    }
+
+    void Server::Submit(bool hasId, json id, const MethodMetrics& metrics, std::chrono::milliseconds timeout,
+                        std::function<std::string(const CancelToken&)> handle, IListener::Reply reply, const std::string& scope) {
+        auto request = std::make_shared<InFlight>();
+        request->id = std::move(id);
+        request->reply = std::move(reply);
+        if (hasId) {
+            request->key = scope + '/' + request->id.dump();
+            bool duplicate;
+            {
+                std::lock_guard<std::mutex> lock(inflight_mutex_);
+                duplicate = !inflight_.try_emplace(request->key, request).second;
+            }
+            if (duplicate) {
+                LOG(WARNING) << "Request id " << request->key << " is already in flight." << std::endl;
+                request->reply(MCPBuilder::Error(MCPBuilder::InvalidRequest, request->id, "Duplicate request id").dump());
+                return;
+            }
+
+            // the deadline runs from the receipt, the time spent in the queue counts
+            if (timeout.count() > 0) {
+                std::lock_guard<std::mutex> lock(deadline_mutex_);
+                if (deadline_running_) {
+                    auto at = std::chrono::steady_clock::now() + timeout;
+                    bool first = deadlines_.empty() || at < deadlines_.begin()->first;
+                    request->deadline = deadlines_.emplace(at, request);
+                    request->armed = true;
+                    if (first) deadline_cv_.notify_one();
+                }
+            }
+        }
+
+        auto queued = Metrics::Clock::now();
+        auto task = [this, &metrics, handle = std::move(handle), request, queued]() {
+            auto start = Metrics::Clock::now();
+            metrics.queueWait->Record(Metrics::Elapsed(queued));
+
+            // cancelled or timed out while queued, it was answered already
+            if (request->cancel.IsCancelled()) return;
+
+            std::string response;
+            try {
+                response = handle(request->cancel);
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Error handling request: " << e.what() << std::endl;
+                if (!request->key.empty()) {
+                    response = MCPBuilder::Error(MCPBuilder::InternalError, request->id, e.what()).dump();
+                }
+            }
+
+            metrics.dispatch->Record(Metrics::Elapsed(start));
+            // whoever cancelled the request answers it, the handler may have returned early because of it
+            if (request->cancel.IsCancelled()) return;
+            Answer(*request, std::move(response));
+        };
+
+        // never wait for a queue slot: the reader must keep reading, a notifications/cancelled
+        // behind a full queue frees the workers it is waiting for
+        if (!pool_ || !pool_->TrySubmit(std::move(task))) {
+            bool stopping = !pool_ || isStopping_;
+            LOG(WARNING) << (stopping ? "Request workers not running" : "Request queue full")
+                         << ", dropping " << (request->key.empty() ? std::string("a notification") : "request " + request->key) << std::endl;
+            Answer(*request, request->key.empty() ? std::string()
+                   : stopping ? MCPBuilder::Error(MCPBuilder::InternalError, request->id, "Server is stopping").dump()
+                              : MCPBuilder::Error(MCPBuilder::ServerBusy, request->id, "Server is busy, retry later").dump());
+        }
+    }
+
+    void Server::Answer(InFlight& request, std::string response) {
+        // the late result of a request cancelled or timed out is dropped
+        if (request.answered.exchange(true)) return;
+
+        {
+            std::lock_guard<std::mutex> lock(deadline_mutex_);
+            if (request.armed) {
+                deadlines_.erase(request.deadline);
+                request.armed = false;
+            }
+        }
+
+        // release the id before answering, the client may reuse it right away
+        if (!request.key.empty()) {
+            std::lock_guard<std::mutex> lock(inflight_mutex_);
+            inflight_.erase(request.key);
+        }
+
+        request.reply(std::move(response));
+    }
+
+    void Server::Cancel(const json& notification, const std::string& scope) {
+        auto params = notification.find("params");
+        if (params == notification.end() || !params->is_object() || !params->contains("requestId")) {
+            LOG(WARNING) << "notifications/cancelled without a requestId, ignored." << std::endl;
+            return;
+        }
+
+        std::string key = scope + '/' + (*params)["requestId"].dump();
+        std::shared_ptr<InFlight> request;
+        {
+            std::lock_guard<std::mutex> lock(inflight_mutex_);
+            auto it = inflight_.find(key);
+            if (it != inflight_.end()) request = it->second;
+        }
+        // already answered, the cancellation crossed the response
+        if (!request) {
+            LOG(DEBUG) << "Request " << key << " to cancel is not in flight." << std::endl;
+            return;
+        }
+
+        if (request->cancel.Cancel(CancelToken::Reason::Cancelled)) {
+            auto reason = params->find("reason");
+            LOG(INFO) << "Request " << key << " cancelled by the client: "
+                      << (reason != params->end() && reason->is_string() ? reason->get<std::string>() : "no reason given") << std::endl;
+            Answer(*request, MCPBuilder::Error(MCPBuilder::RequestCancelled, request->id, "Request cancelled").dump());
+        }
+    }
+
+    void Server::DispatchBatch(json batch, IListener::Reply reply, const std::string& scope) {
+        if (batch.empty()) {
+            reply(MCPBuilder::Error(MCPBuilder::InvalidRequest, json(), "Empty batch").dump());
+            return;
+        }
+
+        // the elements run concurrently on the workers, the last one to finish answers the batch
+        struct BatchState {
+            std::mutex mutex;
+            std::vector<std::string> responses; // in the order of the requests, empty for notifications
+            size_t remaining;
+            IListener::Reply reply;
+        };
+        auto state = std::make_shared<BatchState>();
+        state->responses.resize(batch.size());
+        state->remaining = batch.size();
+        state->reply = std::move(reply);
+
+        auto complete = [state](size_t index, std::string response) {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->responses[index] = std::move(response);
+                if (--state->remaining > 0) return;
+            }
+
+            std::string responses;
+            for (auto& response : state->responses) {
+                if (response.empty()) continue;
+                responses += responses.empty() ? '[' : ',';
+                responses += response;
+            }
+            // a batch of notifications gets no response at all
+            if (!responses.empty()) responses += ']';
+            state->reply(std::move(responses));
+        };
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (batch[i].is_array()) {
+                complete(i, MCPBuilder::Error(MCPBuilder::InvalidRequest, json(), "Invalid Request").dump());
+                continue;
+            }
+            Dispatch(std::move(batch[i]), [complete, i](std::string response) {
+                complete(i, std::move(response));
+            }, scope);
+        }
+    }
+
+    void Server::WriteResponse(std::string response) {
+        // responses go through the writer too, so they share its batches with the notifications
+        LOG(DEBUG) << "Sending Response: " << response << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(output_mutex_);
+            output_queue_.push_back(std::move(response));
+        }
+        NotifyWriter();
+    }
+
+    std::string Server::HandleRequestRaw(const json &request, const CancelToken* cancel) {
+        if (request.is_object() && request.contains("method") && request["method"].is_string()) {
+            const auto& method = request["method"].get_ref<const std::string&>();
+            // e.g. a tools/call inside a batch, already parsed
+            auto envelopeIt = envelopeFunctionMap.find(method);
+            if (envelopeIt != envelopeFunctionMap.end()) {
+                Envelope envelope(request);
+                envelope.cancel = cancel;
+                return envelopeIt->second(envelope);
+            }
+            auto it = rawFunctionMap.find(method);
+            if (it != rawFunctionMap.end()) {
+                if (verboseLevel_ == 1) {
+                    LOG(DEBUG) << "=== Request START ===" << std::endl;
+                    LOG(DEBUG) << request.dump(4) << std::endl;
+                    LOG(DEBUG) << "=== Request END ===" << std::endl;
+                }
+                std::string response = it->second(request);
+                if (verboseLevel_ == 1 && !response.empty()) {
+                    LOG(DEBUG) << "=== Response START ===" << std::endl;
+                    LOG(DEBUG) << response << std::endl;
+                    LOG(DEBUG) << "=== Response END ===" << std::endl;
+                }
+                return response;
+            }
         }
-        queue_cv_.notify_one(); // Notify the writer thread
+
+        json response = HandleRequest(request);
+        if (response == nullptr) return std::string();
+
+        auto start = Metrics::Clock::now();
+        std::string text = response.dump();
+        MetricsOf(Metrics::MethodOf(request)).serialize->Record(Metrics::Elapsed(start));
+        return text;
     }
 
     json Server::HandleRequest(const json &request) {
@@ -248,6 +702,9 @@ namespace vx::mcp {
         }
 
         // mandatory checks
+        if (!request.is_object()) {
+            return MCPBuilder::Error(MCPBuilder::InvalidRequest, json(), "Invalid Request");
+        }
         if (!request.contains("method")) {
             return MCPBuilder::Error(MCPBuilder::InvalidRequest, request["id"], "Missing method");
         }
@@ -268,13 +725,29 @@ namespace vx::mcp {
         }
 
         // handle method not found case
-        int id = request["id"];
-        return MCPBuilder::Error(MCPBuilder::MethodNotFound, std::to_string(id), "Method not found");
+        return MCPBuilder::Error(MCPBuilder::MethodNotFound, request.contains("id") ? request["id"] : json(), "Method not found");
     }
 
     bool Server::OverrideCallback(const std::string &method, std::function<json(const json &)> function) {
         if (functionMap.find(method) != functionMap.end()) {
             functionMap[method] = std::move(function);
+            rawFunctionMap.erase(method);
+            return true;
+        }
+        return false;
+    }
+
+    bool Server::OverrideRawCallback(const std::string &method, std::function<std::string(const json &)> function) {
+        if (functionMap.find(method) != functionMap.end()) {
+            rawFunctionMap[method] = std::move(function);
+            return true;
+        }
+        return false;
+    }
+
+    bool Server::OverrideEnvelopeCallback(const std::string &method, std::function<std::string(const Envelope &)> function) {
+        if (functionMap.find(method) != functionMap.end()) {
+            envelopeFunctionMap[method] = std::move(function);
             return true;
         }
         return false;
@@ -448,6 +921,8 @@ namespace vx::mcp {
     }
 
     json Server::NotificationCancelledCmd(const json &request) {
+        // Dispatch() handles it with the scope of the session, this is only reached without one
+        Cancel(request, {});
         return nullptr;
     }
 
@@ -485,20 +960,21 @@ namespace vx::mcp {
         isStopping_ = true;
         LOG(INFO) << "Stopping async server..." << std::endl;
 
-        // Stop writer thread
-        writer_running_ = false;
-        queue_cv_.notify_one();
-        if (writer_thread_.joinable()) {
-            writer_thread_.join();
-            LOG(INFO) << "Writer thread joined." << std::endl;
-        }
-
-        // Stop reader thread
+        // Stop reading first, so no new request reaches the workers
         reader_running_ = false;
+        reader_running_.notify_all();
+        if (transport_) transport_->CancelRead();
+
+        StopWorkers();
+
+        // The writer drains the queue, then stops the loop
+        writer_running_ = false;
+        NotifyWriter();
         if (reader_thread_.joinable()) {
             reader_thread_.join();
-            LOG(INFO) << "Reader thread joined." << std::endl;
+            LOG(INFO) << "Event loop joined." << std::endl;
         }
+        if (transport_) transport_->Attach(nullptr);
 
         LOG(INFO) << "Async server stopped." << std::endl;
     }
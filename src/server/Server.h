@@ -25,16 +25,30 @@
 #ifndef MCP_SERVER_SERVER_H
 #define MCP_SERVER_SERVER_H
 
+#include <chrono>
+#include <deque>
+#include <map>
 #include <memory>
-#include <queue>
 #include <thread>
 #include <condition_variable>
+#include <unordered_map>
 #include "ITransport.h"
+#include "IListener.h"
+#include "EventLoop.h"
+#include "Envelope.h"
 #include "json.hpp"
+#include "../utils/ThreadPool.h"
+#include "../utils/CancelToken.h"
+#include "../utils/Histogram.h"
 
 using json = nlohmann::json;
 
 #define MAX_PARSER_ERRORS 50
+#define DEFAULT_WORKER_COUNT 4
+#define DEFAULT_QUEUE_DEPTH 64
+#define DEFAULT_WRITE_BATCH 64
+#define DEFAULT_FLUSH_LATENCY_US 0
+#define DEFAULT_CALL_TIMEOUT_MS 0
 
 namespace vx::mcp {
 
@@ -44,6 +58,11 @@ namespace vx::mcp {
         PROMPTS = 0 << 3,
     };
 
+    struct MethodHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view method) const { return std::hash<std::string_view>{}(method); }
+    };
+
     class Server {
     public:
         Server();
@@ -57,18 +76,84 @@ namespace vx::mcp {
 
         bool Connect(const std::shared_ptr<ITransport>& transport);
         bool ConnectAsync(const std::shared_ptr<ITransport> &transport);
+        // Serve every client of a multi-session listener, blocks until the listener stops
+        bool Serve(const std::shared_ptr<IListener>& listener);
 
         void Stop();
         void StopAsync();
+        // Block until the async reader is done (client disconnected or StopAsync)
+        void Wait();
 
-        inline bool IsValid() { return transport_ != nullptr; }
+        inline bool IsValid() { return transport_ != nullptr || listener_ != nullptr; }
         inline void VerboseLevel(int level) { verboseLevel_ = level; }
         inline void Name(const std::string& name) { name_ = name; }
+        inline void WorkerCount(size_t count) { workerCount_ = count; }
+        inline void QueueDepth(size_t depth) { queueDepth_ = depth; }
+        // Max messages written to the transport at once
+        inline void WriteBatchSize(size_t size) { writeBatchSize_ = size == 0 ? 1 : size; }
+        // How long the writer may wait for a partial batch to fill up, 0 writes what is pending right away
+        inline void FlushLatency(std::chrono::microseconds latency) { flushLatency_ = latency; }
+        // Deadline of every request counted from its receipt, 0 for none. A request past it is
+        // cancelled and answered with a RequestTimeout error
+        inline void CallTimeout(std::chrono::milliseconds timeout) { callTimeout_ = timeout; }
+        // Deadline of the tools/call requests of one tool, overrides CallTimeout (0 for none)
+        inline void ToolTimeout(const std::string& name, std::chrono::milliseconds timeout) { toolTimeouts_[name] = timeout; }
         bool OverrideCallback(const std::string &method, std::function<json(const json&)> function);
+        // Like OverrideCallback, but the function returns the response already serialized (empty for no response)
+        bool OverrideRawCallback(const std::string &method, std::function<std::string(const json&)> function);
+        // Like OverrideRawCallback, but the function gets the envelope of the message: a request of
+        // this method is routed on its envelope fields and never parsed into a DOM by the server
+        bool OverrideEnvelopeCallback(const std::string &method, std::function<std::string(const Envelope&)> function);
         void SendNotification(const std::string& pluginName, const char* notification);
 
     private:
+        // Histograms of a method, created with the server so that recording takes no lock
+        struct MethodMetrics {
+            Histogram* parse;
+            Histogram* queueWait;
+            Histogram* dispatch;
+            Histogram* serialize;
+        };
+
+        // A request with an id being processed. It is answered once, by whoever comes first:
+        // the worker running it, its deadline or a notifications/cancelled of the client
+        struct InFlight {
+            CancelToken cancel;
+            std::atomic<bool> answered{false};
+            json id;
+            std::string key; // scope + dumped id
+            IListener::Reply reply;
+            std::multimap<std::chrono::steady_clock::time_point, std::weak_ptr<InFlight>>::iterator deadline;
+            bool armed = false; // deadline is in deadlines_, protected by deadline_mutex_
+        };
+
         void WriterLoop();
+        Task<void> ReadLoopAsync();
+        Task<void> WriteLoopAsync();
+        void NotifyWriter();
+        void StartWorkers();
+        void StopWorkers();
+        // Parse a message and dispatch it, false (nothing dispatched) when it is not valid JSON
+        bool Receive(std::string message, const IListener::Reply& reply, const std::string& scope = {});
+        // reply receives the response (empty for notifications), ids are unique within a scope (session)
+        void Dispatch(json request, IListener::Reply reply, const std::string& scope = {});
+        // The histograms of a method, the "unknown" ones for a method the server does not
+        // register: a client cannot grow the metrics by sending made up methods
+        const MethodMetrics& MetricsOf(std::string_view method) const;
+        // Run a request on the workers, the id (if any) is in flight until it is answered
+        void Submit(bool hasId, json id, const MethodMetrics& metrics, std::chrono::milliseconds timeout,
+                    std::function<std::string(const CancelToken&)> handle, IListener::Reply reply, const std::string& scope);
+        // Reply to a request in flight and release its id, only the first answer is sent
+        void Answer(InFlight& request, std::string response);
+        // Cancel the request a notifications/cancelled names, if it is still in flight
+        void Cancel(const json& notification, const std::string& scope);
+        std::chrono::milliseconds TimeoutOf(std::string_view method, std::string_view tool) const;
+        void StartDeadlines();
+        void StopDeadlines();
+        void DeadlineLoop();
+        void DispatchBatch(json batch, IListener::Reply reply, const std::string& scope);
+        void WriteResponse(std::string response);
+        std::string HandleRequestRaw(const json& request, const CancelToken* cancel = nullptr);
         json HandleRequest(const json& request);
 
         json InitializeCmd(const json& request);
@@ -98,21 +183,45 @@ namespace vx::mcp {
 
     private:
         std::unordered_map<std::string, std::function<json(const json&)>> functionMap;
+        std::unordered_map<std::string, std::function<std::string(const json&)>> rawFunctionMap;
+        std::unordered_map<std::string, std::function<std::string(const Envelope&)>, MethodHash, std::equal_to<>> envelopeFunctionMap;
+        // every method of functionMap and the placeholders of Metrics::MethodOf, never changed after construction
+        std::unordered_map<std::string, MethodMetrics, MethodHash, std::equal_to<>> methodMetrics_;
 
         bool isStopping_ = false;
         int verboseLevel_ = 0;
         int parserErrors_ = 0;
         std::string name_ = "mcp-server";
+        size_t workerCount_ = DEFAULT_WORKER_COUNT;
+        size_t queueDepth_ = DEFAULT_QUEUE_DEPTH;
+        size_t writeBatchSize_ = DEFAULT_WRITE_BATCH;
+        std::chrono::microseconds flushLatency_{DEFAULT_FLUSH_LATENCY_US};
+        std::chrono::milliseconds callTimeout_{DEFAULT_CALL_TIMEOUT_MS};
+        std::unordered_map<std::string, std::chrono::milliseconds, MethodHash, std::equal_to<>> toolTimeouts_;
+
+        std::unique_ptr<ThreadPool> pool_;
+        std::mutex inflight_mutex_; // Protects inflight_
+        std::unordered_map<std::string, std::shared_ptr<InFlight>> inflight_; // by scope + dumped id
+
+        std::mutex deadline_mutex_; // Protects deadlines_, deadline_running_ and InFlight::armed
+        std::condition_variable deadline_cv_;
+        std::multimap<std::chrono::steady_clock::time_point, std::weak_ptr<InFlight>> deadlines_;
+        std::thread deadline_thread_;
+        bool deadline_running_ = false;
+
+        std::shared_ptr<IListener> listener_;
 
         std::shared_ptr<ITransport> transport_; // Store transport pointer
-        std::queue<std::string> notification_queue_;
-        std::mutex output_mutex_; // Protects both queue and transport writes
+        std::deque<std::string> output_queue_; // responses and notifications waiting for the writer
+        std::mutex output_mutex_; // Protects output_queue_
         std::condition_variable queue_cv_;
         std::thread writer_thread_;
         std::atomic<bool> writer_running_{false};
 
-        std::thread reader_thread_;
+        std::thread reader_thread_; // runs the event loop in async mode
         std::atomic<bool> reader_running_ = false;
+        std::unique_ptr<vx::transport::EventLoop> loop_;
+        std::unique_ptr<vx::transport::AsyncEvent> output_event_; // wakes the async writer
     };
 
 }
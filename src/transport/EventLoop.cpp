@@ -0,0 +1,186 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "EventLoop.h"
+#include "aixlog.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace vx::transport {
+
+    EventLoop::EventLoop() {
+#ifdef __linux__
+        epoll_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_ < 0 || wake_ < 0) {
+            LOG(ERROR) << "Event loop setup failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wake_;
+        epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &event);
+#endif
+    }
+
+    EventLoop::~EventLoop() {
+#ifdef __linux__
+        if (wake_ >= 0) close(wake_);
+        if (epoll_ >= 0) close(epoll_);
+#endif
+    }
+
+    bool EventLoop::AlwaysReady(int fd) {
+        auto [it, inserted] = watches_.try_emplace(fd);
+        if (inserted) {
+#ifdef __linux__
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+            event.data.fd = fd;
+            if (epoll_ < 0 || epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) < 0) {
+                // EPERM: regular files and the like, I/O on them never waits
+                it->second.alwaysReady = true;
+            }
+#else
+            it->second.alwaysReady = true;
+#endif
+        }
+        return it->second.alwaysReady;
+    }
+
+    void EventLoop::Wait(int fd, bool write, std::coroutine_handle<> handle, bool* ready) {
+        Watch& watch = watches_[fd];
+        Waiter& waiter = write ? watch.writer : watch.reader;
+        waiter.handle = handle;
+        waiter.ready = ready;
+    }
+
+    void EventLoop::Resume(Waiter& waiter, bool ready) {
+        if (!waiter.handle) return;
+        *waiter.ready = ready;
+        // clear the slot first, the coroutine may wait again before resume() returns
+        std::exchange(waiter.handle, nullptr).resume();
+    }
+
+    void EventLoop::CancelRead(int fd) {
+        Post([this, fd]() {
+            auto it = watches_.find(fd);
+            if (it != watches_.end()) Resume(it->second.reader, false);
+        });
+    }
+
+    void EventLoop::Remove(int fd) {
+        auto it = watches_.find(fd);
+        if (it == watches_.end()) return;
+        Watch watch = it->second;
+        watches_.erase(it);
+#ifdef __linux__
+        if (!watch.alwaysReady && epoll_ >= 0) {
+            epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+        }
+#endif
+        Resume(watch.reader, false);
+        Resume(watch.writer, false);
+    }
+
+    void EventLoop::Post(std::function<void()> function) {
+        {
+            std::lock_guard<std::mutex> lock(posted_mutex_);
+            posted_.push_back(std::move(function));
+        }
+#ifdef __linux__
+        if (wake_ >= 0) {
+            uint64_t one = 1;
+            [[maybe_unused]] auto written = write(wake_, &one, sizeof(one));
+            return;
+        }
+#endif
+        posted_cv_.notify_one();
+    }
+
+    void EventLoop::Stop() {
+        stopped_ = true;
+        Post([]() {});
+    }
+
+    void EventLoop::RunPosted() {
+        std::vector<std::function<void()>> posted;
+        {
+            std::lock_guard<std::mutex> lock(posted_mutex_);
+            posted.swap(posted_);
+        }
+        for (auto& function : posted) {
+            function();
+        }
+    }
+
+    void EventLoop::Run() {
+        while (!stopped_) {
+#ifdef __linux__
+            if (epoll_ >= 0 && wake_ >= 0) {
+                epoll_event events[16];
+                int count = epoll_wait(epoll_, events, 16, -1);
+                if (count < 0) {
+                    if (errno == EINTR) continue;
+                    LOG(ERROR) << "epoll_wait failed: " << strerror(errno) << std::endl;
+                    break;
+                }
+                for (int i = 0; i < count; i++) {
+                    int fd = events[i].data.fd;
+                    if (fd == wake_) {
+                        uint64_t value;
+                        [[maybe_unused]] auto read_ = read(wake_, &value, sizeof(value));
+                        RunPosted();
+                        continue;
+                    }
+                    // look the watch up again for each waiter, a resumed coroutine may add watches
+                    uint32_t flags = events[i].events;
+                    if (flags & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                        auto it = watches_.find(fd);
+                        if (it != watches_.end()) Resume(it->second.reader, true);
+                    }
+                    if (flags & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+                        auto it = watches_.find(fd);
+                        if (it != watches_.end()) Resume(it->second.writer, true);
+                    }
+                }
+                continue;
+            }
+#endif
+            {
+                std::unique_lock<std::mutex> lock(posted_mutex_);
+                posted_cv_.wait(lock, [this] { return !posted_.empty() || stopped_; });
+            }
+            RunPosted();
+        }
+    }
+
+}
@@ -0,0 +1,158 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_EVENT_LOOP_H
+#define MCP_SERVER_EVENT_LOOP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vx::transport {
+
+    // Single threaded readiness loop driving the async transports.
+    //
+    // A file descriptor is registered with epoll the first time it is awaited (edge triggered,
+    // both directions) and stays registered. Coroutines co_await Readable(fd) / Writable(fd)
+    // after an I/O call reported EAGAIN, and are resumed on the loop thread when the fd
+    // becomes ready. Descriptors epoll cannot watch (regular files) are always ready.
+    // On platforms without epoll every descriptor is always ready, so the I/O blocks the loop.
+    class EventLoop {
+    public:
+        EventLoop();
+        ~EventLoop();
+
+        EventLoop(const EventLoop&) = delete;
+        EventLoop& operator=(const EventLoop&) = delete;
+
+        class FdAwaiter {
+        public:
+            FdAwaiter(EventLoop& loop, int fd, bool write) : loop_(loop), fd_(fd), write_(write) {}
+
+            bool await_ready() { return loop_.AlwaysReady(fd_); }
+            void await_suspend(std::coroutine_handle<> handle) { loop_.Wait(fd_, write_, handle, &ready_); }
+            // false if the wait was cancelled
+            bool await_resume() const { return ready_; }
+
+        private:
+            EventLoop& loop_;
+            int fd_;
+            bool write_;
+            bool ready_ = true;
+        };
+
+        FdAwaiter Readable(int fd) { return {*this, fd, false}; }
+        FdAwaiter Writable(int fd) { return {*this, fd, true}; }
+
+        // Resume the readers waiting on fd with false, callable from any thread
+        void CancelRead(int fd);
+
+        // Stop watching fd before it is closed, its waiters resume with false. Loop thread only
+        void Remove(int fd);
+
+        // Run a function on the loop thread, callable from any thread
+        void Post(std::function<void()> function);
+
+        // Process events until Stop()
+        void Run();
+        void Stop();
+
+    private:
+        struct Waiter {
+            std::coroutine_handle<> handle;
+            bool* ready = nullptr;
+        };
+
+        struct Watch {
+            Waiter reader;
+            Waiter writer;
+            bool alwaysReady = false;
+        };
+
+        bool AlwaysReady(int fd);
+        void Wait(int fd, bool write, std::coroutine_handle<> handle, bool* ready);
+        static void Resume(Waiter& waiter, bool ready);
+        void RunPosted();
+
+    private:
+        int epoll_ = -1;
+        int wake_ = -1;
+        std::unordered_map<int, Watch> watches_;    // loop thread only
+        std::mutex posted_mutex_;
+        std::condition_variable posted_cv_;         // wakes Run() when there is no epoll
+        std::vector<std::function<void()>> posted_;
+        std::atomic<bool> stopped_{false};
+    };
+
+    // Wakes one coroutine from any thread; a notification sent while nobody waits is kept
+    class AsyncEvent {
+    public:
+        explicit AsyncEvent(EventLoop& loop) : loop_(loop) {}
+
+        // Callable from any thread, notifications are coalesced until the loop handles them
+        void Notify() {
+            if (!pending_.exchange(true)) {
+                loop_.Post([this]() { Fire(); });
+            }
+        }
+
+        class Awaiter {
+        public:
+            explicit Awaiter(AsyncEvent& event) : event_(event) {}
+
+            bool await_ready() { return std::exchange(event_.signaled_, false); }
+            void await_suspend(std::coroutine_handle<> handle) { event_.waiter_ = handle; }
+            void await_resume() {}
+
+        private:
+            AsyncEvent& event_;
+        };
+
+        // co_await Wait() suspends until the next Notify(), one coroutine at a time
+        Awaiter Wait() { return Awaiter(*this); }
+
+    private:
+        void Fire() {
+            pending_ = false;
+            if (waiter_) {
+                std::exchange(waiter_, nullptr).resume();
+            } else {
+                signaled_ = true;
+            }
+        }
+
+        EventLoop& loop_;
+        std::atomic<bool> pending_{false};
+        std::coroutine_handle<> waiter_;    // loop thread only
+        bool signaled_ = false;             // loop thread only
+    };
+
+}
+
+#endif //MCP_SERVER_EVENT_LOOP_H
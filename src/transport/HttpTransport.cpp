@@ -0,0 +1,338 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <future>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include "HttpTransport.h"
+#include "httplib.h"
+#include "aixlog.hpp"
+#include "../utils/MCPBuilder.h"
+#include "../server/Envelope.h"
+#include "../server/Metrics.h"
+
+namespace vx::transport {
+
+    static const char* SESSION_HEADER = "Mcp-Session-Id";
+
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 128 random bits, hex encoded: the session id is the only thing telling clients apart
+    static std::string NewSessionId() {
+        std::random_device random;
+        std::ostringstream oss;
+        oss << std::hex << std::setfill('0');
+        for (int i = 0; i < 4; i++) {
+            oss << std::setw(8) << static_cast<uint32_t>(random());
+        }
+        return oss.str();
+    }
+
+    static void SetError(httplib::Response& res, int status, MCPBuilder::ErrorCode code, const std::string& message) {
+        res.status = status;
+        res.set_content(MCPBuilder::Error(code, json(), message).dump(), "application/json");
+    }
+
+    Http::Http(std::string host, int port, size_t threads)
+            : host_(std::move(host)), port_(port), threads_(threads == 0 ? 1 : threads),
+              maxStreams_(threads_ / 2),
+              server_(std::make_unique<httplib::Server>()) {
+    }
+
+    Http::~Http() {
+        Stop();
+    }
+
+    bool Http::Listen(MessageHandler handler) {
+        handler_ = std::move(handler);
+
+        server_->new_task_queue = [threads = threads_] { return new httplib::ThreadPool(threads); };
+        server_->set_keep_alive_timeout(HTTP_KEEP_ALIVE_SECONDS);
+        server_->set_keep_alive_max_count(HTTP_KEEP_ALIVE_MAX_COUNT);
+        server_->set_payload_max_length(HTTP_MAX_PAYLOAD);
+        // small request/response pairs on a kept-alive connection, do not let Nagle hold them back
+        server_->set_tcp_nodelay(true);
+
+        server_->Post(HTTP_ENDPOINT, [this](const httplib::Request& req, httplib::Response& res) { OnPost(req, res); });
+        server_->Get(HTTP_ENDPOINT, [this](const httplib::Request& req, httplib::Response& res) { OnGet(req, res); });
+        server_->Delete(HTTP_ENDPOINT, [this](const httplib::Request& req, httplib::Response& res) { OnDelete(req, res); });
+        server_->Get(HTTP_METRICS_ENDPOINT, [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(vx::mcp::Metrics::GetInstance().ToPrometheus(), "text/plain; version=0.0.4");
+        });
+
+        bool bound;
+        if (port_ == 0) {
+            port_ = server_->bind_to_any_port(host_);
+            bound = port_ > 0;
+        } else {
+            bound = server_->bind_to_port(host_, port_);
+        }
+        if (!bound) {
+            LOG(ERROR) << "Cannot listen on " << host_ << ":" << port_ << std::endl;
+            return false;
+        }
+        if (stopping_) return true;
+
+        LOG(INFO) << "HTTP transport listening on http://" << host_ << ":" << port_ << HTTP_ENDPOINT
+                  << " (" << threads_ << " threads, " << maxStreams_ << " event streams)" << std::endl;
+        bool result = server_->listen_after_bind();
+
+        // wake the event streams still open, the server is gone
+        std::unique_lock<std::shared_mutex> lock(sessionsMutex_);
+        for (auto& [id, session] : sessions_) {
+            std::lock_guard<std::mutex> sessionLock(session->mutex);
+            session->closed = true;
+            session->cv.notify_all();
+        }
+        sessions_.clear();
+        LOG(INFO) << "HTTP transport stopped." << std::endl;
+        return result;
+    }
+
+    void Http::Stop() {
+        if (stopping_.exchange(true)) return;
+
+        {
+            std::shared_lock<std::shared_mutex> lock(sessionsMutex_);
+            for (auto& [id, session] : sessions_) {
+                std::lock_guard<std::mutex> sessionLock(session->mutex);
+                session->cv.notify_all();
+            }
+        }
+        server_->stop();
+    }
+
+    void Http::Broadcast(const std::string& message) {
+        std::shared_lock<std::shared_mutex> lock(sessionsMutex_);
+        for (auto& [id, session] : sessions_) {
+            std::lock_guard<std::mutex> sessionLock(session->mutex);
+            // a client that never reads its stream loses the oldest notifications, not the server memory
+            if (session->events.size() >= HTTP_MAX_SESSION_EVENTS) {
+                session->events.pop_front();
+            }
+            session->events.push_back(message);
+            session->cv.notify_one();
+        }
+    }
+
+    void Http::OnPost(const httplib::Request& req, httplib::Response& res) {
+        if (!CheckOrigin(req, res)) return;
+
+        // only the envelope is read here, the server parses the message when it handles it
+        vx::mcp::Envelope envelope(req.body);
+        if (envelope.Parse() == vx::mcp::Envelope::Result::SYNTAX_ERROR) {
+            LOG(ERROR) << "Error parsing JSON: " << envelope.error << std::endl;
+            SetError(res, 400, MCPBuilder::ParseError, "Parse error");
+            return;
+        }
+        if (!envelope.object && !envelope.batch) {
+            SetError(res, 400, MCPBuilder::InvalidRequest, "Invalid Request");
+            return;
+        }
+
+        // only requests get a response, notifications and responses from the client are just accepted;
+        // a batch is waited for, it gets 202 too if it only held notifications
+        bool isRequest = envelope.batch || (!envelope.method.empty() && envelope.hasId);
+
+        // initialize is never part of a batch
+        std::shared_ptr<Session> session;
+        if (envelope.object && isRequest && envelope.method == "initialize") {
+            session = CreateSession();
+            res.set_header(SESSION_HEADER, session->id);
+        } else {
+            session = FindSession(req, res);
+            if (!session) return;
+        }
+
+        if (!isRequest) {
+            handler_(session->id, req.body, [](std::string) {});
+            res.status = 202;
+            return;
+        }
+
+        // this connection thread waits while a worker handles the request
+        auto promise = std::make_shared<std::promise<std::string>>();
+        auto future = promise->get_future();
+        handler_(session->id, req.body, [promise](std::string response) {
+            promise->set_value(std::move(response));
+        });
+        std::string response = future.get();
+        if (response.empty()) {
+            res.status = 202;
+            return;
+        }
+        res.set_content(std::move(response), "application/json");
+    }
+
+    void Http::OnGet(const httplib::Request& req, httplib::Response& res) {
+        if (!CheckOrigin(req, res)) return;
+
+        auto session = FindSession(req, res);
+        if (!session) return;
+        {
+            std::lock_guard<std::mutex> lock(session->mutex);
+            if (session->streaming) {
+                SetError(res, 409, MCPBuilder::InvalidRequest, "Event stream already open");
+                return;
+            }
+            // every stream pins a pool thread, keep the other half of the pool for the requests
+            if (streams_.fetch_add(1) >= maxStreams_) {
+                streams_--;
+                LOG(WARNING) << "Refused event stream of session " << session->id << ", "
+                             << maxStreams_ << " streams already open" << std::endl;
+                res.set_header("Retry-After", std::to_string(HTTP_SSE_RETRY_SECONDS));
+                SetError(res, 503, MCPBuilder::ServerBusy, "Too many event streams open");
+                return;
+            }
+            session->streaming = true;
+        }
+
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider("text/event-stream", [this, session](size_t, httplib::DataSink& sink) {
+            std::string chunk;
+            {
+                std::unique_lock<std::mutex> lock(session->mutex);
+                session->cv.wait_for(lock, std::chrono::seconds(HTTP_SSE_HEARTBEAT_SECONDS), [&] {
+                    return !session->events.empty() || session->closed || stopping_.load();
+                });
+                if (session->closed || stopping_) {
+                    sink.done();
+                    return true;
+                }
+                while (!session->events.empty()) {
+                    chunk += "event: message\ndata: ";
+                    chunk += session->events.front();
+                    chunk += "\n\n";
+                    session->events.pop_front();
+                }
+            }
+            session->lastSeen = Now();
+
+            // a comment every now and then keeps proxies from closing an idle stream, and finds dead clients
+            if (chunk.empty()) chunk = ": keep-alive\n\n";
+            return sink.write(chunk.data(), chunk.size());
+        }, [this, session](bool) {
+            std::lock_guard<std::mutex> lock(session->mutex);
+            session->streaming = false;
+            streams_--;
+        });
+    }
+
+    void Http::OnDelete(const httplib::Request& req, httplib::Response& res) {
+        if (!CheckOrigin(req, res)) return;
+
+        auto session = FindSession(req, res);
+        if (!session) return;
+        CloseSession(session);
+        res.status = 204;
+    }
+
+    bool Http::CheckOrigin(const httplib::Request& req, httplib::Response& res) {
+        // browsers always send an Origin, refuse pages of other sites (DNS rebinding)
+        if (!req.has_header("Origin")) return true;
+
+        std::string origin = req.get_header_value("Origin");
+        size_t begin = origin.find("://");
+        begin = begin == std::string::npos ? 0 : begin + 3;
+        size_t end = origin.find(origin[begin] == '[' ? ']' : ':', begin);
+        if (end != std::string::npos && origin[begin] == '[') end++;
+        std::string host = origin.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+        if (host == "localhost" || host == "127.0.0.1" || host == "[::1]" || host == host_) return true;
+
+        LOG(WARNING) << "Rejected request from origin " << origin << std::endl;
+        SetError(res, 403, MCPBuilder::InvalidRequest, "Forbidden origin");
+        return false;
+    }
+
+    std::shared_ptr<Http::Session> Http::FindSession(const httplib::Request& req, httplib::Response& res) {
+        if (!req.has_header(SESSION_HEADER)) {
+            SetError(res, 400, MCPBuilder::InvalidRequest, "Missing Mcp-Session-Id header");
+            return nullptr;
+        }
+
+        std::shared_ptr<Session> session;
+        {
+            std::shared_lock<std::shared_mutex> lock(sessionsMutex_);
+            auto it = sessions_.find(req.get_header_value(SESSION_HEADER));
+            if (it != sessions_.end()) session = it->second;
+        }
+        if (!session) {
+            // the client has to initialize again
+            SetError(res, 404, MCPBuilder::InvalidRequest, "Session not found");
+            return nullptr;
+        }
+        session->lastSeen = Now();
+        return session;
+    }
+
+    std::shared_ptr<Http::Session> Http::CreateSession() {
+        SweepSessions();
+
+        auto session = std::make_shared<Session>();
+        session->id = NewSessionId();
+        session->lastSeen = Now();
+        {
+            std::unique_lock<std::shared_mutex> lock(sessionsMutex_);
+            sessions_[session->id] = session;
+        }
+        LOG(INFO) << "HTTP session opened: " << session->id << std::endl;
+        return session;
+    }
+
+    void Http::CloseSession(const std::shared_ptr<Session>& session) {
+        {
+            std::unique_lock<std::shared_mutex> lock(sessionsMutex_);
+            sessions_.erase(session->id);
+        }
+        {
+            std::lock_guard<std::mutex> lock(session->mutex);
+            session->closed = true;
+            session->cv.notify_all();
+        }
+        LOG(INFO) << "HTTP session closed: " << session->id << std::endl;
+    }
+
+    void Http::SweepSessions() {
+        // clients are not required to DELETE their session, forget the ones gone quiet
+        int64_t now = Now();
+        std::unique_lock<std::shared_mutex> lock(sessionsMutex_);
+        for (auto it = sessions_.begin(); it != sessions_.end();) {
+            std::shared_ptr<Session> session = it->second;
+            std::lock_guard<std::mutex> sessionLock(session->mutex);
+            if (!session->streaming && now - session->lastSeen > HTTP_SESSION_IDLE_SECONDS) {
+                LOG(INFO) << "HTTP session expired: " << session->id << std::endl;
+                session->closed = true;
+                it = sessions_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+}
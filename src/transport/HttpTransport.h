@@ -0,0 +1,121 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_HTTP_TRANSPORT_H
+#define MCP_SERVER_HTTP_TRANSPORT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include "IListener.h"
+
+#define DEFAULT_HTTP_HOST "127.0.0.1"
+#define DEFAULT_HTTP_PORT 8080
+#define DEFAULT_HTTP_THREADS 32
+#define HTTP_ENDPOINT "/mcp"
+#define HTTP_METRICS_ENDPOINT "/metrics"
+#define HTTP_KEEP_ALIVE_SECONDS 5
+#define HTTP_KEEP_ALIVE_MAX_COUNT 1000
+#define HTTP_MAX_PAYLOAD (8 * 1024 * 1024)
+#define HTTP_SSE_HEARTBEAT_SECONDS 15
+#define HTTP_SSE_RETRY_SECONDS 5
+#define HTTP_SESSION_IDLE_SECONDS (30 * 60)
+#define HTTP_MAX_SESSION_EVENTS 1024
+
+namespace httplib {
+    class Server;
+    struct Request;
+    struct Response;
+}
+
+namespace vx::transport {
+
+    // MCP Streamable HTTP: one endpoint, POST carries client messages and gets the response
+    // back as application/json, GET opens a text/event-stream for the server notifications,
+    // DELETE ends the session. Clients are told apart by the Mcp-Session-Id header, which
+    // the server assigns in the response to initialize. GET /metrics serves the latency
+    // histograms to Prometheus.
+    //
+    // Connections are served by a fixed pool of threads (--http-threads) with keep-alive:
+    // an open event stream holds one of them for as long as the client listens, a POST
+    // holds one until its response is ready and an idle kept-alive connection holds one for
+    // up to HTTP_KEEP_ALIVE_SECONDS. At most half of the pool serves event streams, a GET
+    // past that is refused with 503 so the streams can never starve the requests.
+    class Http : public vx::IListener {
+    public:
+        Http(std::string host, int port, size_t threads);
+        ~Http() override;
+
+        bool Listen(MessageHandler handler) override;
+        void Stop() override;
+        void Broadcast(const std::string& message) override;
+
+        inline std::string GetName() override { return "http"; }
+        inline std::string GetVersion() override { return "0.1"; }
+        inline int GetPort() override { return port_; }
+
+    private:
+        struct Session {
+            std::string id;
+            std::mutex mutex;               // guards events and streaming
+            std::condition_variable cv;
+            std::deque<std::string> events; // notifications not yet sent on the event stream
+            bool streaming = false;         // a GET is attached
+            bool closed = false;
+            std::atomic<int64_t> lastSeen;  // steady clock seconds, for the idle sweep
+        };
+
+        void OnPost(const httplib::Request& req, httplib::Response& res);
+        void OnGet(const httplib::Request& req, httplib::Response& res);
+        void OnDelete(const httplib::Request& req, httplib::Response& res);
+
+        bool CheckOrigin(const httplib::Request& req, httplib::Response& res);
+        std::shared_ptr<Session> FindSession(const httplib::Request& req, httplib::Response& res);
+        std::shared_ptr<Session> CreateSession();
+        void CloseSession(const std::shared_ptr<Session>& session);
+        void SweepSessions();
+
+    private:
+        std::string host_;
+        int port_;
+        size_t threads_;
+        size_t maxStreams_;               // event streams allowed open at once
+        std::atomic<size_t> streams_{0};  // event streams open
+        MessageHandler handler_;
+        std::unique_ptr<httplib::Server> server_;
+        std::atomic<bool> stopping_{false};
+
+        std::shared_mutex sessionsMutex_; // readers look sessions up, writers add and remove them
+        std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
+    };
+
+}
+
+#endif //MCP_SERVER_HTTP_TRANSPORT_H
@@ -11,7 +11,7 @@
 //  the following conditions:
 //
 //  The above copyright notice and this permission notice shall be
-//   included in all copies or substantial portions of the Software.
+//  included in all copies or substantial portions of the Software.
 //
 //  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
 //  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
@@ -22,47 +22,139 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#include <cerrno>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include "StdioTransport.h"
 #include "aixlog.hpp"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
 namespace vx::transport {
 
+    Stdio::~Stdio() {
+        Attach(nullptr);
+    }
+
     std::pair<size_t, std::string> Stdio::Read() {
-        std::string line;
-        std::string json_data;
+        std::string_view line;
+        do {
+            // an empty pair means disconnected for the callers, skip blank lines
+            if (!ReadView(line)) return {0, std::string()};
+        } while (line.empty());
+        return {line.length(), std::string(line)};
+    }
 
-        // Read headers until an empty line
-        while (true) {
-            int c;
-            while ((c = std::getc(stdin)) != EOF && c != '\n') {
-                json_data += static_cast<char>(c);
+    bool Stdio::ReadView(std::string_view& message) {
+        std::lock_guard<std::mutex> lock(readMutex_);
+        return reader_.Next(message);
+    }
+
+    void Stdio::Write(const std::string& json_data) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        writeBuffer_.assign(json_data);
+        writeBuffer_.push_back('\n');
+        WriteAll(writeBuffer_.data(), writeBuffer_.size());
+    }
+
+    void Stdio::WriteBatch(const std::vector<std::string>& messages) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        AssembleBatch(messages);
+        WriteAll(writeBuffer_.data(), writeBuffer_.size());
+    }
+
+    void Stdio::AssembleBatch(const std::vector<std::string>& messages) {
+        // do not keep a huge buffer around after one large batch
+        if (writeBuffer_.capacity() > MAX_RETAINED_WRITE_BUFFER) {
+            std::string().swap(writeBuffer_);
+        }
+        writeBuffer_.clear();
+        for (const auto& message : messages) {
+            writeBuffer_.append(message);
+            writeBuffer_.push_back('\n');
+        }
+    }
+
+    void Stdio::WriteAll(const char* data, size_t length) {
+        // stdout is written with write(2) only, one call per batch unless the pipe is full
+        while (length > 0) {
+#ifdef _WIN32
+            int count = _write(1, data, static_cast<unsigned int>(length));
+#else
+            ssize_t count = write(STDOUT_FILENO, data, length);
+#endif
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("stdout write failed: ") + strerror(errno));
             }
-            break;
+            data += count;
+            length -= static_cast<size_t>(count);
         }
+    }
 
-        return {json_data.length(), json_data};
+    void Stdio::Attach(EventLoop* loop) {
+#ifndef _WIN32
+        if (loop && !loop_) {
+            // the loop waits for readiness, the descriptors must not block
+            stdinFlags_ = fcntl(STDIN_FILENO, F_GETFL);
+            stdoutFlags_ = fcntl(STDOUT_FILENO, F_GETFL);
+            if (stdinFlags_ >= 0) fcntl(STDIN_FILENO, F_SETFL, stdinFlags_ | O_NONBLOCK);
+            if (stdoutFlags_ >= 0) fcntl(STDOUT_FILENO, F_SETFL, stdoutFlags_ | O_NONBLOCK);
+        } else if (!loop && loop_) {
+            if (stdinFlags_ >= 0) fcntl(STDIN_FILENO, F_SETFL, stdinFlags_);
+            if (stdoutFlags_ >= 0) fcntl(STDOUT_FILENO, F_SETFL, stdoutFlags_);
+        }
+#endif
+        loop_ = loop;
     }
 
-    std::future<std::pair<size_t, std::string>> Stdio::ReadAsync() {
-        return std::async(std::launch::async, []() {
-            std::string json_data;
-            int c;
-            while ((c = std::getc(stdin)) != EOF && c != '\n') {
-                json_data += static_cast<char>(c);
-            }
-            return std::make_pair(json_data.length(), json_data);
-        });
+    void Stdio::CancelRead() {
+        if (loop_) loop_->CancelRead(0);
     }
 
-    void Stdio::Write(const std::string& json_data) {
-        std::cout << json_data << std::endl << std::flush;
+    Task<bool> Stdio::ReadViewAsync(std::string_view& message) {
+        if (!loop_) co_return ReadView(message);
+
+        // plain ifs on purpose: GCC 12 miscompiles a switch with a co_await in one of its cases
+        while (true) {
+            LineReader::Status status = reader_.Poll(message);
+            if (status == LineReader::Status::Line) co_return true;
+            if (status == LineReader::Status::End) co_return false;
+            // no complete line yet, wait for stdin; false when the read was cancelled
+            if (!co_await loop_->Readable(0)) co_return false;
+        }
     }
 
-    std::future<void> Stdio::WriteAsync(const std::string& json_data) {
-        return std::async(std::launch::async, [json_data]() {
-            std::cout << json_data << std::endl << std::flush;
-        });
+    Task<void> Stdio::WriteBatchAsync(const std::vector<std::string>& messages) {
+        if (!loop_) {
+            WriteBatch(messages);
+            co_return;
+        }
+
+        // only the loop thread writes in async mode, the buffer is not shared with WriteBatch callers
+        AssembleBatch(messages);
+        const char* data = writeBuffer_.data();
+        size_t length = writeBuffer_.size();
+        while (length > 0) {
+#ifdef _WIN32
+            int count = _write(1, data, static_cast<unsigned int>(length));
+#else
+            ssize_t count = write(STDOUT_FILENO, data, length);
+#endif
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    co_await loop_->Writable(1);
+                    continue;
+                }
+                throw std::runtime_error(std::string("stdout write failed: ") + strerror(errno));
+            }
+            data += count;
+            length -= static_cast<size_t>(count);
+        }
     }
 
 }
@@ -25,23 +25,46 @@
 #ifndef MCP_SERVER_STDIO_TRANSPORT_H
 #define MCP_SERVER_STDIO_TRANSPORT_H
 
+#include <mutex>
 #include "ITransport.h"
+#include "EventLoop.h"
+#include "../utils/LineReader.h"
+
+#define MAX_RETAINED_WRITE_BUFFER (4 * 1024 * 1024)
 
 namespace vx::transport {
 
     class Stdio : public vx::ITransport {
     public:
-        Stdio() = default;
+        Stdio() : reader_(0) {}
+        ~Stdio() override;
 
         std::pair<size_t, std::string> Read() override;
+        bool ReadView(std::string_view& message) override;
         void Write(const std::string& json_data) override;
+        void WriteBatch(const std::vector<std::string>& messages) override;
 
-        std::future<std::pair<size_t, std::string>> ReadAsync() override;
-        std::future<void> WriteAsync(const std::string& json_data) override;
+        void Attach(EventLoop* loop) override;
+        void CancelRead() override;
+        Task<bool> ReadViewAsync(std::string_view& message) override;
+        Task<void> WriteBatchAsync(const std::vector<std::string>& messages) override;
 
         inline std::string GetName() override { return "stdio"; }
         inline std::string GetVersion() override { return "0.2"; }
         inline int GetPort() override { return 0; }
+
+    private:
+        void WriteAll(const char* data, size_t length);
+        void AssembleBatch(const std::vector<std::string>& messages);
+
+    private:
+        LineReader reader_;         // stdin
+        std::mutex readMutex_;      // guards reader_ for the blocking Read/ReadView
+        std::string writeBuffer_;   // reused to assemble a batch, guarded by writeMutex_ in blocking mode
+        std::mutex writeMutex_;
+        EventLoop* loop_ = nullptr;
+        int stdinFlags_ = -1;       // descriptor flags before Attach(), restored by Attach(nullptr)
+        int stdoutFlags_ = -1;
     };
 
 }
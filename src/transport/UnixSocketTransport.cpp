@@ -0,0 +1,308 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "UnixSocketTransport.h"
+#include "aixlog.hpp"
+#include "../server/Metrics.h"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define MAX_RETAINED_SOCKET_BUFFER (1024 * 1024)
+
+namespace vx::transport {
+
+    UnixSocket::UnixSocket(std::string path)
+            : path_(std::move(path)), loop_(std::make_unique<EventLoop>()) {
+    }
+
+    UnixSocket::~UnixSocket() {
+        Stop();
+    }
+
+#ifdef __linux__
+
+    // true if a server still accepts connections on the socket file
+    static bool IsListening(const sockaddr_un& address) {
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe < 0) return false;
+        bool listening = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        close(probe);
+        return listening;
+    }
+
+    bool UnixSocket::Listen(MessageHandler handler) {
+        handler_ = std::move(handler);
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path_.empty() || path_.size() >= sizeof(address.sun_path)) {
+            LOG(ERROR) << "Invalid unix socket path: " << path_ << std::endl;
+            return false;
+        }
+        memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+
+        listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0) {
+            LOG(ERROR) << "Cannot create unix socket: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        // the file left by a server that did not exit cleanly is replaced, a live server is not
+        int result = bind(listenFd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+        if (result < 0 && errno == EADDRINUSE && !IsListening(address)) {
+            unlink(path_.c_str());
+            result = bind(listenFd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+        }
+        if (result < 0 || listen(listenFd_, SOMAXCONN) < 0) {
+            LOG(ERROR) << "Cannot listen on " << path_ << ": " << strerror(errno) << std::endl;
+            close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+        // sessions are not authenticated, only the user running the server may connect
+        chmod(path_.c_str(), S_IRUSR | S_IWUSR);
+
+        LOG(INFO) << "Unix socket transport listening on " << path_ << std::endl;
+        accepting_ = true;
+        Task<void> acceptor = AcceptLoop();
+        acceptor.Start();
+        loop_->Run();
+
+        close(listenFd_);
+        listenFd_ = -1;
+        unlink(path_.c_str());
+        LOG(INFO) << "Unix socket transport stopped." << std::endl;
+        return true;
+    }
+
+    void UnixSocket::Stop() {
+        if (stopping_.exchange(true)) return;
+
+        // stop accepting, and let every session answer what it already received before closing
+        loop_->Post([this]() {
+            if (listenFd_ >= 0) loop_->Remove(listenFd_);
+            std::vector<int> fds;
+            {
+                std::lock_guard<std::mutex> lock(connectionsMutex_);
+                for (auto& [fd, connection] : connections_) fds.push_back(fd);
+            }
+            for (int fd : fds) loop_->CancelRead(fd);
+            StopWhenIdle();
+        });
+    }
+
+    void UnixSocket::Broadcast(const std::string& message) {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        for (auto& [fd, connection] : connections_) {
+            connection->Send(message, false);
+        }
+    }
+
+    void UnixSocket::Connection::Send(std::string message, bool response) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (response && pending-- == UNIX_MAX_PENDING_REQUESTS && !closed) resume.Notify();
+        if (closed) return;
+        if (!message.empty()) {
+            // a client that does not read loses notifications, never responses
+            if (!response && output.size() >= UNIX_MAX_PENDING_NOTIFICATIONS) return;
+            output.push_back(std::move(message));
+        }
+        // under the lock: once closed is set no wake up is left in flight
+        event.Notify();
+    }
+
+    Task<void> UnixSocket::AcceptLoop() {
+        while (!stopping_) {
+            int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd >= 0) {
+                Open(fd);
+                continue;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG(ERROR) << "accept failed: " << strerror(errno) << std::endl;
+            }
+            // wait for the next client, false when the listener stops
+            if (!co_await loop_->Readable(listenFd_)) break;
+        }
+
+        accepting_ = false;
+        StopWhenIdle();
+    }
+
+    void UnixSocket::Open(int fd) {
+        auto connection = std::make_shared<Connection>(fd, *loop_);
+        connection->session = "unix-" + std::to_string(++nextSession_);
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex_);
+            connections_[fd] = connection;
+        }
+        LOG(INFO) << "Unix socket session opened: " << connection->session << std::endl;
+
+        connection->readTask = ReadLoop(connection.get());
+        connection->writeTask = WriteLoop(connection.get());
+        connection->readTask.Start();
+        connection->writeTask.Start();
+    }
+
+    Task<void> UnixSocket::ReadLoop(Connection* connection) {
+        std::string_view line;
+        // plain ifs on purpose: GCC 12 miscompiles a switch with a co_await in one of its cases
+        while (!stopping_) {
+            bool full;
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                full = connection->pending >= UNIX_MAX_PENDING_REQUESTS;
+            }
+            if (full) {
+                // the requests left in the socket wait, the other sessions are served meanwhile
+                co_await connection->resume.Wait();
+                continue;
+            }
+            LineReader::Status status = connection->reader.Poll(line);
+            if (status == LineReader::Status::End) break;
+            if (status == LineReader::Status::WouldBlock) {
+                // false when the session is closed or the listener stops
+                if (!co_await loop_->Readable(connection->fd)) break;
+                continue;
+            }
+            if (line.empty()) continue;
+
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                connection->pending++;
+            }
+            // the worker may answer after the client is gone
+            std::weak_ptr<Connection> target = connection->weak_from_this();
+            handler_(connection->session, std::string(line), [target](std::string response) {
+                if (auto connection = target.lock()) connection->Send(std::move(response), true);
+            });
+        }
+
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->readerDone = true;
+        if (!connection->closed) connection->event.Notify();
+    }
+
+    Task<void> UnixSocket::WriteLoop(Connection* connection) {
+        std::string& buffer = connection->writeBuffer;
+        Histogram& flushTime = vx::mcp::Metrics::GetInstance().Get(vx::mcp::Metrics::FLUSH, GetName());
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                // the client stopped sending and everything it asked is written
+                if (connection->output.empty() && connection->readerDone && connection->pending == 0) break;
+                while (!connection->output.empty()) {
+                    buffer += connection->output.front();
+                    buffer += '\n';
+                    connection->output.pop_front();
+                }
+            }
+            if (buffer.empty()) {
+                co_await connection->event.Wait();
+                continue;
+            }
+
+            auto start = vx::mcp::Metrics::Clock::now();
+            const char* data = buffer.data();
+            size_t length = buffer.size();
+            bool failed = false;
+            while (length > 0 && !failed) {
+                ssize_t count = send(connection->fd, data, length, MSG_NOSIGNAL);
+                if (count < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        failed = !co_await loop_->Writable(connection->fd);
+                        continue;
+                    }
+                    LOG(WARNING) << "Write to " << connection->session << " failed: " << strerror(errno) << std::endl;
+                    failed = true;
+                    continue;
+                }
+                data += count;
+                length -= static_cast<size_t>(count);
+            }
+            flushTime.Record(vx::mcp::Metrics::Elapsed(start));
+            buffer.clear();
+            if (failed) break;
+            if (buffer.capacity() > MAX_RETAINED_SOCKET_BUFFER) buffer.shrink_to_fit();
+        }
+
+        Close(connection);
+    }
+
+    void UnixSocket::Close(Connection* connection) {
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            connection->closed = true;
+        }
+        std::shared_ptr<Connection> self;
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex_);
+            auto it = connections_.find(connection->fd);
+            self = std::move(it->second);
+            connections_.erase(it);
+        }
+
+        // a reader still waiting (the client vanished while we wrote) ends here
+        loop_->Remove(connection->fd);
+        close(connection->fd);
+        LOG(INFO) << "Unix socket session closed: " << connection->session << std::endl;
+
+        // called from the writer coroutine: its frame is freed later, from the loop
+        loop_->Post([this, self]() { StopWhenIdle(); });
+    }
+
+    void UnixSocket::StopWhenIdle() {
+        if (!stopping_ || accepting_) return;
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        if (connections_.empty()) loop_->Stop();
+    }
+
+#else
+
+    bool UnixSocket::Listen(MessageHandler handler) {
+        LOG(ERROR) << "The unix socket transport is only available on Linux." << std::endl;
+        return false;
+    }
+
+    void UnixSocket::Stop() {
+        stopping_ = true;
+    }
+
+    void UnixSocket::Broadcast(const std::string& message) {
+    }
+
+#endif
+
+}
@@ -0,0 +1,112 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_UNIX_SOCKET_TRANSPORT_H
+#define MCP_SERVER_UNIX_SOCKET_TRANSPORT_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "IListener.h"
+#include "EventLoop.h"
+#include "../utils/LineReader.h"
+#include "../utils/Task.h"
+
+#define DEFAULT_UNIX_SOCKET_PATH "/tmp/mcp-server.sock"
+#define UNIX_READ_BUFFER (16 * 1024)
+#define UNIX_MAX_PENDING_NOTIFICATIONS 1024
+// Requests of one connection in flight at once; past it the connection is not read until some
+// are answered, a client flooding the server only holds back its own session
+#define UNIX_MAX_PENDING_REQUESTS 32
+
+namespace vx::transport {
+
+    // Local IPC daemon: newline delimited JSON-RPC, as on stdio, over AF_UNIX stream
+    // connections. Every connection is a session of its own; one event loop thread accepts
+    // the clients and does all the socket I/O, the requests run on the server workers.
+    // The message handler must not block the loop: the server queues requests without waiting
+    // and answers them busy when its queue is full. Linux only, it relies on the epoll loop.
+    class UnixSocket : public vx::IListener {
+    public:
+        explicit UnixSocket(std::string path);
+        ~UnixSocket() override;
+
+        bool Listen(MessageHandler handler) override;
+        void Stop() override;
+        void Broadcast(const std::string& message) override;
+
+        inline std::string GetName() override { return "unix"; }
+        inline std::string GetVersion() override { return "0.1"; }
+        inline int GetPort() override { return 0; }
+        inline const std::string& GetPath() const { return path_; }
+
+    private:
+        struct Connection : std::enable_shared_from_this<Connection> {
+            Connection(int fd, EventLoop& loop) : fd(fd), reader(fd, UNIX_READ_BUFFER), event(loop), resume(loop) {}
+
+            // Queue a message for the writer, from any thread
+            void Send(std::string message, bool response);
+
+            int fd;
+            std::string session;
+            LineReader reader;          // loop thread only
+            std::string writeBuffer;    // loop thread only
+            Task<void> readTask;
+            Task<void> writeTask;
+
+            std::mutex mutex;           // guards the fields below
+            std::deque<std::string> output;
+            size_t pending = 0;         // requests dispatched and not answered yet
+            bool readerDone = false;
+            bool closed = false;        // no Notify() once set, the connection is about to go
+            AsyncEvent event;           // wakes the writer
+            AsyncEvent resume;          // wakes the reader held back by UNIX_MAX_PENDING_REQUESTS
+        };
+
+        Task<void> AcceptLoop();
+        Task<void> ReadLoop(Connection* connection);
+        Task<void> WriteLoop(Connection* connection);
+        void Open(int fd);
+        void Close(Connection* connection);
+        void StopWhenIdle();
+
+    private:
+        std::string path_;
+        int listenFd_ = -1;
+        MessageHandler handler_;
+        std::unique_ptr<EventLoop> loop_;
+        std::atomic<bool> stopping_{false};
+        bool accepting_ = false;        // loop thread only
+        uint64_t nextSession_ = 0;      // loop thread only
+
+        std::mutex connectionsMutex_;   // Broadcast() walks the connections from other threads
+        std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+    };
+
+}
+
+#endif //MCP_SERVER_UNIX_SOCKET_TRANSPORT_H
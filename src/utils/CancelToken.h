@@ -0,0 +1,81 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef MCP_SERVER_CANCEL_TOKEN_H
+#define MCP_SERVER_CANCEL_TOKEN_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+/// Cancellation state of one request in flight.
+/// The server cancels it when the client sends notifications/cancelled for the
+/// request or when its deadline passes. The code running the request polls
+/// IsCancelled(), or sets a handler to be woken up when it is waiting.
+class CancelToken
+{
+public:
+    enum class Reason { None, Cancelled, TimedOut };
+
+    bool IsCancelled() const { return reason_.load(std::memory_order_acquire) != Reason::None; }
+    Reason GetReason() const { return reason_.load(std::memory_order_acquire); }
+
+    /// Cancel and run the handler, if any. false if it was already cancelled.
+    bool Cancel(Reason reason)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Reason expected = Reason::None;
+        if (!reason_.compare_exchange_strong(expected, reason, std::memory_order_acq_rel)) return false;
+        if (handler_) handler_();
+        return true;
+    }
+
+    /// Run handler on the thread that cancels, or right away if that already happened.
+    /// The handler must not call back into the token.
+    void SetHandler(std::function<void()> handler) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (IsCancelled()) {
+            handler();
+            return;
+        }
+        handler_ = std::move(handler);
+    }
+
+    /// Remove the handler, waits for it if it is running
+    void ClearHandler() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handler_ = nullptr;
+    }
+
+private:
+    std::atomic<Reason> reason_{Reason::None};
+    // the handler is not part of the state: code that only reads the token may still wait on it
+    mutable std::mutex mutex_;
+    mutable std::function<void()> handler_;
+};
+
+#endif //MCP_SERVER_CANCEL_TOKEN_H
@@ -0,0 +1,131 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_HISTOGRAM_H
+#define MCP_SERVER_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+/// Log-linear latency histogram in the style of HdrHistogram.
+/// Every power of two range is split in 16 linear sub-buckets, so a recorded
+/// value is known within about 6%, over 1 .. 2^40 (nanoseconds: ~18 minutes).
+/// Record() is lock-free and wait-free apart from the max update, many threads
+/// may record while another one reads a snapshot.
+class Histogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 40;
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot
+    {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        std::vector<uint64_t> quantiles; // same order as the requested ones
+    };
+
+    Histogram() = default;
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void Record(uint64_t value)
+    {
+        counts_[Index(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    /// Read the counters and compute the quantiles (0..1). Concurrent records may or
+    /// may not be included, the snapshot is not atomic as a whole.
+    Snapshot Read(std::initializer_list<double> quantiles) const
+    {
+        Snapshot snapshot;
+        std::array<uint64_t, BUCKETS> counts;
+        uint64_t total = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            counts[i] = counts_[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        snapshot.count = total;
+        snapshot.sum = sum_.load(std::memory_order_relaxed);
+        snapshot.max = max_.load(std::memory_order_relaxed);
+
+        for (double quantile : quantiles) {
+            // the value below which the requested fraction of the records fall, highest equivalent value
+            uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total) + 0.5);
+            rank = std::clamp<uint64_t>(rank, 1, std::max<uint64_t>(total, 1));
+            uint64_t seen = 0;
+            uint64_t value = 0;
+            for (size_t i = 0; i < BUCKETS && total > 0; i++) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    value = std::min(UpperBound(i), snapshot.max);
+                    break;
+                }
+            }
+            snapshot.quantiles.push_back(value);
+        }
+        return snapshot;
+    }
+
+    static size_t Index(uint64_t value)
+    {
+        if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+        value = std::min<uint64_t>(value, (uint64_t(1) << MAX_EXPONENT) - 1);
+        int exponent = std::bit_width(value) - 1;
+        uint64_t sub = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>(exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + static_cast<size_t>(sub);
+    }
+
+    static uint64_t LowerBound(size_t index)
+    {
+        if (index < SUB_BUCKETS) return index;
+        int exponent = static_cast<int>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+        uint64_t sub = index % SUB_BUCKETS;
+        return (SUB_BUCKETS + sub) << (exponent - SUB_BUCKET_BITS);
+    }
+
+    static uint64_t UpperBound(size_t index)
+    {
+        return index + 1 < BUCKETS ? LowerBound(index + 1) - 1 : (uint64_t(1) << MAX_EXPONENT) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+#endif //MCP_SERVER_HISTOGRAM_H
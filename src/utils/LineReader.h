@@ -0,0 +1,138 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef MCP_SERVER_LINEREADER_H
+#define MCP_SERVER_LINEREADER_H
+
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/// Newline delimited reader over a file descriptor.
+/// Data is read in large blocks into one reusable buffer and lines are found
+/// with memchr. Next() hands out views into the buffer, so in the steady state
+/// reading a message does not allocate; the buffer only grows for a line
+/// longer than its current size.
+class LineReader
+{
+public:
+    explicit LineReader(int fd, size_t capacity = 64 * 1024)
+        : fd_(fd), buffer_(capacity == 0 ? 4096 : capacity)
+    {
+    }
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    enum class Status { Line, WouldBlock, End };
+
+    /// Get the next line, without the trailing "\n" or "\r\n".
+    /// The view is valid until the next call. Returns false at end of input.
+    /// For a blocking descriptor only; see Poll() for a non-blocking one.
+    bool Next(std::string_view& line)
+    {
+        return Poll(line) == Status::Line;
+    }
+
+    /// Like Next(), but reports WouldBlock when a non-blocking descriptor has no complete line yet
+    Status Poll(std::string_view& line)
+    {
+        while (true) {
+            // scan only the bytes not looked at yet
+            const char* base = buffer_.data();
+            const char* found = static_cast<const char*>(memchr(base + scan_, '\n', end_ - scan_));
+            if (found) {
+                size_t length = found - (base + begin_);
+                if (length > 0 && base[begin_ + length - 1] == '\r') length--;
+                line = std::string_view(base + begin_, length);
+                begin_ = scan_ = found - base + 1;
+                return Status::Line;
+            }
+            scan_ = end_;
+
+            if (eof_) {
+                if (begin_ == end_) return Status::End;
+                // last line without a terminating newline
+                line = std::string_view(base + begin_, end_ - begin_);
+                begin_ = scan_ = end_;
+                return Status::Line;
+            }
+
+            if (!Fill()) return Status::WouldBlock;
+        }
+    }
+
+    /// Bytes read from the descriptor and not consumed yet
+    size_t Buffered() const { return end_ - begin_; }
+
+private:
+    // Read more data, false if the descriptor has none available right now
+    bool Fill()
+    {
+        // move the partial line to the front, grow only if it fills the whole buffer
+        if (begin_ > 0) {
+            memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            scan_ -= begin_;
+            begin_ = 0;
+        }
+        if (end_ == buffer_.size()) {
+            buffer_.resize(buffer_.size() * 2);
+        }
+
+        while (true) {
+#ifdef _WIN32
+            int count = _read(fd_, buffer_.data() + end_, static_cast<unsigned int>(buffer_.size() - end_));
+#else
+            ssize_t count = read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+#endif
+            if (count > 0) {
+                end_ += static_cast<size_t>(count);
+                return true;
+            }
+            if (count < 0 && errno == EINTR) continue;
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+            // end of input, or an error we cannot recover from
+            eof_ = true;
+            return true;
+        }
+    }
+
+    int fd_;
+    std::vector<char> buffer_;
+    size_t begin_ = 0;  // start of the unconsumed data
+    size_t scan_ = 0;   // bytes before this offset hold no newline
+    size_t end_ = 0;    // end of the valid data
+    bool eof_ = false;
+};
+
+#endif //MCP_SERVER_LINEREADER_H
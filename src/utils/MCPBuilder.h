@@ -25,6 +25,7 @@
 #ifndef MCP_SERVER_MCPBUILDER_H
 #define MCP_SERVER_MCPBUILDER_H
 
+#include <string_view>
 #include "json.hpp"
 #include "base64.hpp"
 
@@ -39,7 +40,10 @@ public:
         InvalidRequest = -32600,
         MethodNotFound = -32601,
         InvalidParams = -32602,
-        InternalError = -32603
+        InternalError = -32603,
+        RequestTimeout = -32001,    // the deadline of the request passed
+        ServerBusy = -32002,        // the request queue is full, the request was not run
+        RequestCancelled = -32800   // the client sent notifications/cancelled for it
     };
 
     static json Response(json request) {
@@ -50,6 +54,17 @@ public:
         return response;
     }
 
+    // Builds a response around an already serialized "result" object, only the id is serialized here
+    static std::string RawResponse(const json& id, std::string_view result) {
+        std::string idText = id.dump();
+        std::string response;
+        response.reserve(result.size() + idText.size() + 36);
+        response.append(R"({"jsonrpc":"2.0","id":)").append(idText);
+        response.append(R"(,"result":)").append(result);
+        response.push_back('}');
+        return response;
+    }
+
     static json Error(ErrorCode code, const std::string& id, const std::string &message) {
         return {
                 {"jsonrpc", "2.0"},
@@ -58,6 +73,15 @@ public:
         };
     }
 
+    // JSON-RPC ids may be numbers or strings, keep them as they were received
+    static json Error(ErrorCode code, const json& id, const std::string &message) {
+        return {
+                {"jsonrpc", "2.0"},
+                {"error", {{"code", code}, {"message", message}}},
+                {"id", id}
+        };
+    }
+
     static json TextContent(const std::string& text) {
         return json::object({
             {"type","text"},
@@ -99,6 +123,14 @@ public:
         });
     }
 
+    // notifications/<list>/list_changed, list is "tools", "prompts" or "resources"
+    static json NotificationListChanged(const std::string& list) {
+        return json::object({
+            {"jsonrpc", "2.0"},
+            {"method", "notifications/" + list + "/list_changed"}
+        });
+    }
+
     static json NotificationProgress(const std::string& message, const std::string& progressToken, const int progress, const int total) {
         return json::object({
             {"jsonrpc", "2.0"},
@@ -0,0 +1,165 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef MCP_SERVER_TASK_H
+#define MCP_SERVER_TASK_H
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/// Minimal lazy coroutine type.
+/// A Task starts when it is awaited, or with Start() for a top level coroutine,
+/// and resumes its awaiter when it completes. The Task object owns the frame.
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+    struct TaskPromiseBase
+    {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+        // set by whichever of the awaiter suspending and the task finishing comes second
+        std::atomic<bool> ready{false};
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                // finished inside the awaiter's await_suspend: it carries on by itself
+                auto& promise = handle.promise();
+                if (!promise.ready.exchange(true) || !promise.continuation) return std::noop_coroutine();
+                return promise.continuation;
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase
+    {
+        std::optional<T> value;
+
+        Task<T> get_return_object();
+        void return_value(T result) { value.emplace(std::move(result)); }
+
+        T Result()
+        {
+            if (exception) std::rethrow_exception(exception);
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase
+    {
+        Task<void> get_return_object();
+        void return_void() {}
+
+        void Result()
+        {
+            if (exception) std::rethrow_exception(exception);
+        }
+    };
+
+}
+
+template <typename T>
+class Task
+{
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+    // The task runs inline and the awaiter only suspends if it did not complete. A loop of
+    // synchronously completing awaits does not grow the stack, which symmetric transfer only
+    // guarantees when the compiler turns it into a tail call.
+    bool await_suspend(std::coroutine_handle<> awaiter)
+    {
+        handle_.promise().continuation = awaiter;
+        handle_.resume();
+        return !handle_.promise().ready.exchange(true);
+    }
+    T await_resume() { return handle_.promise().Result(); }
+
+    /// Run a top level task until its first suspension point
+    void Start()
+    {
+        if (handle_ && !handle_.done()) handle_.resume();
+    }
+
+    bool Done() const { return !handle_ || handle_.done(); }
+
+private:
+    Handle handle_ = nullptr;
+};
+
+namespace detail {
+
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object()
+    {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object()
+    {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+
+}
+
+#endif //MCP_SERVER_TASK_H
@@ -0,0 +1,140 @@
+//  The MIT License
+//
+//  Copyright (C) 2025 Giuseppe Mastrangelo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  'Software'), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef MCP_SERVER_THREADPOOL_H
+#define MCP_SERVER_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Fixed size worker pool with a bounded task queue.
+/// Submit() blocks the producer while the queue is full, so a fast reader
+/// cannot grow the backlog without limit (back-pressure on the transport).
+/// TrySubmit() refuses the task instead, for producers that must keep reading.
+class ThreadPool
+{
+public:
+    ThreadPool(size_t threads, size_t maxQueue)
+        : maxQueue_(maxQueue == 0 ? 1 : maxQueue)
+    {
+        if (threads == 0) threads = 1;
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        Shutdown();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Queue a task. Returns false if the pool is shutting down.
+    bool Submit(std::function<void()> task)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.wait(lock, [this] { return stopping_ || tasks_.size() < maxQueue_; });
+            if (stopping_) return false;
+            tasks_.push_back(std::move(task));
+        }
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /// Queue a task unless the queue is full. Returns false if it is, or if the pool is shutting down.
+    bool TrySubmit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_ || tasks_.size() >= maxQueue_) return false;
+            tasks_.push_back(std::move(task));
+        }
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /// Drain the queued tasks and join all workers.
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_ && workers_.empty()) return;
+            stopping_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker.joinable() && worker.get_id() != std::this_thread::get_id()) {
+                worker.join();
+            } else if (worker.joinable()) {
+                worker.detach();
+            }
+        }
+        workers_.clear();
+    }
+
+    size_t Size() const { return workers_.size(); }
+
+    size_t Pending()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tasks_.size();
+    }
+
+private:
+    void WorkerLoop()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                notEmpty_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) return; // stopping and fully drained
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            notFull_.notify_one();
+            task();
+        }
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    size_t maxQueue_;
+    bool stopping_ = false;
+};
+
+#endif //MCP_SERVER_THREADPOOL_H
@@ -0,0 +1,296 @@
+#  The MIT License
+#
+#  Copyright (C) 2025 Giuseppe Mastrangelo
+#
+#  Permission is hereby granted, free of charge, to any person obtaining
+#  a copy of this software and associated documentation files (the
+#  'Software'), to deal in the Software without restriction, including
+#  without limitation the rights to use, copy, modify, merge, publish,
+#  distribute, sublicense, and/or sell copies of the Software, and to
+#  permit persons to whom the Software is furnished to do so, subject to
+#  the following conditions:
+#
+#  The above copyright notice and this permission notice shall be
+#  included in all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+#  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+#  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+#  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+#  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+#  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Scripted runs of the server over stdio against the mock IGCL driver (mock/control_lib),
+# Linux / macOS only. Only needs the standard library:
+#
+#   python3 test/test-mock.py --server build/server_igcl_poc --plugins build/plugins [name ...]
+#
+# Every run starts its own server on a copy of the plugins directory; the mock driver is
+# configured through its IGCL_MOCK_* environment variables. Exits with 1 if any run fails.
+
+import argparse
+import json
+import os
+import queue
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+RESPONSE_TIMEOUT = 20
+
+
+class Server:
+    def __init__(self, args, plugins, extra=(), env=None):
+        self.logs = tempfile.mkdtemp(prefix="mcp-logs-")
+        environment = dict(os.environ, IGCL_MOCK_DEVICES="2")
+        environment.update(env or {})
+        self.process = subprocess.Popen([args.server, "-p", plugins, "-l", self.logs] + list(extra),
+                                        stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                                        env=environment, text=True, bufsize=1)
+        self.messages = queue.Queue()
+        self.reader = threading.Thread(target=self._read, daemon=True)
+        self.reader.start()
+
+    def _read(self):
+        while True:
+            line = self.process.stdout.readline()
+            if not line:
+                return
+            self.messages.put(json.loads(line))
+
+    def send(self, message):
+        self.process.stdin.write(json.dumps(message) + "\n")
+        self.process.stdin.flush()
+
+    def call(self, id, name, arguments=None):
+        self.send({"jsonrpc": "2.0", "id": id, "method": "tools/call",
+                   "params": {"name": name, "arguments": arguments or {}}})
+
+    # Next message matching accept, the others are dropped
+    def receive(self, accept, timeout=RESPONSE_TIMEOUT):
+        end = time.time() + timeout
+        while True:
+            message = self.messages.get(timeout=max(0.0, end - time.time()))
+            if accept(message):
+                return message
+
+    def response(self, id, timeout=RESPONSE_TIMEOUT):
+        return self.receive(lambda message: isinstance(message, dict) and message.get("id") == id, timeout)
+
+    def request(self, id, name, arguments=None):
+        self.call(id, name, arguments)
+        return self.response(id)
+
+    def tools(self):
+        self.send({"jsonrpc": "2.0", "id": "list", "method": "tools/list"})
+        return [tool["name"] for tool in self.response("list")["result"]["tools"]]
+
+    def children(self):
+        found = subprocess.run(["pgrep", "-P", str(self.process.pid)], capture_output=True, text=True)
+        return found.stdout.split()
+
+    def close(self):
+        self.process.stdin.close()
+        try:
+            self.process.wait(timeout=RESPONSE_TIMEOUT)
+        except subprocess.TimeoutExpired:
+            self.process.kill()
+            self.process.wait()
+        shutil.rmtree(self.logs, ignore_errors=True)
+
+
+def succeeded(response):
+    return "result" in response and not response["result"].get("isError")
+
+
+def error_code(response):
+    return response.get("error", {}).get("code")
+
+
+def check(condition, message):
+    if not condition:
+        raise AssertionError(message)
+
+
+def test_cancel_and_timeout(args, plugins):
+    # every driver call of the 3D features takes 400 ms
+    server = Server(args, plugins, ["-w", "2", "--tool-timeout", "get_3d_features=300"],
+                    {"IGCL_MOCK_LATENCY_US": "ctlGetSet3DFeature:400000"})
+    try:
+        start = time.time()
+        server.call(1, "set_frame_sync", {"mode": 1})
+        time.sleep(0.1)
+        server.send({"jsonrpc": "2.0", "method": "notifications/cancelled", "params": {"requestId": 1, "reason": "test"}})
+        response = server.response(1)
+        check(error_code(response) == -32800, "cancelled call answered with %s" % response)
+        check(time.time() - start < 0.4, "cancel answered after the driver call returned")
+
+        response = server.request(2, "get_3d_features")
+        check(error_code(response) == -32001, "timed out call answered with %s" % response)
+
+        # the workers are free again for the other tools
+        check(succeeded(server.request(3, "get_3d_capabilities")), "call after the cancel and the timeout failed")
+    finally:
+        server.close()
+
+
+def test_queue_full(args, plugins):
+    # one worker and one queue slot, both taken by calls of 3 s
+    server = Server(args, plugins, ["-w", "1", "-q", "1"], {"IGCL_MOCK_DEVICES": "1", "IGCL_MOCK_LATENCY_US": "ctlGetSet3DFeature:3000000"})
+    try:
+        start = time.time()
+        for id in (1, 2, 3):
+            server.call(id, "set_frame_sync", {"mode": 1})
+        response = server.response(3)
+        check(error_code(response) == -32002, "call past the full queue answered with %s" % response)
+
+        # the reader is not stuck behind the queue, the queued call is cancelled at once
+        server.send({"jsonrpc": "2.0", "method": "notifications/cancelled", "params": {"requestId": 2, "reason": "test"}})
+        response = server.response(2)
+        check(error_code(response) == -32800, "queued call cancelled with %s" % response)
+        check(time.time() - start < 1.0, "full queue answered after a worker was free")
+    finally:
+        server.close()
+
+
+def test_isolate_crash_restart(args, plugins):
+    server = Server(args, plugins, ["--isolate"])
+    try:
+        check(succeeded(server.request(1, "get_3d_capabilities")), "first isolated call failed")
+        children = server.children()
+        check(children, "no plugin host child running")
+        for child in children:
+            os.kill(int(child), signal.SIGKILL)
+
+        # the call racing the crash may fail, the child is back after its restart backoff
+        restarted = False
+        for id in range(2, 52):
+            if succeeded(server.request(id, "get_3d_capabilities")):
+                restarted = True
+                break
+            time.sleep(0.1)
+        check(restarted, "plugin host child not restarted")
+        check(not set(children) & set(server.children()), "killed children still listed")
+    finally:
+        server.close()
+
+
+def test_set_3d_features_rollback(args, plugins):
+    features = [{"feature": "frame_sync", "value": 1}, {"feature": "anisotropic", "value": 2},
+                {"feature": "sharpening_filter", "value": True}]
+    rolled_back = False
+    for seed in range(1, 41):
+        server = Server(args, plugins, [], {"IGCL_MOCK_FAIL": "ctlGetSet3DFeature:0.3", "IGCL_MOCK_SEED": str(seed)})
+        try:
+            response = server.request(1, "set_3d_features", {"features": features, "parallel": False})
+        finally:
+            server.close()
+        check("result" in response, "set_3d_features answered with %s" % response)
+        result = response["result"]["structuredContent"]
+        statuses = [device["status"] for feature in result["features"] for device in feature["devices"]]
+        if result["applied"]:
+            check(set(statuses) == {"applied"}, "applied with statuses %s" % statuses)
+            continue
+        check(response["result"]["isError"], "failed set_3d_features not reported as an error")
+        check("applied" not in statuses, "a change stayed applied after a failure: %s" % statuses)
+        check(len(result["restoreFailed"]) == statuses.count("rollback_failed"), "restoreFailed does not match the statuses")
+        check(result["rolledBack"] == (not result["restoreFailed"]), "rolledBack set with changes left unrestored")
+        rolled_back = rolled_back or result["rolledBack"]
+    check(rolled_back, "no seed rolled back a failed change")
+
+    server = Server(args, plugins)
+    try:
+        response = server.request(2, "set_3d_features", {"features": [{"feature": "endurance_gaming", "value": {"control": 7, "mode": 0}}]})
+        check(error_code(response) == -32602, "invalid endurance_gaming value answered with %s" % response)
+
+        # every tool rejects its arguments the same way
+        for id, name, arguments in ((3, "set_frame_sync", {"mode": 1, "devices": [5]}), (4, "get_3d_features", {"devices": [5]}),
+                                    (5, "set_anisotropic", {"mode": 9}), (6, "set_endurance_gaming", {"control": 1})):
+            response = server.request(id, name, arguments)
+            check(error_code(response) == -32602, "invalid %s arguments answered with %s" % (name, response))
+    finally:
+        server.close()
+
+
+def test_hot_reload_list_changed(args, plugins):
+    server = Server(args, plugins, ["--watch"])
+    list_changed = lambda message: message.get("method") == "notifications/tools/list_changed"
+    try:
+        check("get_3d_features" in server.tools(), "get_3d_features not listed")
+        removed = os.path.join(tempfile.mkdtemp(prefix="mcp-removed-"), "get_3d_features")
+        shutil.move(os.path.join(plugins, "get_3d_features"), removed)
+        server.receive(list_changed)
+        check("get_3d_features" not in server.tools(), "get_3d_features still listed after its removal")
+
+        shutil.move(removed, os.path.join(plugins, "get_3d_features"))
+        os.rmdir(os.path.dirname(removed))
+        server.receive(list_changed)
+        check("get_3d_features" in server.tools(), "get_3d_features not listed again")
+        check(succeeded(server.request(1, "get_3d_features")), "call to the reloaded plugin failed")
+    finally:
+        server.close()
+
+
+def test_batch(args, plugins):
+    server = Server(args, plugins)
+    try:
+        server.send([{"jsonrpc": "2.0", "id": 1, "method": "tools/call", "params": {"name": "get_3d_capabilities", "arguments": {}}},
+                     {"jsonrpc": "2.0", "method": "notifications/initialized"},
+                     {"jsonrpc": "2.0", "id": 2, "method": "unknown/method"},
+                     {"jsonrpc": "2.0", "id": 3, "method": "tools/list"}])
+        responses = server.receive(lambda message: isinstance(message, list))
+        by_id = {response["id"]: response for response in responses}
+        check(sorted(by_id) == [1, 2, 3], "batch answered with ids %s" % sorted(by_id))
+        check(succeeded(by_id[1]), "tools/call in a batch failed")
+        check(error_code(by_id[2]) == -32601, "unknown method in a batch answered with %s" % by_id[2])
+        check("tools" in by_id[3]["result"], "tools/list in a batch answered with %s" % by_id[3])
+
+        server.send([])
+        response = server.receive(lambda message: isinstance(message, dict) and "error" in message)
+        check(error_code(response) == -32600, "empty batch answered with %s" % response)
+    finally:
+        server.close()
+
+
+TESTS = {
+    "cancel_and_timeout": test_cancel_and_timeout,
+    "queue_full": test_queue_full,
+    "isolate_crash_restart": test_isolate_crash_restart,
+    "set_3d_features_rollback": test_set_3d_features_rollback,
+    "hot_reload_list_changed": test_hot_reload_list_changed,
+    "batch": test_batch,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Scripted runs of the server against the mock IGCL driver")
+    parser.add_argument("--server", required=True, help="the server_igcl_poc executable")
+    parser.add_argument("--plugins", required=True, help="the plugins directory of the build")
+    parser.add_argument("tests", nargs="*", help="runs to do, all of them by default: " + ", ".join(TESTS))
+    args = parser.parse_args()
+
+    failed = 0
+    for name in args.tests or TESTS:
+        # manifests and hot reload change the plugins directory, every run gets a fresh copy
+        plugins = tempfile.mkdtemp(prefix="mcp-plugins-")
+        shutil.copytree(args.plugins, plugins, dirs_exist_ok=True,
+                        ignore=shutil.ignore_patterns("*.manifest.json", ".plugins.cache", "CMakeFiles"))
+        start = time.time()
+        try:
+            TESTS[name](args, plugins)
+            print("PASS %s (%.1f s)" % (name, time.time() - start))
+        except (AssertionError, queue.Empty) as e:
+            failed += 1
+            print("FAIL %s: %s" % (name, e or "no response"))
+        finally:
+            shutil.rmtree(plugins, ignore_errors=True)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())